@@ -8,4 +8,11 @@ set (THIRDPARTY_DOWNLOAD_ROOT "${THIRDPARTY_ROOT}/download" CACHE INTERNAL "")
 set (THIRDPARTY_INSTALL_ROOT "${THIRDPARTY_ROOT}/install" CACHE INTERNAL "")
 
 include(${CMAKE_CURRENT_SOURCE_DIR}/3rdParty/Boost.cmake)
-include(${CMAKE_CURRENT_SOURCE_DIR}/3rdParty/Qt5.cmake)
+if (MICBRIDGE_BUILD_GUI)
+    include(${CMAKE_CURRENT_SOURCE_DIR}/3rdParty/Qt5.cmake)
+endif()
+
+option(MICBRIDGE_WITH_FDK_AAC "Build the portable AAC decoder on top of fdk-aac" ON)
+if (MICBRIDGE_WITH_FDK_AAC)
+    include(${CMAKE_CURRENT_SOURCE_DIR}/3rdParty/FdkAac.cmake)
+endif()
@@ -0,0 +1,23 @@
+message(STATUS "Preparing fdk-aac...")
+
+include(FetchContent)
+
+set(FDK_AAC_ROOT ${THIRDPARTY_INSTALL_ROOT}/fdk-aac/)
+
+set(BUILD_SHARED_LIBS_SAVED ${BUILD_SHARED_LIBS})
+set(BUILD_SHARED_LIBS OFF)
+set(BUILD_PROGRAMS OFF CACHE BOOL "" FORCE)
+
+fetchcontent_declare(
+    fdk-aac
+    EXCLUDE_FROM_ALL
+    GIT_REPOSITORY https://github.com/mstorsjo/fdk-aac.git
+    GIT_TAG        v2.0.3
+    GIT_SHALLOW    TRUE
+    SOURCE_DIR     ${FDK_AAC_ROOT})
+
+fetchcontent_makeavailable(fdk-aac)
+
+set(BUILD_SHARED_LIBS ${BUILD_SHARED_LIBS_SAVED})
+
+message(STATUS "Preparing fdk-aac finished.")
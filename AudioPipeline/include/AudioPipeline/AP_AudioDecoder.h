@@ -0,0 +1,58 @@
+#pragma once
+
+#include "AudioPipeline/AP_SampleFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace AudioPipeline
+{
+struct DecoderConfig
+{
+  std::uint32_t sampleRate = 0;
+  std::uint32_t channelsCount = 0;
+  // Codec specific configuration, e.g. the AAC AudioSpecificConfig.
+  std::vector<std::uint8_t> codecConfig;
+};
+
+// Interleaved PCM produced by a decoder. It points into the decoder's own
+// output buffer and stays valid until the next decode() or reset().
+struct DecodedAudio
+{
+  const std::uint8_t* data = nullptr;
+  std::size_t size = 0;
+  SampleFormat format = SampleFormat::S16LE;
+  std::uint32_t sampleRate = 0;
+  std::uint32_t channelsCount = 0;
+};
+
+// Turns compressed access units into PCM. Decoders reuse their output
+// storage, decoding a frame does not allocate.
+class AudioDecoder
+{
+public:
+  virtual ~AudioDecoder() = default;
+
+  // Returns false when the frame could not be decoded; the decoder stays
+  // usable for the following frames.
+  virtual bool decode(const std::uint8_t* data, std::size_t size, DecodedAudio& output) = 0;
+
+  // Produces one frame of the codec's own loss concealment in place of a
+  // missing one. Returns false when the codec has none.
+  virtual bool conceal(DecodedAudio& /*output*/) { return false; }
+  virtual void reset() = 0;
+};
+using AudioDecoderPtr = std::unique_ptr<AudioDecoder>;
+
+// AAC (LC, HE, HEv2) raw access units as carried by RFC 3640 AAC-hbr.
+// Returns nullptr when the configuration is not usable or the library was
+// built without an AAC implementation.
+AudioDecoderPtr createAacDecoder(const DecoderConfig& config);
+
+// AudioSpecificConfig for streams that do not announce one.
+std::vector<std::uint8_t> makeAacAudioSpecificConfig(std::uint8_t audioObjectType,
+                                                     std::uint32_t sampleRate,
+                                                     std::uint32_t channelsCount);
+} // namespace AudioPipeline
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "AudioPipeline/AP_SampleFormat.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace AudioPipeline
+{
+struct PcmFormat
+{
+  SampleFormat sampleFormat = SampleFormat::S16LE;
+  std::uint32_t sampleRate = 0;
+  std::uint32_t channelsCount = 0;
+
+  std::size_t bytesPerFrame() const { return bytesPerSample(sampleFormat) * channelsCount; }
+
+  bool operator==(const PcmFormat&) const = default;
+};
+
+struct AudioSinkStats
+{
+  std::uint64_t periodsWritten = 0;
+  // Periods the backend could not take, e.g. a FIFO without a reader.
+  std::uint64_t periodsDropped = 0;
+  std::uint64_t bytesWritten = 0;
+};
+
+// Destination of decoded PCM. All calls come from a single thread, the one
+// frames are delivered on.
+class AudioSink
+{
+public:
+  virtual ~AudioSink() = default;
+
+  virtual bool start(const PcmFormat& format) = 0;
+  virtual void write(const std::uint8_t* data, std::size_t size) = 0;
+  virtual void stop() = 0;
+
+  // Audio the producer found to be silence, e.g. by voice activity
+  // detection. Sinks with a cheaper path for it override this; the others
+  // take it as any audio.
+  virtual void writeSilence(const std::uint8_t* data, std::size_t size) { write(data, size); }
+
+  // Frames written but not played yet, or -1 when the backend cannot tell.
+  virtual std::int64_t bufferedFrames() const { return -1; }
+
+  // Safe to call from any thread.
+  virtual AudioSinkStats stats() const = 0;
+};
+using AudioSinkPtr = std::shared_ptr<AudioSink>;
+
+// Regroups whatever the producer writes into fixed periods of audio and
+// hands complete periods to the backend, so the backend sees one call per
+// period regardless of the network frame size.
+class PeriodicAudioSink : public AudioSink
+{
+public:
+  explicit PeriodicAudioSink(std::chrono::microseconds period);
+
+  bool start(const PcmFormat& format) override;
+  void write(const std::uint8_t* data, std::size_t size) override;
+  void writeSilence(const std::uint8_t* data, std::size_t size) override;
+  void stop() override;
+
+  std::int64_t bufferedFrames() const override;
+  AudioSinkStats stats() const override;
+
+protected:
+  virtual bool openBackend(const PcmFormat& format) = 0;
+  // Returns false when the period was dropped.
+  virtual bool writePeriod(const std::uint8_t* data, std::size_t size) = 0;
+  // A period made of silence only; written as any period unless overridden.
+  virtual bool writeSilentPeriod(const std::uint8_t* data, std::size_t size) { return writePeriod(data, size); }
+  virtual void closeBackend() = 0;
+  // Bytes handed to the backend and not played yet, or -1 when unknown.
+  virtual std::int64_t backendBufferedBytes() const { return -1; }
+
+  std::size_t periodSize() const { return period_.size(); }
+
+private:
+  void append(const std::uint8_t* data, std::size_t size, bool isSilent);
+  void flushPeriod(const std::uint8_t* data, std::size_t size, bool isSilent);
+
+private:
+  const std::chrono::microseconds periodDuration_;
+
+  std::vector<std::uint8_t> period_;
+  std::size_t periodFill_ = 0;
+  // Whether everything in the period so far was written as silence.
+  bool isPeriodSilent_ = false;
+  std::size_t frameBytes_ = 0;
+  bool started_ = false;
+
+  std::atomic<std::uint64_t> periodsWritten_ = 0;
+  std::atomic<std::uint64_t> periodsDropped_ = 0;
+  std::atomic<std::uint64_t> bytesWritten_ = 0;
+};
+
+// POSIX only. Writes to a named pipe, or to a regular file that is created
+// when missing. A FIFO without a reader drops periods until one connects.
+// Processes using it should ignore SIGPIPE, a reader going away then only
+// drops periods as well.
+AudioSinkPtr createFileAudioSink(const std::string& path, std::chrono::microseconds period);
+} // namespace AudioPipeline
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "AudioPipeline/AP_AudioSink.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace AudioPipeline
+{
+class AsyncResampler;
+
+struct DriftCompensationOptions
+{
+  // Audio to keep buffered in the downstream sink. Zero holds the level the
+  // sink settles at during the warm-up.
+  std::chrono::microseconds targetDelay{0};
+  std::chrono::milliseconds warmUp{2000};
+  // Bound of the resampling correction; consumer clocks are usually within
+  // a few hundred ppm of each other.
+  std::uint32_t maxCorrectionPpm = 1000;
+  // Correction per second of buffer error, the integral gain follows for
+  // critical damping. The default settles within about a minute, which is
+  // enough for drift between two clocks of the same kind; a higher gain
+  // catches larger drift before the buffer runs away, at the cost of
+  // following more of the buffer's jitter.
+  double proportionalGain = 0.05;
+};
+
+struct DriftStats
+{
+  // Rate the downstream device plays at relative to the rate audio comes in
+  // at, i.e. the rate the RTP timestamps advance at, in parts per million.
+  // Positive when the device is faster. Measured over the whole stream once
+  // it has run for a few seconds.
+  std::int32_t driftPpm = 0;
+  // Correction currently applied by the resampler.
+  std::int32_t correctionPpm = 0;
+
+  // Audio buffered downstream, smoothed, and the level it is held at.
+  std::uint32_t bufferedUs = 0;
+  std::uint32_t targetUs = 0;
+
+  // False when the downstream sink cannot tell how much it buffers, or the
+  // format is not 16-bit host order PCM; audio then passes through.
+  bool isCompensating = false;
+};
+
+// Keeps the audio buffered in a sink that is played by a local clock, e.g.
+// the virtual microphone, pinned near a target while the stream comes in at
+// the phone's clock. The buffer level drives a PI controller whose output
+// is the ratio of a fine-grained resampler placed in front of the sink, so
+// neither latency builds up nor the device starves over long sessions.
+// Silence is not resampled, it goes out as zeros of the resampled length;
+// audio after it starts the resampler afresh, so the tail of what came
+// before the silence is not played into it.
+class DriftCompensator final : public AudioSink
+{
+public:
+  DriftCompensator(AudioSinkPtr downstream, const DriftCompensationOptions& options);
+  ~DriftCompensator() override;
+
+  bool start(const PcmFormat& format) override;
+  void write(const std::uint8_t* data, std::size_t size) override;
+  void writeSilence(const std::uint8_t* data, std::size_t size) override;
+  void stop() override;
+
+  std::int64_t bufferedFrames() const override;
+  AudioSinkStats stats() const override;
+
+  // Safe to call from any thread.
+  DriftStats driftStats() const;
+
+private:
+  void updateRatio(std::size_t framesCount);
+
+private:
+  const AudioSinkPtr downstream_;
+  const DriftCompensationOptions options_;
+
+  std::unique_ptr<AsyncResampler> resampler_;
+  std::vector<std::int16_t> output_;
+  // Output frames per input frame currently applied, and the fraction of
+  // a frame of silence not written yet.
+  double ratio_ = 1.;
+  double pendingSilence_ = 0.;
+  // Whether the last write was silence, which left the resampler holding
+  // audio from before it.
+  bool isSilent_ = false;
+
+  PcmFormat format_;
+  bool isCompensating_ = false;
+
+  // Totals since start(), in frames.
+  std::uint64_t inputFrames_ = 0;
+  std::uint64_t outputFrames_ = 0;
+
+  bool hasBuffered_ = false;
+  double smoothedBufferedFrames_ = 0.;
+
+  bool isLocked_ = false;
+  double targetFrames_ = 0.;
+  double integral_ = 0.;
+  std::uint64_t baselineInputFrames_ = 0;
+  double baselinePlayedFrames_ = 0.;
+
+  std::atomic<std::int32_t> driftPpm_ = 0;
+  std::atomic<std::int32_t> correctionPpm_ = 0;
+  std::atomic<std::uint32_t> bufferedUs_ = 0;
+  std::atomic<std::uint32_t> targetUs_ = 0;
+  std::atomic_bool isCompensatingStat_ = false;
+};
+} // namespace AudioPipeline
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "AudioPipeline/AP_LevelMeter.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace AudioPipeline
+{
+struct LevelSnapshot
+{
+  float peak = 0.f;
+  float rms = 0.f;
+  // Bumped on every publish, lets readers tell a fresh window from a stale one.
+  std::uint32_t sequence = 0;
+};
+
+// Meters audio on the thread that produces it and publishes the levels of
+// fixed windows of stream time, e.g. 30 per second. Publishing is a couple
+// of atomic stores, readers on any thread only ever load the latest
+// snapshot; nothing is queued between the two sides.
+class LevelAccumulator final
+{
+public:
+  LevelAccumulator(SampleFormat format,
+                   std::uint32_t sampleRate,
+                   std::uint32_t channelsCount,
+                   std::uint32_t publishRateHz);
+
+  // Producer thread only.
+  void accumulate(const void* data, std::size_t bytes);
+  // Counts audio known to be silence as zero level without metering it.
+  void accumulateSilence(std::size_t bytes);
+
+  // Safe to call from any thread.
+  void setPublishRate(std::uint32_t publishRateHz);
+  LevelSnapshot snapshot() const;
+  std::uint64_t clippedCount() const { return clippedCount_.load(std::memory_order_relaxed); }
+
+private:
+  void publish();
+
+private:
+  const LevelMeter meter_;
+  const std::uint64_t samplesPerSecond_;
+
+  LevelStats window_;
+  std::atomic<std::uint64_t> windowSamples_ = 0;
+
+  // Peak and RMS bit patterns packed together so they are read as one.
+  std::atomic<std::uint64_t> levels_ = 0;
+  std::atomic<std::uint32_t> sequence_ = 0;
+  std::atomic<std::uint64_t> clippedCount_ = 0;
+};
+} // namespace AudioPipeline
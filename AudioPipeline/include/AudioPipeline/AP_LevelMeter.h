@@ -0,0 +1,47 @@
+#pragma once
+
+#include "AudioPipeline/AP_SampleFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace AudioPipeline
+{
+// Raw level accumulators, kept in sample units so that measurements of
+// consecutive buffers can be merged before being normalized.
+struct LevelStats
+{
+  std::uint32_t peak = 0;
+  std::uint64_t sumOfSquares = 0;
+  // Samples sitting at the most positive or most negative value.
+  std::uint64_t clippedCount = 0;
+  std::uint64_t samplesCount = 0;
+
+  void merge(const LevelStats& other);
+};
+
+// Peak, RMS and clip metering of interleaved PCM in a single pass. The
+// format is fixed at construction, which selects a kernel specialized for it
+// and for the widest instruction set the CPU supports.
+class LevelMeter final
+{
+public:
+  explicit LevelMeter(SampleFormat format);
+
+  SampleFormat format() const { return format_; }
+
+  // Channels are not told apart. A trailing partial sample is ignored.
+  void accumulate(const void* data, std::size_t bytes, LevelStats& stats) const;
+  LevelStats measure(const void* data, std::size_t bytes) const;
+
+  // Both are normalized to [0, 1] of the format's full scale.
+  float peakLevel(const LevelStats& stats) const;
+  float rmsLevel(const LevelStats& stats) const;
+
+private:
+  using Kernel = void (*)(const std::uint8_t* data, std::size_t samplesCount, LevelStats& stats);
+
+  SampleFormat format_;
+  Kernel kernel_;
+};
+} // namespace AudioPipeline
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "AudioPipeline/AP_AudioDecoder.h"
+#include "AudioPipeline/AP_AudioSink.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace AudioPipeline
+{
+struct ConcealmentStats
+{
+  // Packets never received, and the gaps they left.
+  std::uint64_t lostPackets = 0;
+  std::uint64_t concealmentEvents = 0;
+  // Frames (samples per channel) synthesized in place of lost audio.
+  std::uint64_t concealedFrames = 0;
+  // Packets that arrived after their place in the stream had been played.
+  std::uint64_t discardedPackets = 0;
+};
+
+// Keeps the PCM of a stream sample-continuous across lost RTP packets. Gaps
+// are found from RTP sequence numbers and their length from RTP timestamps;
+// they are filled by the codec's own concealment when one is set, or by
+// repeating the last pitch period of the output with a fade out, and the
+// audio resuming after a gap is cross-faded in.
+//
+// Only 16-bit host order PCM is concealed, other formats pass through.
+// All calls come from the thread frames are delivered on.
+class LossConcealer final
+{
+public:
+  // Produces one codec frame of concealment audio per call, e.g. from the
+  // decoder's own loss concealment. Returns false when it cannot.
+  using NativeConcealment = std::function<bool(DecodedAudio& output)>;
+
+  // Audio to write before the packet, and whether to drop the packet.
+  struct Gap
+  {
+    const std::uint8_t* data = nullptr;
+    std::size_t size = 0;
+    bool discardPacket = false;
+  };
+
+  // Starts over for a new stream; the counters keep accumulating. The
+  // sample rate is taken as the RTP clock rate of the stream as well.
+  void setFormat(const PcmFormat& format);
+
+  // Adopts the format the stream actually decodes to, which may differ from
+  // the announced one, e.g. for HE-AAC. Packet tracking carries on and RTP
+  // timestamps keep their clock rate; the audio history is dropped when the
+  // format changes.
+  void updateFormat(const PcmFormat& format);
+
+  // Format of the audio the concealer produces and expects.
+  const PcmFormat& format() const { return format_; }
+
+  void setNativeConcealment(NativeConcealment concealment);
+
+  // Called for every received frame before it is decoded. The returned
+  // audio stays valid until the next call.
+  Gap onPacket(std::uint16_t sequenceNumber, std::uint32_t rtpTimestamp);
+
+  // Called with the PCM the frame decoded to. Returns either the same audio
+  // or a cross-faded copy that stays valid until the next call.
+  const std::uint8_t* onAudio(const std::uint8_t* data, std::size_t size);
+
+  void reset();
+
+  // Safe to call from any thread.
+  ConcealmentStats stats() const;
+
+private:
+  void applyFormat(const PcmFormat& format);
+  void conceal(std::size_t framesCount);
+  void concealNatively(std::size_t framesCount);
+  void synthesize(std::int16_t* output, std::size_t framesCount);
+  void startSynthesis();
+  void appendHistory(const void* samples, std::size_t framesCount);
+  std::size_t estimatePeriod();
+
+private:
+  PcmFormat format_;
+  bool enabled_ = false;
+  std::size_t channelsCount_ = 1;
+  // RTP timestamp units per second.
+  std::uint32_t clockRate_ = 0;
+
+  std::size_t minPeriod_ = 0;
+  std::size_t maxPeriod_ = 0;
+  std::size_t historyFrames_ = 0;
+  std::size_t fullGainFrames_ = 0;
+  std::size_t fadeOutFrames_ = 1;
+  std::size_t maxGapFrames_ = 0;
+
+  NativeConcealment nativeConcealment_;
+
+  bool hasPacket_ = false;
+  std::uint16_t lastSequenceNumber_ = 0;
+  std::uint32_t packetTimestamp_ = 0;
+  // Frames decoded from the current packet so far; a packet may carry
+  // several codec frames.
+  std::size_t packetFrames_ = 0;
+
+  // Last output, interleaved, oldest first.
+  std::vector<std::int16_t> history_;
+
+  // Waveform repetition state of the current gap.
+  bool concealing_ = false;
+  std::vector<std::int16_t> period_;
+  std::size_t periodFrames_ = 0;
+  std::size_t periodPosition_ = 0;
+  std::size_t synthesizedFrames_ = 0;
+
+  std::vector<std::int16_t> output_;
+  std::vector<std::int16_t> fade_;
+  std::vector<float> mono_;
+
+  std::atomic<std::uint64_t> lostPackets_ = 0;
+  std::atomic<std::uint64_t> concealmentEvents_ = 0;
+  std::atomic<std::uint64_t> concealedFrames_ = 0;
+  std::atomic<std::uint64_t> discardedPackets_ = 0;
+};
+} // namespace AudioPipeline
@@ -0,0 +1,241 @@
+#pragma once
+
+#include "AudioPipeline/AP_AudioSink.h"
+#include "AudioPipeline/AP_DriftCompensator.h"
+#include "AudioPipeline/AP_Resampler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace AudioPipeline
+{
+struct MixerOptions
+{
+  // The mix is 16-bit host order audio in this format, whatever the inputs.
+  std::uint32_t sampleRate = 48000;
+  std::uint32_t channelsCount = 2;
+
+  // Audio produced per mixer cycle.
+  std::chrono::milliseconds blockDuration{10};
+
+  // Audio every input holds before it joins the mix, to absorb network
+  // jitter. Inputs are kept at this delay, which also keeps them aligned.
+  std::chrono::milliseconds inputDelay{60};
+
+  // Bound of the resampling that holds each input at the delay against the
+  // clock of its source; cheap phone clocks can be off by thousands of ppm.
+  std::uint32_t maxCorrectionPpm = 5000;
+};
+
+struct MixerInputStats
+{
+  std::uint64_t framesReceived = 0;
+  // Frames thrown away to bring the input back to the target delay, or
+  // because it ran too far ahead of the mixer.
+  std::uint64_t framesDropped = 0;
+  // Times the input ran dry and left the mix until it had buffered enough.
+  std::uint64_t underruns = 0;
+  // Formats the input was started with and refused, see MixerInput.
+  std::uint64_t formatsRejected = 0;
+  std::uint32_t bufferedFrames = 0;
+  bool isStarted = false;
+  bool isMixed = false;
+  bool isMuted = false;
+  float gain = 1.f;
+};
+
+struct MixerStats
+{
+  std::uint64_t blocksMixed = 0;
+  // Cycles the mixer thread woke up too late for and skipped.
+  std::uint64_t blocksLate = 0;
+  // Cycles no input had audio in, written to the outputs as silence.
+  std::uint64_t silentBlocks = 0;
+  std::uint32_t inputsCount = 0;
+  std::uint32_t mixedInputs = 0;
+  std::uint64_t averageMixNs = 0;
+  std::uint64_t maxMixNs = 0;
+};
+
+class Mixer;
+
+// One stream of the mix, e.g. a phone. Converts whatever 16-bit host order
+// audio it is given to the mix format on the producer thread and queues it
+// for the mixer thread in a lock-free ring. The source runs on its own
+// clock, so the queue is held at inputDelay by drift compensation, which
+// resamples the input by the few ppm the clocks differ rather than letting
+// the mixer cut into it. Other sample formats are refused
+// by start(), which is counted in formatsRejected, and writes are then
+// ignored until the next successful start. Silence is queued as any audio
+// but remembered as such, so the mixer can skip it.
+class MixerInput final : public AudioSink
+{
+public:
+  explicit MixerInput(const MixerOptions& options);
+  ~MixerInput() override;
+
+  bool start(const PcmFormat& format) override;
+  void write(const std::uint8_t* data, std::size_t size) override;
+  void writeSilence(const std::uint8_t* data, std::size_t size) override;
+  void stop() override;
+
+  std::int64_t bufferedFrames() const override;
+  AudioSinkStats stats() const override;
+
+  // Safe to call from any thread.
+  void setGain(float gain) { gain_.store(gain, std::memory_order_relaxed); }
+  void setMuted(bool isMuted) { isMuted_.store(isMuted, std::memory_order_relaxed); }
+  MixerInputStats inputStats() const;
+  DriftStats driftStats() const;
+
+private:
+  friend class Mixer;
+
+  // The ring as the sink of the drift compensation.
+  class Queue;
+
+  void writeAudio(const std::uint8_t* data, std::size_t size, bool isSilent);
+  void push(const std::int16_t* samples, std::size_t framesCount, bool isSilent);
+
+private:
+  const std::size_t channelsCount_;
+  const std::uint32_t sampleRate_;
+  const std::size_t delayFrames_;
+
+  // Single producer single consumer ring of frames in the mix format:
+  // frames from readFrame_ up to writeFrame_ belong to the mixer thread.
+  const std::size_t capacityFrames_;
+  std::unique_ptr<std::int16_t[]> ring_;
+  std::atomic<std::uint64_t> writeFrame_ = 0;
+  std::atomic<std::uint64_t> readFrame_ = 0;
+  // End of the last audio that was not silence; blocks from there on are
+  // silent. Published along with writeFrame_.
+  std::atomic<std::uint64_t> audibleEnd_ = 0;
+  // Frames queued when the mixer last looked, what the drift compensation
+  // holds at the delay. Unlike the level seen by the producer, it does not
+  // depend on how large the writes of the source are.
+  std::atomic<std::uint64_t> mixerQueuedFrames_ = 0;
+  // Frames of the last write, the queue level swings by that much between
+  // writes of the source.
+  std::atomic<std::uint32_t> lastWriteFrames_ = 0;
+
+  // Producer side.
+  PcmFormat format_;
+  bool started_ = false;
+  std::atomic_bool isStarted_ = false;
+  std::optional<Resampler> resampler_;
+  std::vector<std::int16_t> input_;
+  std::vector<std::int16_t> resampled_;
+  std::vector<std::int16_t> converted_;
+  std::shared_ptr<DriftCompensator> driftCompensator_;
+
+  std::atomic<float> gain_ = 1.f;
+  std::atomic_bool isMuted_ = false;
+  // Owned by the mixer thread.
+  std::atomic_bool isMixed_ = false;
+
+  std::atomic<std::uint64_t> writes_ = 0;
+  std::atomic<std::uint64_t> framesReceived_ = 0;
+  std::atomic<std::uint64_t> bytesReceived_ = 0;
+  std::atomic<std::uint64_t> formatsRejected_ = 0;
+  std::atomic<std::uint64_t> framesDropped_ = 0;
+  std::atomic<std::uint64_t> underruns_ = 0;
+};
+using MixerInputPtr = std::shared_ptr<MixerInput>;
+
+// Mixes any number of streams into one, e.g. several phones into a single
+// virtual microphone. A dedicated thread produces a block of blockDuration
+// every cycle: each input contributes the next block of its queue, scaled
+// by its gain, to a float accumulator which is rounded back to 16 bits with
+// saturation and written to the outputs. The cost of a cycle is the
+// vectorized sum alone, so it grows no faster than the audio being mixed.
+// Silent, muted and zero gain blocks are not summed, and a cycle without
+// any audio is written to the outputs as silence.
+//
+// Streams carry no common clock, so inputs are aligned on arrival: each
+// one joins the mix once it has inputDelay buffered and is resampled to
+// stay there. Only when that cannot keep up, e.g. after a stall, does an
+// input leave the mix to buffer again or get cut back to the delay.
+class Mixer final
+{
+public:
+  // Outputs are started with the mix format and written from the mixer
+  // thread only.
+  Mixer(std::vector<AudioSinkPtr> outputs, MixerOptions options);
+  ~Mixer();
+
+  // Safe to call from any thread. The mixer keeps a removed input until
+  // the next change of the inputs after the mixer thread let go of it, or
+  // its own destruction.
+  MixerInputPtr addInput();
+  void removeInput(const MixerInputPtr& input);
+  MixerStats stats() const;
+
+private:
+  using Inputs = std::vector<MixerInputPtr>;
+
+  enum class InputBlock
+  {
+    Missing,
+    Silent,
+    Audible
+  };
+
+  // Under the inputs lock.
+  void releaseRetiredInputs();
+
+  void mixLoop();
+  // Adds the next block of the input to the mix unless it is silent.
+  InputBlock mixInput(MixerInput& input);
+
+private:
+  const MixerOptions options_;
+  const PcmFormat format_;
+  const std::size_t blockFrames_;
+  const std::vector<AudioSinkPtr> outputs_;
+
+  void (*accumulate_)(float* mix, const std::int16_t* samples, std::size_t count, float gain) = nullptr;
+  void (*store_)(const float* mix, std::int16_t* output, std::size_t count) = nullptr;
+
+  // Changed under the lock, which bumps the generation. The mixer thread
+  // polls the generation and copies the inputs only when it moved, with a
+  // try-lock: a busy lock just delays the change by a cycle.
+  mutable std::mutex inputsMutex_;
+  Inputs inputs_;
+  std::atomic<std::uint64_t> inputsGeneration_ = 0;
+  // The generation the mixer thread copied last.
+  std::atomic<std::uint64_t> mixedGeneration_ = 0;
+
+  // Removed inputs the mixer thread may still hold, with the generation
+  // that removed them. They are released on the control side once the
+  // mixer thread has moved past it, so their memory is never freed on the
+  // mixer thread.
+  struct RetiredInput
+  {
+    MixerInputPtr input;
+    std::uint64_t generation = 0;
+  };
+  std::vector<RetiredInput> retiredInputs_;
+
+  // Owned by the mixer thread.
+  std::vector<float> mix_;
+  std::vector<std::int16_t> output_;
+
+  std::atomic_bool stopping_ = false;
+  std::thread thread_;
+
+  std::atomic<std::uint64_t> blocksMixed_ = 0;
+  std::atomic<std::uint64_t> blocksLate_ = 0;
+  std::atomic<std::uint64_t> silentBlocks_ = 0;
+  std::atomic<std::uint32_t> mixedInputs_ = 0;
+  std::atomic<std::uint64_t> totalMixNs_ = 0;
+  std::atomic<std::uint64_t> maxMixNs_ = 0;
+};
+} // namespace AudioPipeline
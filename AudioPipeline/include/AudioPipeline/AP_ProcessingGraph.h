@@ -0,0 +1,231 @@
+#pragma once
+
+#include "AudioPipeline/AP_AudioSink.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace AudioPipeline
+{
+// Audio handed from one processing stage to the next. The data belongs to
+// whoever produced the block and stays valid until it processes again.
+struct AudioBlock
+{
+  const std::uint8_t* data = nullptr;
+  std::size_t size = 0;
+  PcmFormat format;
+
+  // A compressed access unit rather than PCM; the format is then the one it
+  // nominally decodes to.
+  bool isEncoded = false;
+  // Audio synthesized in place of lost packets.
+  bool isConcealment = false;
+  // Silence as told by voice activity detection; stages may take cheaper
+  // paths for it.
+  bool isSilent = false;
+
+  bool empty() const { return size == 0; }
+};
+
+// One step between the network and the outputs, e.g. decoding, resampling
+// or writing to a sink.
+class ProcessingStage
+{
+public:
+  virtual ~ProcessingStage() = default;
+
+  virtual const char* name() const = 0;
+
+  // Called on the processing thread before the first block and whenever the
+  // format of the incoming blocks changes; this is where stages allocate.
+  // A rewired graph calls it again with the format already in use. Returns
+  // false when the stage cannot take the format, blocks then stop there.
+  virtual bool configure(const PcmFormat& /*format*/) { return true; }
+
+  // Returns what goes to the next stages, an empty block when nothing does.
+  // Must not allocate once configured.
+  virtual AudioBlock process(const AudioBlock& input) = 0;
+};
+using ProcessingStagePtr = std::shared_ptr<ProcessingStage>;
+
+// Stages known at compile time, run back to back as one stage of a graph.
+// Calls between them are direct and inlined as long as the stage types are
+// final, as the library's are. Each stage is configured with the format of
+// the blocks it gets, like the stages of a graph.
+//
+// The stages are built in place, each from one argument, e.g.
+// StaticChain<RemixStage, ResampleStage>("output", 2, 48000).
+template <typename... Stages>
+class StaticChain final : public ProcessingStage
+{
+public:
+  template <typename... Args>
+  explicit StaticChain(std::string name, Args&&... args)
+      : name_(std::move(name))
+      , stages_(std::forward<Args>(args)...)
+  {
+  }
+
+  const char* name() const override { return name_.c_str(); }
+
+  bool configure(const PcmFormat& /*format*/) override
+  {
+    configuredFormats_.fill(std::nullopt);
+    return true;
+  }
+
+  AudioBlock process(const AudioBlock& input) override { return processFrom<0>(input); }
+
+  template <std::size_t Index>
+  auto& stage()
+  {
+    return std::get<Index>(stages_);
+  }
+
+private:
+  template <std::size_t Index>
+  AudioBlock processFrom(const AudioBlock& block)
+  {
+    if constexpr (Index == sizeof...(Stages))
+    {
+      return block;
+    }
+    else
+    {
+      auto& stage = std::get<Index>(stages_);
+      if (configuredFormats_[Index] != block.format)
+      {
+        configuredFormats_[Index] = block.format;
+        isUsable_[Index] = stage.configure(block.format);
+      }
+      if (!isUsable_[Index])
+        return {};
+
+      const auto output = stage.process(block);
+      return output.empty() ? output : processFrom<Index + 1>(output);
+    }
+  }
+
+private:
+  const std::string name_;
+  std::tuple<Stages...> stages_;
+
+  std::array<std::optional<PcmFormat>, sizeof...(Stages)> configuredFormats_;
+  std::array<bool, sizeof...(Stages)> isUsable_ = {};
+};
+
+struct StageTiming
+{
+  std::string name;
+  std::uint64_t blocks = 0;
+  std::uint32_t averageNs = 0;
+  std::uint32_t maxNs = 0;
+
+  // The blocks that came in flagged as silence, and what they took; the
+  // difference to the others is what the silence fast paths save.
+  std::uint64_t silentBlocks = 0;
+  std::uint32_t averageSilentNs = 0;
+
+  // Time the silent blocks took less than as many blocks of audio would
+  // have taken.
+  std::int64_t silenceSavedNs() const
+  {
+    if (silentBlocks == 0 || silentBlocks >= blocks)
+      return 0;
+
+    const auto audioNs = (std::int64_t(averageNs) * std::int64_t(blocks)
+                          - std::int64_t(averageSilentNs) * std::int64_t(silentBlocks))
+                         / std::int64_t(blocks - silentBlocks);
+    return (audioNs - std::int64_t(averageSilentNs)) * std::int64_t(silentBlocks);
+  }
+};
+
+// Stages wired into a tree: blocks enter at the roots and every stage hands
+// its output to each of its successors, so one stream can feed several
+// outputs. The wiring can be replaced from any thread while blocks flow;
+// the processing thread picks the new one up with the next block and
+// configures its stages then. Every stage is timed.
+class ProcessingGraph final
+{
+public:
+  // Describes a wiring. Stages may be shared with the current wiring, they
+  // keep their state.
+  class Wiring
+  {
+  public:
+    // Adds a stage after the given one, or as a root; returns its index.
+    std::size_t add(ProcessingStagePtr stage, std::optional<std::size_t> after = std::nullopt);
+
+  private:
+    friend class ProcessingGraph;
+
+    struct Node
+    {
+      ProcessingStagePtr stage;
+      std::vector<std::size_t> successors;
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<std::size_t> roots_;
+  };
+
+  ProcessingGraph() = default;
+  explicit ProcessingGraph(Wiring wiring);
+
+  // Safe to call from any thread.
+  void rewire(Wiring wiring);
+
+  // Processing thread only.
+  void process(const AudioBlock& block);
+
+  // Timings of the stages of the current wiring, in the order they were
+  // added. Safe to call from any thread.
+  std::vector<StageTiming> timings() const;
+
+private:
+  struct Node
+  {
+    ProcessingStagePtr stage;
+    std::vector<std::size_t> successors;
+
+    // Processing thread only.
+    std::optional<PcmFormat> configuredFormat;
+    bool isUsable = false;
+
+    std::atomic<std::uint64_t> blocks = 0;
+    std::atomic<std::uint64_t> totalNs = 0;
+    std::atomic<std::uint32_t> maxNs = 0;
+    std::atomic<std::uint64_t> silentBlocks = 0;
+    std::atomic<std::uint64_t> silentTotalNs = 0;
+  };
+
+  struct Topology
+  {
+    std::unique_ptr<Node[]> nodes;
+    std::size_t nodesCount = 0;
+    std::vector<std::size_t> roots;
+  };
+
+  void run(Topology& topology, std::size_t index, const AudioBlock& block);
+
+private:
+  // Replaced under the lock, which bumps the generation. The processing
+  // thread polls the generation and takes the lock only when it moved.
+  mutable std::mutex topologyMutex_;
+  std::shared_ptr<Topology> topology_;
+  std::atomic<std::uint64_t> topologyGeneration_ = 0;
+
+  // Processing thread only.
+  std::shared_ptr<Topology> processedTopology_;
+  std::uint64_t processedGeneration_ = 0;
+};
+} // namespace AudioPipeline
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "AudioPipeline/AP_AudioDecoder.h"
+#include "AudioPipeline/AP_AudioSink.h"
+#include "AudioPipeline/AP_LossConcealer.h"
+#include "AudioPipeline/AP_ProcessingGraph.h"
+#include "AudioPipeline/AP_Resampler.h"
+#include "AudioPipeline/AP_VoiceActivityDetector.h"
+
+#include <optional>
+#include <vector>
+
+namespace AudioPipeline
+{
+// Decodes encoded blocks, PCM blocks pass through.
+class DecodeStage final : public ProcessingStage
+{
+public:
+  explicit DecodeStage(AudioDecoderPtr decoder);
+
+  const char* name() const override { return "decode"; }
+  AudioBlock process(const AudioBlock& input) override;
+
+private:
+  AudioDecoderPtr decoder_;
+};
+
+// Runs decoded audio through a loss concealer so it resumes smoothly after
+// a gap; the concealment audio itself passes through. The concealer adopts
+// the format the audio decodes to.
+class ConcealStage final : public ProcessingStage
+{
+public:
+  explicit ConcealStage(LossConcealer& concealer);
+
+  const char* name() const override { return "conceal"; }
+  bool configure(const PcmFormat& format) override;
+  AudioBlock process(const AudioBlock& input) override;
+
+private:
+  LossConcealer& concealer_;
+};
+
+// Flags blocks of silence for the stages after it. Compressed blocks pass
+// unflagged.
+class VoiceActivityStage final : public ProcessingStage
+{
+public:
+  explicit VoiceActivityStage(VoiceActivityOptions options = {});
+
+  // Safe to call from any thread.
+  VoiceActivityStats stats() const { return detector_.stats(); }
+
+  const char* name() const override { return "vad"; }
+  bool configure(const PcmFormat& format) override;
+  AudioBlock process(const AudioBlock& input) override;
+
+private:
+  VoiceActivityDetector detector_;
+};
+
+// Converts 16-bit host order audio to another channel count, see
+// convertChannels().
+class RemixStage final : public ProcessingStage
+{
+public:
+  explicit RemixStage(std::uint32_t outputChannels);
+
+  const char* name() const override { return "remix"; }
+  bool configure(const PcmFormat& format) override;
+  AudioBlock process(const AudioBlock& input) override;
+
+private:
+  const std::uint32_t outputChannels_;
+  bool isRemixing_ = false;
+  PcmFormat outputFormat_;
+  std::vector<std::int16_t> input_;
+  std::vector<std::int16_t> output_;
+};
+
+// Converts 16-bit host order audio to another sample rate.
+class ResampleStage final : public ProcessingStage
+{
+public:
+  explicit ResampleStage(std::uint32_t outputRate);
+
+  const char* name() const override { return "resample"; }
+  bool configure(const PcmFormat& format) override;
+  AudioBlock process(const AudioBlock& input) override;
+
+private:
+  const std::uint32_t outputRate_;
+  std::optional<Resampler> resampler_;
+  PcmFormat outputFormat_;
+  std::vector<std::int16_t> input_;
+  std::vector<std::int16_t> output_;
+};
+
+// Writes blocks to a sink, started with the format of the blocks, and
+// blocks of silence as such. Ends the branch.
+class SinkStage final : public ProcessingStage
+{
+public:
+  explicit SinkStage(AudioSinkPtr sink);
+  ~SinkStage() override;
+
+  const char* name() const override { return "sink"; }
+  bool configure(const PcmFormat& format) override;
+  AudioBlock process(const AudioBlock& input) override;
+
+private:
+  AudioSinkPtr sink_;
+  std::optional<PcmFormat> startedFormat_;
+};
+} // namespace AudioPipeline
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "AudioPipeline/AP_AudioSink.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace AudioPipeline
+{
+enum class RecordingContainer
+{
+  Wav,
+  Flac
+};
+
+struct RecorderOptions
+{
+  // Files are named <pathPrefix>-<start time>-<index>.wav or .flac.
+  std::string pathPrefix = "recording";
+  RecordingContainer container = RecordingContainer::Wav;
+
+  // A new file is started once either limit would be exceeded; zero means
+  // no limit. WAV files are also rotated before they outgrow the 4 GiB
+  // their headers can describe.
+  std::uint64_t maxFileBytes = 0;
+  std::chrono::seconds maxFileDuration{0};
+
+  // Leaves audio written as silence out of the files.
+  bool skipSilence = false;
+
+  // Audio held in memory while the disk is slow, in blocks of blockDuration.
+  std::chrono::milliseconds queueDuration{4000};
+  std::chrono::milliseconds blockDuration{100};
+};
+
+struct RecorderStats
+{
+  std::uint64_t blocksRecorded = 0;
+  // Blocks dropped because the disk did not keep up and the queue was full.
+  std::uint64_t blocksDropped = 0;
+  std::uint64_t bytesWritten = 0;
+  // Silence left out of the files.
+  std::uint64_t silentBytesSkipped = 0;
+  std::uint64_t filesCompleted = 0;
+  std::uint64_t writeErrors = 0;
+  std::uint32_t queuedBlocks = 0;
+  std::uint32_t maxQueuedBlocks = 0;
+};
+
+// Records whatever is written to it to WAV or FLAC files. The producer only
+// copies blocks into a preallocated lock-free queue, files are encoded and
+// written on a dedicated I/O thread in large aligned writes, so a stalling
+// disk costs dropped blocks rather than a blocked producer. Every start()
+// begins a new file, as do the rotation limits.
+class Recorder final : public PeriodicAudioSink
+{
+public:
+  explicit Recorder(RecorderOptions options);
+  ~Recorder() override;
+
+  void writeSilence(const std::uint8_t* data, std::size_t size) override;
+
+  // Safe to call from any thread.
+  RecorderStats recorderStats() const;
+
+protected:
+  bool openBackend(const PcmFormat& format) override;
+  bool writePeriod(const std::uint8_t* data, std::size_t size) override;
+  void closeBackend() override;
+
+private:
+  struct Block
+  {
+    std::vector<std::uint8_t> data;
+    std::size_t size = 0;
+    PcmFormat format;
+    // Start of the recording the block belongs to.
+    std::uint32_t session = 0;
+  };
+
+  void ioLoop();
+
+private:
+  const RecorderOptions options_;
+
+  // Single producer single consumer ring: blocks from readIndex_ up to
+  // writeIndex_ belong to the I/O thread, the others to the producer.
+  const std::uint32_t blocksCount_;
+  std::unique_ptr<Block[]> blocks_;
+  std::atomic<std::uint32_t> writeIndex_ = 0;
+  std::atomic<std::uint32_t> readIndex_ = 0;
+
+  PcmFormat format_;
+  // Recording in progress, zero when stopped.
+  std::atomic<std::uint32_t> session_ = 0;
+  std::uint32_t lastSession_ = 0;
+
+  // Bumped whenever the I/O thread has something to do.
+  std::atomic<std::uint32_t> wakeups_ = 0;
+  std::atomic_bool stopping_ = false;
+  std::thread ioThread_;
+
+  std::atomic<std::uint64_t> blocksRecorded_ = 0;
+  std::atomic<std::uint64_t> blocksDropped_ = 0;
+  std::atomic<std::uint64_t> bytesWritten_ = 0;
+  std::atomic<std::uint64_t> silentBytesSkipped_ = 0;
+  std::atomic<std::uint64_t> filesCompleted_ = 0;
+  std::atomic<std::uint64_t> writeErrors_ = 0;
+  std::atomic<std::uint32_t> maxQueuedBlocks_ = 0;
+};
+} // namespace AudioPipeline
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "AudioPipeline/AP_AudioSink.h"
+#include "AudioPipeline/AP_Recorder.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace AudioPipeline
+{
+// Always-on capture of the last seconds of audio written to it, e.g. to
+// save what led up to a glitch. The audio goes to a ring sized for the
+// duration in the format of the stream, allocated when the format changes
+// and never otherwise, so memory stays bounded by duration and format.
+// Audio is kept across stop() and a restart with the same format.
+class ReplayCapture final : public AudioSink
+{
+public:
+  explicit ReplayCapture(std::chrono::seconds duration);
+
+  bool start(const PcmFormat& format) override;
+  void write(const std::uint8_t* data, std::size_t size) override;
+  void stop() override;
+
+  AudioSinkStats stats() const override;
+
+  // Writes the captured audio, oldest first, to a file. Safe to call from
+  // any thread while audio keeps being written; audio overwritten during
+  // the copy is left out. Returns false when nothing was captured or the
+  // file could not be written.
+  bool dump(const std::string& path, RecordingContainer container) const;
+
+private:
+  struct Ring
+  {
+    PcmFormat format;
+    std::unique_ptr<std::uint8_t[]> data;
+    std::size_t capacity = 0;
+
+    // Bytes written since the ring was allocated, and the end of the write
+    // in progress; a reader uses them like a sequence lock.
+    std::atomic<std::uint64_t> written = 0;
+    std::atomic<std::uint64_t> reserved = 0;
+  };
+
+  const std::chrono::seconds duration_;
+
+  // Owned by the producer, which only takes the lock to publish a new ring
+  // when the format changes; readers take a reference through ring_.
+  std::shared_ptr<Ring> producerRing_;
+  mutable std::mutex ringMutex_;
+  std::shared_ptr<Ring> ring_;
+  bool started_ = false;
+
+  std::atomic<std::uint64_t> writes_ = 0;
+  std::atomic<std::uint64_t> bytesWritten_ = 0;
+};
+} // namespace AudioPipeline
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace AudioPipeline
+{
+// Polyphase windowed-sinc sample rate converter for interleaved 16-bit host
+// order PCM, e.g. 44.1 kHz streams played on a 48 kHz device. The rates
+// reduce to an L/M ratio whose L phases are precomputed when there are few
+// enough of them; arbitrary ratios interpolate between the phases of a
+// fixed table instead. Downsampling lowers the cutoff to avoid aliasing.
+//
+// Input is taken in blocks of at most MaxBlockFrames frames; nothing is
+// allocated once constructed.
+class Resampler final
+{
+public:
+  static constexpr std::size_t MaxBlockFrames = 1024;
+
+  Resampler(std::uint32_t inputRate, std::uint32_t outputRate, std::uint32_t channelsCount);
+
+  std::uint32_t inputRate() const { return inputRate_; }
+  std::uint32_t outputRate() const { return outputRate_; }
+
+  // Output frames process() may produce for the given input frames.
+  std::size_t maxOutputFrames(std::size_t inputFrames) const;
+
+  // Converts up to MaxBlockFrames frames and returns the frames written to
+  // the output. The output lags the input by half the filter length.
+  std::size_t process(const std::int16_t* input, std::size_t framesCount, std::int16_t* output);
+
+  void reset();
+
+private:
+  const float* phaseTaps(std::size_t phase) const { return taps_.data() + phase * tapsCount_; }
+
+private:
+  const std::uint32_t inputRate_;
+  const std::uint32_t outputRate_;
+  const std::size_t channelsCount_;
+
+  // Output advances the input by inputStep_ / outputStep_ frames.
+  std::uint64_t inputStep_ = 1;
+  std::uint64_t outputStep_ = 1;
+
+  // Table phases; when fewer than outputStep_, neighbours are interpolated.
+  std::size_t phasesCount_ = 0;
+  bool interpolatesPhases_ = false;
+  std::size_t tapsCount_ = 0;
+  std::vector<float> taps_;
+
+  float (*dotProduct_)(const float* samples, const float* taps, std::size_t tapsCount) = nullptr;
+
+  // Planar history of each channel; the next output is computed from the
+  // tapsCount_ frames from historyStart_ on.
+  std::vector<float> history_;
+  std::size_t historyCapacity_ = 0;
+  std::size_t historyFrames_ = 0;
+  std::size_t historyStart_ = 0;
+  std::uint64_t phaseAccumulator_ = 0;
+};
+} // namespace AudioPipeline
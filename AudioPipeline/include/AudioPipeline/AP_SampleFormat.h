@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace AudioPipeline
+{
+// Integer PCM sample encodings understood by the pipeline kernels.
+enum class SampleFormat
+{
+  U8 = 0,
+  S8,
+  U16LE,
+  U16BE,
+  S16LE,
+  S16BE
+};
+
+std::optional<SampleFormat> makeSampleFormat(std::uint8_t sampleBits, bool isSigned, bool isLittleEndian);
+
+std::size_t bytesPerSample(SampleFormat format);
+
+// Magnitude of the most negative sample value, i.e. 128 or 32768.
+std::uint32_t fullScaleOf(SampleFormat format);
+} // namespace AudioPipeline
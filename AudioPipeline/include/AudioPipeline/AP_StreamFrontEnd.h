@@ -0,0 +1,66 @@
+#pragma once
+
+#include "AudioPipeline/AP_LossConcealer.h"
+#include "AudioPipeline/AP_ProcessingGraph.h"
+#include "AudioPipeline/AP_VoiceActivityDetector.h"
+#include "Broadcast/BC_AudioFramesHandler.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace AudioPipeline
+{
+class ConcealStage;
+class VoiceActivityStage;
+
+// The processing every received stream starts with, whatever it is played
+// to: frames go through a graph that decodes them when the stream is
+// compressed, conceals the audio of lost packets and flags silence. The
+// stages after that, the outputs, are wired by the owner for each stream.
+//
+// Float PCM is not taken, the frames of such streams are dropped.
+class StreamFrontEnd final : public Broadcast::AudioFramesHandler
+{
+public:
+  // Adds the output stages after the given stage of the wiring. Called on
+  // the delivery thread for every stream; stages shared across streams
+  // keep their state, e.g. a sink stage restarts its sink only when the
+  // format of the audio changes.
+  using OutputsWiring = std::function<void(ProcessingGraph::Wiring& wiring, std::size_t after)>;
+
+  // Told why a stream cannot be played, on the delivery thread. Without it
+  // the reason is printed to std::cerr.
+  using ErrorCallback = std::function<void(const std::string& message)>;
+
+  explicit StreamFrontEnd(OutputsWiring outputsWiring, ErrorCallback onError = nullptr);
+  ~StreamFrontEnd() override;
+
+  void onStreamFormat(const Broadcast::StreamFormat& format) override;
+  void onFrame(const std::uint8_t* data, std::size_t len) override;
+  void onFrameBuffer(const Broadcast::FrameBuffer& frame) override;
+
+  // Safe to call from any thread.
+  ConcealmentStats concealmentStats() const { return concealer_.stats(); }
+  VoiceActivityStats voiceActivityStats() const;
+  std::vector<StageTiming> stageTimings() const { return graph_.timings(); }
+
+private:
+  void reportError(const std::string& message);
+
+private:
+  const OutputsWiring outputsWiring_;
+  const ErrorCallback onError_;
+
+  // Declared before the graph, whose stages refer to it.
+  LossConcealer concealer_;
+  std::shared_ptr<ConcealStage> concealStage_;
+  std::shared_ptr<VoiceActivityStage> voiceActivityStage_;
+  ProcessingGraph graph_;
+
+  PcmFormat streamFormat_;
+  bool isCompressedStream_ = false;
+};
+} // namespace AudioPipeline
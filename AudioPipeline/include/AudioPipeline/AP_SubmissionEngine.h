@@ -0,0 +1,126 @@
+#pragma once
+
+#include "AudioPipeline/AP_AudioSink.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace AudioPipeline
+{
+struct SubmissionCompletion
+{
+  std::uint32_t token = 0;
+  bool succeeded = false;
+};
+
+// Asynchronous consumer of audio chunks, e.g. a kernel streaming pin. Up to
+// the number of requests given to open() may be in flight at once; submit()
+// and waitCompletion() are called from different threads.
+class SubmissionDevice
+{
+public:
+  virtual ~SubmissionDevice() = default;
+
+  virtual bool open(const PcmFormat& format, std::uint32_t requestsCount) = 0;
+  // The chunk must stay untouched until its token is reported completed.
+  virtual bool submit(const std::uint8_t* data, std::size_t size, std::uint32_t token) = 0;
+  // Returns false when nothing completed within the timeout.
+  virtual bool waitCompletion(std::chrono::milliseconds timeout, SubmissionCompletion& completion) = 0;
+  // Makes whatever is still in flight complete as failed, soon.
+  virtual void cancel() = 0;
+  // Called once every request has completed, never while the device may
+  // still touch a chunk.
+  virtual void close() = 0;
+};
+using SubmissionDevicePtr = std::shared_ptr<SubmissionDevice>;
+
+// Completes every chunk once the device would have played it in real time,
+// plus the given latency. Lets the engine be exercised without hardware.
+SubmissionDevicePtr createFakeSubmissionDevice(std::chrono::microseconds extraLatency = {});
+
+struct SubmissionStats
+{
+  std::uint64_t chunksSubmitted = 0;
+  std::uint64_t chunksCompleted = 0;
+  std::uint64_t chunksFailed = 0;
+  // Chunks dropped because every request was still in flight.
+  std::uint64_t chunksDropped = 0;
+  // Chunks of silence, submitted zeroed without copying any audio.
+  std::uint64_t silentChunks = 0;
+  std::uint32_t inFlight = 0;
+
+  // Submit to completion time of chunks.
+  std::uint32_t lastLatencyUs = 0;
+  std::uint32_t averageLatencyUs = 0;
+  std::uint32_t maxLatencyUs = 0;
+};
+
+// Coalesces the audio written to it into period sized chunks and keeps up to
+// requestsCount of them in flight on a device. The producer never waits for
+// the device: a chunk that finds no free request is dropped. Completions
+// are collected on a dedicated thread. Periods written as silence go out
+// as zeroed chunks; a request whose chunk is still zeroed from the last
+// silent period is resubmitted without touching it.
+//
+// Stopping cancels the requests in flight and waits a while for them. The
+// chunks of requests a device fails to complete in time are kept, and the
+// device is neither closed nor reopened, until their completions are
+// collected on the next start.
+class SubmissionEngine final : public PeriodicAudioSink
+{
+public:
+  SubmissionEngine(SubmissionDevicePtr device, std::chrono::microseconds period, std::uint32_t requestsCount);
+  ~SubmissionEngine() override;
+
+  // Safe to call from any thread.
+  SubmissionStats submissionStats() const;
+
+protected:
+  bool openBackend(const PcmFormat& format) override;
+  bool writePeriod(const std::uint8_t* data, std::size_t size) override;
+  bool writeSilentPeriod(const std::uint8_t* data, std::size_t size) override;
+  void closeBackend() override;
+  std::int64_t backendBufferedBytes() const override;
+
+private:
+  bool submitPeriod(const std::uint8_t* data, std::size_t size, bool isSilent);
+  // Collects the completions a close gave up waiting for and closes the
+  // device; returns false when requests are still in flight.
+  bool collectStrandedRequests();
+  void completionLoop();
+  void onCompleted(const SubmissionCompletion& completion);
+
+private:
+  struct Request
+  {
+    std::unique_ptr<std::uint8_t[]> chunk;
+    // Leading bytes of the chunk known to be zero, producer only.
+    std::size_t zeroedSize = 0;
+    std::chrono::steady_clock::time_point submittedAt;
+    std::atomic_bool inFlight = false;
+  };
+
+  const SubmissionDevicePtr device_;
+  const std::uint32_t requestsCount_;
+
+  std::unique_ptr<Request[]> requests_;
+  std::uint32_t nextRequest_ = 0;
+  bool isDeviceOpen_ = false;
+
+  std::thread completionThread_;
+  std::atomic_bool stopping_ = false;
+
+  std::atomic<std::uint64_t> chunksSubmitted_ = 0;
+  std::atomic<std::uint64_t> chunksCompleted_ = 0;
+  std::atomic<std::uint64_t> chunksFailed_ = 0;
+  std::atomic<std::uint64_t> chunksDropped_ = 0;
+  std::atomic<std::uint64_t> silentChunks_ = 0;
+  std::atomic<std::uint32_t> inFlight_ = 0;
+  std::atomic<std::uint32_t> lastLatencyUs_ = 0;
+  std::atomic<std::uint32_t> averageLatencyUs_ = 0;
+  std::atomic<std::uint32_t> maxLatencyUs_ = 0;
+};
+} // namespace AudioPipeline
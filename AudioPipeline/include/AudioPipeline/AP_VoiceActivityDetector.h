@@ -0,0 +1,71 @@
+#pragma once
+
+#include "AudioPipeline/AP_AudioSink.h"
+#include "AudioPipeline/AP_LevelMeter.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace AudioPipeline
+{
+struct VoiceActivityOptions
+{
+  // Blocks whose RMS level stays below this, in dB of full scale, are
+  // silence; a phone mic in a quiet room sits well below it.
+  float thresholdDb = -50.f;
+  // Audio still taken as speech after the last block above the threshold,
+  // so quiet word endings and short pauses are not chopped.
+  std::chrono::milliseconds hangover{300};
+};
+
+struct VoiceActivityStats
+{
+  std::uint64_t framesAnalyzed = 0;
+  std::uint64_t silentFrames = 0;
+  // Times silence turned into speech.
+  std::uint64_t speechOnsets = 0;
+  // Time spent measuring blocks.
+  std::uint64_t detectionNs = 0;
+
+  double silenceRatio() const { return framesAnalyzed == 0 ? 0. : double(silentFrames) / double(framesAnalyzed); }
+};
+
+// Tells silence from speech block by block from the energy of the audio,
+// measured with the SIMD level meter kernels, so the stages after it can
+// take cheaper paths for silence. Any PCM format is measured; a format
+// the meter cannot take leaves every block flagged as speech.
+//
+// All calls but stats() come from the thread frames are delivered on.
+class VoiceActivityDetector final
+{
+public:
+  explicit VoiceActivityDetector(VoiceActivityOptions options = {});
+
+  // Starts over for a new stream; the counters keep accumulating.
+  void setFormat(const PcmFormat& format);
+
+  // Whether the block is silence, hangover included.
+  bool isSilent(const void* data, std::size_t bytes);
+
+  // Safe to call from any thread.
+  VoiceActivityStats stats() const;
+
+private:
+  const VoiceActivityOptions options_;
+  const float threshold_;
+
+  std::optional<LevelMeter> meter_;
+  std::size_t frameBytes_ = 0;
+  std::uint64_t hangoverFrames_ = 0;
+  std::uint64_t hangoverLeft_ = 0;
+  bool isSpeaking_ = false;
+
+  std::atomic<std::uint64_t> framesAnalyzed_ = 0;
+  std::atomic<std::uint64_t> silentFrames_ = 0;
+  std::atomic<std::uint64_t> speechOnsets_ = 0;
+  std::atomic<std::uint64_t> detectionNs_ = 0;
+};
+} // namespace AudioPipeline
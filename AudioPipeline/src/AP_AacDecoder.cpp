@@ -0,0 +1,128 @@
+#include "AudioPipeline/AP_AudioDecoder.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <iterator>
+
+#ifdef AP_HAVE_FDK_AAC
+#include <aacdecoder_lib.h>
+#endif
+
+namespace AudioPipeline
+{
+
+namespace
+{
+constexpr std::array<std::uint32_t, 13> AacSampleRates = {
+    96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000, 12000, 11025, 8000, 7350};
+
+#ifdef AP_HAVE_FDK_AAC
+class FdkAacDecoder final : public AudioDecoder
+{
+public:
+  // Large enough for a 2048 samples HE-AAC frame of 8 channels.
+  static constexpr std::size_t MaxFrameSamples = 2048 * 8;
+
+  explicit FdkAacDecoder(HANDLE_AACDECODER decoder)
+      : decoder_(decoder)
+      , output_(MaxFrameSamples)
+  {
+  }
+
+  ~FdkAacDecoder() override { aacDecoder_Close(decoder_); }
+
+  bool decode(const std::uint8_t* data, std::size_t size, DecodedAudio& output) override
+  {
+    auto* input = const_cast<UCHAR*>(data);
+    const UINT inputSize = static_cast<UINT>(size);
+    UINT bytesValid = inputSize;
+
+    if (aacDecoder_Fill(decoder_, &input, &inputSize, &bytesValid) != AAC_DEC_OK)
+      return false;
+
+    return decodeFrame(0, output);
+  }
+
+  bool conceal(DecodedAudio& output) override
+  {
+    // Needs a frame decoded before, the concealment extrapolates from it.
+    return decodeFrame(AACDEC_CONCEAL, output);
+  }
+
+  void reset() override
+  {
+    aacDecoder_SetParam(decoder_, AAC_TPDEC_CLEAR_BUFFER, 1);
+  }
+
+private:
+  bool decodeFrame(UINT flags, DecodedAudio& output)
+  {
+    if (aacDecoder_DecodeFrame(decoder_, output_.data(), static_cast<INT>(output_.size()), flags) != AAC_DEC_OK)
+      return false;
+
+    const auto* info = aacDecoder_GetStreamInfo(decoder_);
+    if (!info || info->frameSize <= 0 || info->numChannels <= 0)
+      return false;
+
+    output.data = reinterpret_cast<const std::uint8_t*>(output_.data());
+    output.size = std::size_t(info->frameSize) * info->numChannels * sizeof(INT_PCM);
+    output.format = std::endian::native == std::endian::little ? SampleFormat::S16LE : SampleFormat::S16BE;
+    output.sampleRate = info->sampleRate;
+    output.channelsCount = info->numChannels;
+
+    return true;
+  }
+
+private:
+  HANDLE_AACDECODER decoder_;
+  std::vector<INT_PCM> output_;
+};
+#endif
+} // namespace
+
+std::vector<std::uint8_t> makeAacAudioSpecificConfig(std::uint8_t audioObjectType,
+                                                     std::uint32_t sampleRate,
+                                                     std::uint32_t channelsCount)
+{
+  const auto rate = std::find(AacSampleRates.begin(), AacSampleRates.end(), sampleRate);
+  if (rate == AacSampleRates.end() || audioObjectType >= 31 || channelsCount > 7)
+    return {};
+
+  const auto rateIndex = static_cast<std::uint8_t>(std::distance(AacSampleRates.begin(), rate));
+
+  // 5 bits object type, 4 bits sampling frequency index, 4 bits channel
+  // configuration, 3 bits of GASpecificConfig left at zero.
+  return {static_cast<std::uint8_t>(audioObjectType << 3 | rateIndex >> 1),
+          static_cast<std::uint8_t>((rateIndex & 1) << 7 | channelsCount << 3)};
+}
+
+AudioDecoderPtr createAacDecoder(const DecoderConfig& config)
+{
+#ifdef AP_HAVE_FDK_AAC
+  auto codecConfig = config.codecConfig;
+  if (codecConfig.empty())
+    codecConfig = makeAacAudioSpecificConfig(2, config.sampleRate, config.channelsCount);
+  if (codecConfig.empty())
+    return nullptr;
+
+  auto decoder = aacDecoder_Open(TT_MP4_RAW, 1);
+  if (!decoder)
+    return nullptr;
+
+  UCHAR* conf = codecConfig.data();
+  const UINT confSize = static_cast<UINT>(codecConfig.size());
+  if (aacDecoder_ConfigRaw(decoder, &conf, &confSize) != AAC_DEC_OK)
+  {
+    aacDecoder_Close(decoder);
+    return nullptr;
+  }
+
+  return std::make_unique<FdkAacDecoder>(decoder);
+#else
+  (void)config;
+  return nullptr;
+#endif
+}
+
+} // namespace AudioPipeline
@@ -0,0 +1,87 @@
+#include "AP_AsyncResampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace AudioPipeline
+{
+
+void AsyncResampler::reset(std::size_t channelsCount)
+{
+  channelsCount_ = std::max<std::size_t>(channelsCount, 1);
+  step_ = 1.;
+  pending_.clear();
+  position_ = 1.;
+  primed_ = false;
+}
+
+void AsyncResampler::setRatio(double ratio)
+{
+  step_ = 1. / ratio;
+}
+
+std::size_t AsyncResampler::process(const std::uint8_t* input,
+                                    std::size_t framesCount,
+                                    std::vector<std::int16_t>& output)
+{
+  const auto channels = channelsCount_;
+
+  // The very first frame stands in for the one before it.
+  const auto primingFrames = primed_ || framesCount == 0 ? 0 : 1;
+  primed_ = primed_ || framesCount != 0;
+
+  const auto offset = pending_.size();
+  pending_.resize(offset + (framesCount + primingFrames) * channels);
+
+  auto* pending = pending_.data() + offset;
+  for (std::size_t index = 0; index < framesCount * channels; ++index)
+  {
+    std::int16_t sample;
+    std::memcpy(&sample, input + index * sizeof(sample), sizeof(sample));
+    pending[index + primingFrames * channels] = sample;
+  }
+  if (primingFrames != 0)
+    std::copy_n(pending + channels, channels, pending);
+
+  // Interpolating at position p needs frames floor(p) - 1 to floor(p) + 2.
+  const auto availableFrames = pending_.size() / channels;
+  if (position_ + 2. >= double(availableFrames))
+    return 0;
+
+  const auto maxOutputFrames = std::size_t((double(availableFrames) - 2. - position_) / step_) + 1;
+  output.resize(maxOutputFrames * channels);
+
+  std::size_t outputFrames = 0;
+  auto* out = output.data();
+  while (position_ + 2. < double(availableFrames) && outputFrames < maxOutputFrames)
+  {
+    const auto frame = std::size_t(position_);
+    const auto t = float(position_ - double(frame));
+
+    const auto* x = pending_.data() + (frame - 1) * channels;
+    for (std::size_t channel = 0; channel < channels; ++channel)
+    {
+      const auto xm1 = x[channel];
+      const auto x0 = x[channels + channel];
+      const auto x1 = x[2 * channels + channel];
+      const auto x2 = x[3 * channels + channel];
+
+      const auto value =
+          x0 + 0.5f * t * (x1 - xm1 + t * (2.f * xm1 - 5.f * x0 + 4.f * x1 - x2 + t * (3.f * (x0 - x1) + x2 - xm1)));
+      *out++ = static_cast<std::int16_t>(std::clamp(std::lround(value), -32768L, 32767L));
+    }
+
+    position_ += step_;
+    ++outputFrames;
+  }
+
+  // Keep one frame of look-behind.
+  const auto consumedFrames = std::size_t(position_) - 1;
+  pending_.erase(pending_.begin(), pending_.begin() + std::ptrdiff_t(consumedFrames * channels));
+  position_ -= double(consumedFrames);
+
+  return outputFrames;
+}
+
+} // namespace AudioPipeline
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace AudioPipeline
+{
+// Resamples interleaved 16-bit host order PCM by a ratio that may change
+// between calls, with the phase kept continuous across calls. Uses cubic
+// (Catmull-Rom) interpolation, which is transparent for ratios within a
+// fraction of a percent of 1 as used to track clock drift.
+class AsyncResampler final
+{
+public:
+  void reset(std::size_t channelsCount);
+
+  // Output frames produced per input frame.
+  void setRatio(double ratio);
+
+  // Appends the input to what is pending and returns the number of frames
+  // written to the output, which is grown as needed. The input may be
+  // unaligned.
+  std::size_t process(const std::uint8_t* input, std::size_t framesCount, std::vector<std::int16_t>& output);
+
+private:
+  std::size_t channelsCount_ = 1;
+  double step_ = 1.;
+
+  // Input not fully consumed yet, starting one frame before the next
+  // output position, which interpolation looks back at.
+  std::vector<float> pending_;
+  double position_ = 1.;
+  bool primed_ = false;
+};
+} // namespace AudioPipeline
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace AudioPipeline
+{
+// Converts interleaved 16-bit audio between channel counts. Mono is spread
+// to every channel and averaged from them; otherwise channels are matched by
+// position, repeating the input ones if needed.
+inline void convertChannels(const std::int16_t* input,
+                            std::size_t inputChannels,
+                            std::int16_t* output,
+                            std::size_t outputChannels,
+                            std::size_t framesCount)
+{
+  for (std::size_t frame = 0; frame < framesCount; ++frame)
+  {
+    const auto* in = input + frame * inputChannels;
+    auto* out = output + frame * outputChannels;
+
+    if (outputChannels == 1)
+    {
+      int sum = 0;
+      for (std::size_t channel = 0; channel < inputChannels; ++channel)
+        sum += in[channel];
+      out[0] = static_cast<std::int16_t>(sum / int(inputChannels));
+      continue;
+    }
+
+    for (std::size_t channel = 0; channel < outputChannels; ++channel)
+      out[channel] = in[channel % inputChannels];
+  }
+}
+} // namespace AudioPipeline
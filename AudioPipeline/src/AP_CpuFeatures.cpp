@@ -0,0 +1,51 @@
+#include "AP_CpuFeatures.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace AudioPipeline
+{
+
+namespace
+{
+CpuFeatures detectCpuFeatures()
+{
+  CpuFeatures features;
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  int registers[4] = {};
+
+  __cpuid(registers, 0);
+  const int maxLeaf = registers[0];
+
+  __cpuid(registers, 1);
+  features.sse2 = (registers[3] & (1 << 26)) != 0;
+  features.ssse3 = (registers[2] & (1 << 9)) != 0;
+
+  // AVX state has to be enabled by the OS as well, not only by the CPU.
+  const bool osSavesYmm = (registers[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+  if (maxLeaf >= 7 && osSavesYmm)
+  {
+    __cpuidex(registers, 7, 0);
+    features.avx2 = (registers[1] & (1 << 5)) != 0;
+  }
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  features.sse2 = __builtin_cpu_supports("sse2");
+  features.ssse3 = __builtin_cpu_supports("ssse3");
+  features.avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+  return features;
+}
+} // namespace
+
+const CpuFeatures& cpuFeatures()
+{
+  static const CpuFeatures features = detectCpuFeatures();
+  return features;
+}
+
+} // namespace AudioPipeline
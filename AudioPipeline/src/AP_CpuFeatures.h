@@ -0,0 +1,15 @@
+#pragma once
+
+namespace AudioPipeline
+{
+// Instruction sets usable by the current process, detected once. All are
+// false on non-x86 targets. Shared with the Broadcast conversion kernels.
+struct CpuFeatures
+{
+  bool sse2 = false;
+  bool ssse3 = false;
+  bool avx2 = false;
+};
+
+const CpuFeatures& cpuFeatures();
+} // namespace AudioPipeline
@@ -0,0 +1,200 @@
+#include "AudioPipeline/AP_DriftCompensator.h"
+
+#include "AP_AsyncResampler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace AudioPipeline
+{
+
+namespace
+{
+constexpr SampleFormat NativeS16 = std::endian::native == std::endian::little ? SampleFormat::S16LE
+                                                                               : SampleFormat::S16BE;
+
+// Buffer levels of chunked sinks move in steps of a chunk, the controller
+// looks at their average.
+constexpr double BufferSmoothingSeconds = 1.;
+
+// The long-term drift measurement needs this much audio to be meaningful.
+constexpr double MinDriftMeasureSeconds = 10.;
+
+std::uint32_t framesToUs(double frames, std::uint32_t sampleRate)
+{
+  return std::uint32_t(std::clamp(frames * 1e6 / sampleRate, 0., double(UINT32_MAX)));
+}
+} // namespace
+
+DriftCompensator::DriftCompensator(AudioSinkPtr downstream, const DriftCompensationOptions& options)
+    : downstream_(std::move(downstream))
+    , options_(options)
+    , resampler_(std::make_unique<AsyncResampler>())
+{
+}
+
+DriftCompensator::~DriftCompensator() = default;
+
+bool DriftCompensator::start(const PcmFormat& format)
+{
+  if (!downstream_->start(format))
+    return false;
+
+  format_ = format;
+  isCompensating_ = format.sampleFormat == NativeS16 && format.sampleRate != 0 && format.channelsCount != 0
+                    && downstream_->bufferedFrames() >= 0;
+
+  resampler_->reset(format.channelsCount);
+  ratio_ = 1.;
+  pendingSilence_ = 0.;
+  isSilent_ = false;
+  inputFrames_ = 0;
+  outputFrames_ = 0;
+  hasBuffered_ = false;
+  smoothedBufferedFrames_ = 0.;
+  isLocked_ = false;
+  targetFrames_ = 0.;
+  integral_ = 0.;
+
+  driftPpm_.store(0, std::memory_order_relaxed);
+  correctionPpm_.store(0, std::memory_order_relaxed);
+  bufferedUs_.store(0, std::memory_order_relaxed);
+  targetUs_.store(0, std::memory_order_relaxed);
+  isCompensatingStat_.store(isCompensating_, std::memory_order_relaxed);
+
+  return true;
+}
+
+void DriftCompensator::write(const std::uint8_t* data, std::size_t size)
+{
+  if (!isCompensating_)
+  {
+    downstream_->write(data, size);
+    return;
+  }
+
+  if (isSilent_)
+  {
+    resampler_->reset(format_.channelsCount);
+    resampler_->setRatio(ratio_);
+    isSilent_ = false;
+  }
+
+  const auto framesCount = size / format_.bytesPerFrame();
+  updateRatio(framesCount);
+
+  const auto outputFrames = resampler_->process(data, framesCount, output_);
+  outputFrames_ += outputFrames;
+
+  downstream_->write(reinterpret_cast<const std::uint8_t*>(output_.data()), outputFrames * format_.bytesPerFrame());
+}
+
+void DriftCompensator::writeSilence(const std::uint8_t* data, std::size_t size)
+{
+  if (!isCompensating_)
+  {
+    downstream_->writeSilence(data, size);
+    return;
+  }
+
+  const auto framesCount = size / format_.bytesPerFrame();
+  updateRatio(framesCount);
+
+  isSilent_ = true;
+  pendingSilence_ += double(framesCount) * ratio_;
+  const auto outputFrames = std::size_t(pendingSilence_);
+  pendingSilence_ -= double(outputFrames);
+  outputFrames_ += outputFrames;
+
+  output_.assign(outputFrames * format_.channelsCount, 0);
+  downstream_->writeSilence(reinterpret_cast<const std::uint8_t*>(output_.data()), outputFrames * format_.bytesPerFrame());
+}
+
+void DriftCompensator::stop()
+{
+  downstream_->stop();
+  isCompensating_ = false;
+}
+
+std::int64_t DriftCompensator::bufferedFrames() const
+{
+  return downstream_->bufferedFrames();
+}
+
+AudioSinkStats DriftCompensator::stats() const
+{
+  return downstream_->stats();
+}
+
+DriftStats DriftCompensator::driftStats() const
+{
+  constexpr auto Relaxed = std::memory_order_relaxed;
+
+  DriftStats stats;
+  stats.driftPpm = driftPpm_.load(Relaxed);
+  stats.correctionPpm = correctionPpm_.load(Relaxed);
+  stats.bufferedUs = bufferedUs_.load(Relaxed);
+  stats.targetUs = targetUs_.load(Relaxed);
+  stats.isCompensating = isCompensatingStat_.load(Relaxed);
+  return stats;
+}
+
+void DriftCompensator::updateRatio(std::size_t framesCount)
+{
+  const auto buffered = downstream_->bufferedFrames();
+  if (buffered < 0 || framesCount == 0)
+    return;
+
+  const double sampleRate = format_.sampleRate;
+  inputFrames_ += framesCount;
+
+  const auto smoothing = std::min(1., double(framesCount) / (sampleRate * BufferSmoothingSeconds));
+  smoothedBufferedFrames_ = hasBuffered_ ? smoothedBufferedFrames_ + (double(buffered) - smoothedBufferedFrames_) * smoothing
+                                         : double(buffered);
+  hasBuffered_ = true;
+  bufferedUs_.store(framesToUs(smoothedBufferedFrames_, format_.sampleRate), std::memory_order_relaxed);
+
+  if (!isLocked_)
+  {
+    if (double(inputFrames_) < sampleRate * std::chrono::duration<double>(options_.warmUp).count())
+      return;
+
+    isLocked_ = true;
+    targetFrames_ = options_.targetDelay.count() > 0
+                        ? sampleRate * std::chrono::duration<double>(options_.targetDelay).count()
+                        : smoothedBufferedFrames_;
+    targetUs_.store(framesToUs(targetFrames_, format_.sampleRate), std::memory_order_relaxed);
+
+    baselineInputFrames_ = inputFrames_;
+    baselinePlayedFrames_ = double(outputFrames_) - double(buffered);
+  }
+
+  // Whatever went out and is no longer buffered has been played by the
+  // device clock, while the input advances at the stream's clock.
+  const auto measuredInputFrames = double(inputFrames_ - baselineInputFrames_);
+  if (measuredInputFrames >= sampleRate * MinDriftMeasureSeconds)
+  {
+    const auto playedFrames = double(outputFrames_) - double(buffered) - baselinePlayedFrames_;
+    driftPpm_.store(std::int32_t(std::lround((playedFrames / measuredInputFrames - 1.) * 1e6)),
+                    std::memory_order_relaxed);
+  }
+
+  // A draining buffer means the device is faster, the resampler then has
+  // to produce more frames than it gets.
+  const auto maxCorrection = options_.maxCorrectionPpm * 1e-6;
+  const auto errorSeconds = (targetFrames_ - smoothedBufferedFrames_) / sampleRate;
+  const auto elapsedSeconds = double(framesCount) / sampleRate;
+
+  // Critically damped PI controller.
+  const auto proportionalGain = options_.proportionalGain;
+  const auto integralGain = proportionalGain * proportionalGain / 4.;
+  integral_ = std::clamp(integral_ + integralGain * errorSeconds * elapsedSeconds, -maxCorrection, maxCorrection);
+  const auto correction = std::clamp(integral_ + proportionalGain * errorSeconds, -maxCorrection, maxCorrection);
+
+  ratio_ = 1. + correction;
+  resampler_->setRatio(ratio_);
+  correctionPpm_.store(std::int32_t(std::lround(correction * 1e6)), std::memory_order_relaxed);
+}
+
+} // namespace AudioPipeline
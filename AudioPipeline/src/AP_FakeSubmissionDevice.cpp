@@ -0,0 +1,109 @@
+#include "AudioPipeline/AP_SubmissionEngine.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace AudioPipeline
+{
+
+namespace
+{
+class FakeSubmissionDevice final : public SubmissionDevice
+{
+public:
+  explicit FakeSubmissionDevice(std::chrono::microseconds extraLatency)
+      : extraLatency_(extraLatency)
+  {
+  }
+
+  bool open(const PcmFormat& format, std::uint32_t) override
+  {
+    const std::lock_guard<std::mutex> lock(guard_);
+    bytesPerSecond_ = std::uint64_t(format.sampleRate) * format.bytesPerFrame();
+    playhead_ = Clock::now();
+    pending_.clear();
+
+    return bytesPerSecond_ != 0;
+  }
+
+  bool submit(const std::uint8_t*, std::size_t size, std::uint32_t token) override
+  {
+    {
+      const std::lock_guard<std::mutex> lock(guard_);
+
+      // Chunks are played back to back, starting no earlier than now.
+      const auto duration = std::chrono::microseconds(size * 1000000 / bytesPerSecond_);
+      playhead_ = std::max(playhead_, Clock::now()) + duration;
+      pending_.push_back({token, playhead_ + extraLatency_, false});
+    }
+    completed_.notify_one();
+
+    return true;
+  }
+
+  bool waitCompletion(std::chrono::milliseconds timeout, SubmissionCompletion& completion) override
+  {
+    const auto waitDeadline = Clock::now() + timeout;
+
+    std::unique_lock<std::mutex> lock(guard_);
+    while (pending_.empty() || Clock::now() < pending_.front().deadline)
+    {
+      const auto wakeUp = pending_.empty() ? waitDeadline : std::min(waitDeadline, pending_.front().deadline);
+      if (completed_.wait_until(lock, wakeUp) == std::cv_status::timeout && Clock::now() >= waitDeadline)
+        return false;
+    }
+
+    completion.token = pending_.front().token;
+    completion.succeeded = !pending_.front().cancelled;
+    pending_.pop_front();
+
+    return true;
+  }
+
+  void cancel() override
+  {
+    {
+      const std::lock_guard<std::mutex> lock(guard_);
+      for (auto& request : pending_)
+      {
+        request.deadline = Clock::now();
+        request.cancelled = true;
+      }
+    }
+    completed_.notify_one();
+  }
+
+  void close() override
+  {
+    const std::lock_guard<std::mutex> lock(guard_);
+    pending_.clear();
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct PendingRequest
+  {
+    std::uint32_t token;
+    Clock::time_point deadline;
+    bool cancelled;
+  };
+
+  const std::chrono::microseconds extraLatency_;
+
+  std::mutex guard_;
+  std::condition_variable completed_;
+  std::deque<PendingRequest> pending_;
+  std::uint64_t bytesPerSecond_ = 0;
+  Clock::time_point playhead_;
+};
+} // namespace
+
+SubmissionDevicePtr createFakeSubmissionDevice(std::chrono::microseconds extraLatency)
+{
+  return std::make_shared<FakeSubmissionDevice>(extraLatency);
+}
+
+} // namespace AudioPipeline
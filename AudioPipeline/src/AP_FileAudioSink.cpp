@@ -0,0 +1,99 @@
+#include "AudioPipeline/AP_AudioSink.h"
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace AudioPipeline
+{
+
+namespace
+{
+class FileAudioSink final : public PeriodicAudioSink
+{
+public:
+  FileAudioSink(std::string path, std::chrono::microseconds period)
+      : PeriodicAudioSink(period)
+      , path_(std::move(path))
+  {
+  }
+
+  ~FileAudioSink() override { stop(); }
+
+protected:
+  bool openBackend(const PcmFormat&) override
+  {
+    struct stat info = {};
+    isFifo_ = ::stat(path_.c_str(), &info) == 0 && S_ISFIFO(info.st_mode);
+
+    if (!isFifo_)
+    {
+      fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      return fd_ >= 0;
+    }
+
+    // A FIFO may have no reader yet, that is not an error.
+    reopenFifo();
+    return true;
+  }
+
+  bool writePeriod(const std::uint8_t* data, std::size_t size) override
+  {
+    if (fd_ < 0 && isFifo_)
+      reopenFifo();
+    if (fd_ < 0)
+      return false;
+
+    while (size != 0)
+    {
+      const auto written = ::write(fd_, data, size);
+      if (written < 0)
+      {
+        if (errno == EINTR)
+          continue;
+
+        // The reader went away; wait for the next one.
+        if (isFifo_)
+          closeBackend();
+        return false;
+      }
+
+      data += written;
+      size -= written;
+    }
+
+    return true;
+  }
+
+  void closeBackend() override
+  {
+    if (fd_ >= 0)
+      ::close(fd_);
+    fd_ = -1;
+  }
+
+private:
+  void reopenFifo()
+  {
+    // Opening without O_NONBLOCK would wait for a reader. Once connected,
+    // writes block so the reader paces the pipeline.
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_NONBLOCK);
+    if (fd_ >= 0)
+      ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) & ~O_NONBLOCK);
+  }
+
+private:
+  const std::string path_;
+  bool isFifo_ = false;
+  int fd_ = -1;
+};
+} // namespace
+
+AudioSinkPtr createFileAudioSink(const std::string& path, std::chrono::microseconds period)
+{
+  return std::make_shared<FileAudioSink>(path, period);
+}
+
+} // namespace AudioPipeline
@@ -0,0 +1,388 @@
+#include "AP_FlacEncoder.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <limits>
+
+namespace AudioPipeline
+{
+
+namespace
+{
+constexpr std::uint32_t MaxFixedOrder = 4;
+constexpr std::uint32_t MaxPartitionOrder = 8;
+// Largest parameter of the 4-bit Rice coding method, 15 is the escape code.
+constexpr std::uint32_t MaxRiceParameter = 14;
+
+enum ChannelAssignment : std::uint32_t
+{
+  LeftSide = 8,
+  SideRight = 9,
+  MidSide = 10
+};
+
+std::uint8_t crc8(const std::uint8_t* data, std::size_t size)
+{
+  std::uint8_t crc = 0;
+  for (std::size_t index = 0; index < size; ++index)
+  {
+    crc ^= data[index];
+    for (int bit = 0; bit < 8; ++bit)
+      crc = (crc & 0x80) ? std::uint8_t((crc << 1) ^ 0x07) : std::uint8_t(crc << 1);
+  }
+  return crc;
+}
+
+std::uint16_t crc16(const std::uint8_t* data, std::size_t size)
+{
+  static const auto table = [] {
+    std::array<std::uint16_t, 256> result = {};
+    for (std::uint32_t value = 0; value < 256; ++value)
+    {
+      std::uint16_t crc = std::uint16_t(value << 8);
+      for (int bit = 0; bit < 8; ++bit)
+        crc = (crc & 0x8000) ? std::uint16_t((crc << 1) ^ 0x8005) : std::uint16_t(crc << 1);
+      result[value] = crc;
+    }
+    return result;
+  }();
+
+  std::uint16_t crc = 0;
+  for (std::size_t index = 0; index < size; ++index)
+    crc = std::uint16_t((crc << 8) ^ table[(crc >> 8) ^ data[index]]);
+  return crc;
+}
+
+std::int32_t fixedResidual(const std::int32_t* samples, std::size_t index, std::uint32_t order)
+{
+  const auto* x = samples + index;
+  switch (order)
+  {
+    case 0:
+      return x[0];
+    case 1:
+      return x[0] - x[-1];
+    case 2:
+      return x[0] - 2 * x[-1] + x[-2];
+    case 3:
+      return x[0] - 3 * x[-1] + 3 * x[-2] - x[-3];
+    default:
+      return x[0] - 4 * x[-1] + 6 * x[-2] - 4 * x[-3] + x[-4];
+  }
+}
+
+std::uint32_t zigzag(std::int32_t value)
+{
+  return (std::uint32_t(value) << 1) ^ std::uint32_t(value >> 31);
+}
+
+std::uint64_t riceBits(const std::uint32_t* values, std::size_t count, std::uint32_t parameter)
+{
+  std::uint64_t bits = std::uint64_t(count) * (parameter + 1);
+  for (std::size_t index = 0; index < count; ++index)
+    bits += values[index] >> parameter;
+  return bits;
+}
+
+// Best parameter for a partition, starting from the one its mean suggests.
+std::uint32_t riceParameter(const std::uint32_t* values, std::size_t count, std::uint64_t& bits)
+{
+  std::uint64_t sum = 0;
+  for (std::size_t index = 0; index < count; ++index)
+    sum += values[index];
+
+  std::uint32_t guess = 0;
+  while (guess < MaxRiceParameter && (std::uint64_t(count) << (guess + 1)) <= sum)
+    ++guess;
+
+  std::uint32_t best = guess;
+  bits = riceBits(values, count, guess);
+  for (const auto candidate : {guess - 1, guess + 1})
+  {
+    if (candidate > MaxRiceParameter)
+      continue;
+
+    const auto candidateBits = riceBits(values, count, candidate);
+    if (candidateBits < bits)
+    {
+      bits = candidateBits;
+      best = candidate;
+    }
+  }
+  return best;
+}
+} // namespace
+
+class FlacEncoder::BitWriter
+{
+public:
+  explicit BitWriter(std::vector<std::uint8_t>& output)
+      : output_(output)
+  {
+  }
+
+  void write(std::uint32_t value, std::uint32_t bits)
+  {
+    if (bits == 0)
+      return;
+
+    const auto mask = bits == 32 ? std::numeric_limits<std::uint32_t>::max() : (1u << bits) - 1;
+    accumulator_ = (accumulator_ << bits) | (value & mask);
+    pendingBits_ += bits;
+    while (pendingBits_ >= 8)
+    {
+      pendingBits_ -= 8;
+      output_.push_back(std::uint8_t(accumulator_ >> pendingBits_));
+    }
+  }
+
+  void writeSigned(std::int32_t value, std::uint32_t bits) { write(std::uint32_t(value), bits); }
+
+  void writeUnary(std::uint32_t zeros)
+  {
+    for (; zeros >= 24; zeros -= 24)
+      write(0, 24);
+    write(1, zeros + 1);
+  }
+
+  void writeRice(std::uint32_t value, std::uint32_t parameter)
+  {
+    writeUnary(value >> parameter);
+    write(value, parameter);
+  }
+
+  void alignToByte()
+  {
+    if (pendingBits_ != 0)
+      write(0, 8 - pendingBits_);
+  }
+
+private:
+  std::vector<std::uint8_t>& output_;
+  std::uint64_t accumulator_ = 0;
+  std::uint32_t pendingBits_ = 0;
+};
+
+FlacEncoder::FlacEncoder(std::uint32_t sampleRate, std::uint32_t channelsCount, std::uint32_t bitsPerSample)
+    : sampleRate_(sampleRate)
+    , channelsCount_(std::clamp<std::uint32_t>(channelsCount, 1, 8))
+    , bitsPerSample_(std::clamp<std::uint32_t>(bitsPerSample, 8, 24))
+    , mid_(BlockFrames)
+    , side_(BlockFrames)
+    , residual_(BlockFrames)
+{
+}
+
+void FlacEncoder::writeStreamHeader(std::vector<std::uint8_t>& output) const
+{
+  BitWriter writer(output);
+  for (const auto character : {'f', 'L', 'a', 'C'})
+    writer.write(std::uint8_t(character), 8);
+
+  // Last metadata block, STREAMINFO, 34 bytes.
+  writer.write(1, 1);
+  writer.write(0, 7);
+  writer.write(34, 24);
+
+  writer.write(BlockFrames, 16);
+  writer.write(BlockFrames, 16);
+  writer.write(minFrameSize_, 24);
+  writer.write(maxFrameSize_, 24);
+  writer.write(sampleRate_, 20);
+  writer.write(channelsCount_ - 1, 3);
+  writer.write(bitsPerSample_ - 1, 5);
+  writer.write(std::uint32_t(framesEncoded_ >> 32), 4);
+  writer.write(std::uint32_t(framesEncoded_), 32);
+
+  // No MD5 signature of the audio.
+  for (int index = 0; index < 4; ++index)
+    writer.write(0, 32);
+}
+
+void FlacEncoder::encodeFrame(const std::int32_t* samples, std::size_t framesCount, std::vector<std::uint8_t>& output)
+{
+  framesCount = std::min(framesCount, BlockFrames);
+  if (framesCount == 0)
+    return;
+
+  const auto frameStart = output.size();
+  BitWriter writer(output);
+
+  std::uint32_t assignment = channelsCount_ - 1;
+  const auto* first = samples;
+  const auto* second = samples + framesCount;
+  if (channelsCount_ == 2)
+  {
+    for (std::size_t index = 0; index < framesCount; ++index)
+    {
+      side_[index] = first[index] - second[index];
+      mid_[index] = (first[index] + second[index]) >> 1;
+    }
+
+    std::uint32_t order = 0;
+    const auto left = fixedCost(first, framesCount, order);
+    const auto right = fixedCost(second, framesCount, order);
+    const auto side = fixedCost(side_.data(), framesCount, order);
+    const auto mid = fixedCost(mid_.data(), framesCount, order);
+
+    const auto best = std::min({left + right, left + side, side + right, mid + side});
+    if (best == left + side)
+      assignment = LeftSide;
+    else if (best == side + right)
+      assignment = SideRight;
+    else if (best == mid + side)
+      assignment = MidSide;
+  }
+
+  // Frame header, with the block size and sample rate taken from STREAMINFO
+  // or given at its end.
+  writer.write(0xFFF8, 16);
+  writer.write(7, 4);
+  writer.write(0, 4);
+  writer.write(assignment, 4);
+  writer.write(bitsPerSample_ == 8 ? 1 : bitsPerSample_ == 16 ? 4 : bitsPerSample_ == 24 ? 6 : 0, 3);
+  writer.write(0, 1);
+
+  // Frame number, UTF-8 style.
+  const auto number = std::uint32_t(frameNumber_++);
+  if (number < 0x80)
+  {
+    writer.write(number, 8);
+  }
+  else
+  {
+    std::uint32_t extraBytes = number < 0x800 ? 1 : number < 0x10000 ? 2 : number < 0x200000 ? 3 : number < 0x4000000 ? 4 : 5;
+    writer.write((0xFF00u >> (extraBytes + 1)) | (number >> (6 * extraBytes)), 8);
+    while (extraBytes-- != 0)
+      writer.write(0x80 | ((number >> (6 * extraBytes)) & 0x3F), 8);
+  }
+
+  writer.write(std::uint32_t(framesCount - 1), 16);
+  writer.write(crc8(output.data() + frameStart, output.size() - frameStart), 8);
+
+  switch (assignment)
+  {
+    case LeftSide:
+      encodeSubframe(writer, first, framesCount, bitsPerSample_);
+      encodeSubframe(writer, side_.data(), framesCount, bitsPerSample_ + 1);
+      break;
+    case SideRight:
+      encodeSubframe(writer, side_.data(), framesCount, bitsPerSample_ + 1);
+      encodeSubframe(writer, second, framesCount, bitsPerSample_);
+      break;
+    case MidSide:
+      encodeSubframe(writer, mid_.data(), framesCount, bitsPerSample_);
+      encodeSubframe(writer, side_.data(), framesCount, bitsPerSample_ + 1);
+      break;
+    default:
+      for (std::uint32_t channel = 0; channel < channelsCount_; ++channel)
+        encodeSubframe(writer, samples + channel * framesCount, framesCount, bitsPerSample_);
+      break;
+  }
+
+  writer.alignToByte();
+  writer.write(crc16(output.data() + frameStart, output.size() - frameStart), 16);
+
+  const auto frameSize = std::uint32_t(output.size() - frameStart);
+  minFrameSize_ = minFrameSize_ == 0 ? frameSize : std::min(minFrameSize_, frameSize);
+  maxFrameSize_ = std::max(maxFrameSize_, frameSize);
+  framesEncoded_ += framesCount;
+}
+
+std::uint64_t FlacEncoder::fixedCost(const std::int32_t* samples, std::size_t count, std::uint32_t& order)
+{
+  // Sum of magnitudes of each predictor's residual, a good enough proxy for
+  // its coded size.
+  std::array<std::uint64_t, MaxFixedOrder + 1> sums = {};
+  for (std::size_t index = MaxFixedOrder; index < count; ++index)
+  {
+    for (std::uint32_t candidate = 0; candidate <= MaxFixedOrder; ++candidate)
+      sums[candidate] += std::uint32_t(std::abs(fixedResidual(samples, index, candidate)));
+  }
+
+  order = std::uint32_t(std::min_element(sums.begin(), sums.end()) - sums.begin());
+  return sums[order];
+}
+
+void FlacEncoder::encodeSubframe(BitWriter& writer, const std::int32_t* samples, std::size_t count, std::uint32_t bits)
+{
+  if (std::all_of(samples, samples + count, [value = samples[0]](std::int32_t sample) { return sample == value; }))
+  {
+    writer.write(0, 8);
+    writer.writeSigned(samples[0], bits);
+    return;
+  }
+
+  std::uint32_t order = 0;
+  if (count > MaxFixedOrder)
+    fixedCost(samples, count, order);
+  else
+    order = 0;
+
+  for (std::size_t index = order; index < count; ++index)
+    residual_[index] = zigzag(fixedResidual(samples, index, order));
+
+  // Cheapest partitioning of the residual, each partition with its own
+  // Rice parameter.
+  std::uint32_t bestPartitionOrder = 0;
+  std::uint64_t bestBits = std::numeric_limits<std::uint64_t>::max();
+  std::array<std::uint32_t, 1u << MaxPartitionOrder> parameters = {};
+  std::array<std::uint32_t, 1u << MaxPartitionOrder> bestParameters = {};
+  for (std::uint32_t partitionOrder = 0; partitionOrder <= MaxPartitionOrder; ++partitionOrder)
+  {
+    const auto partitions = std::size_t(1) << partitionOrder;
+    const auto partitionSize = count >> partitionOrder;
+    if (count % partitions != 0 || partitionSize <= order)
+      break;
+
+    std::uint64_t bits = 0;
+    for (std::size_t partition = 0; partition < partitions; ++partition)
+    {
+      const auto start = partition == 0 ? order : partition * partitionSize;
+      const auto end = (partition + 1) * partitionSize;
+
+      std::uint64_t partitionBits = 0;
+      parameters[partition] = riceParameter(residual_.data() + start, end - start, partitionBits);
+      bits += 4 + partitionBits;
+    }
+
+    if (bits < bestBits)
+    {
+      bestBits = bits;
+      bestPartitionOrder = partitionOrder;
+      std::copy_n(parameters.begin(), partitions, bestParameters.begin());
+    }
+  }
+
+  const auto fixedBits = std::uint64_t(order) * bits + 6 + bestBits;
+  if (fixedBits >= std::uint64_t(count) * bits)
+  {
+    writer.write(0x02, 8);
+    for (std::size_t index = 0; index < count; ++index)
+      writer.writeSigned(samples[index], bits);
+    return;
+  }
+
+  writer.write(0x10 | (order << 1), 8);
+  for (std::size_t index = 0; index < order; ++index)
+    writer.writeSigned(samples[index], bits);
+
+  writer.write(0, 2);
+  writer.write(bestPartitionOrder, 4);
+
+  const auto partitions = std::size_t(1) << bestPartitionOrder;
+  const auto partitionSize = count >> bestPartitionOrder;
+  for (std::size_t partition = 0; partition < partitions; ++partition)
+  {
+    const auto parameter = bestParameters[partition];
+    writer.write(parameter, 4);
+
+    const auto start = partition == 0 ? order : partition * partitionSize;
+    const auto end = (partition + 1) * partitionSize;
+    for (std::size_t index = start; index < end; ++index)
+      writer.writeRice(residual_[index], parameter);
+  }
+}
+
+} // namespace AudioPipeline
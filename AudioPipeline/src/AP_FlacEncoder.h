@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace AudioPipeline
+{
+// Minimal FLAC encoder: fixed size blocks, fixed predictors with Rice coded
+// residuals and, for stereo, the cheapest of the four channel decorrelation
+// modes. Compresses speech and music about as well as libFLAC's fastest
+// presets without depending on it.
+class FlacEncoder final
+{
+public:
+  static constexpr std::size_t BlockFrames = 4096;
+  static constexpr std::size_t StreamHeaderSize = 42;
+
+  // Up to 8 channels of 8 to 24 bit samples.
+  FlacEncoder(std::uint32_t sampleRate, std::uint32_t channelsCount, std::uint32_t bitsPerSample);
+
+  // "fLaC" and the STREAMINFO block. Written first with what is known up
+  // front, and rewritten in place once the stream is finished.
+  void writeStreamHeader(std::vector<std::uint8_t>& output) const;
+
+  // Encodes one frame of up to BlockFrames frames; only the last frame of a
+  // stream may be shorter. Channels are given one after the other, each
+  // holding framesCount samples. Appends to the output.
+  void encodeFrame(const std::int32_t* samples, std::size_t framesCount, std::vector<std::uint8_t>& output);
+
+  std::uint64_t framesEncoded() const { return framesEncoded_; }
+
+private:
+  class BitWriter;
+
+  void encodeSubframe(BitWriter& writer, const std::int32_t* samples, std::size_t count, std::uint32_t bits);
+  std::uint64_t fixedCost(const std::int32_t* samples, std::size_t count, std::uint32_t& order);
+
+private:
+  const std::uint32_t sampleRate_;
+  const std::uint32_t channelsCount_;
+  const std::uint32_t bitsPerSample_;
+
+  std::uint64_t frameNumber_ = 0;
+  std::uint64_t framesEncoded_ = 0;
+  std::uint32_t minFrameSize_ = 0;
+  std::uint32_t maxFrameSize_ = 0;
+
+  std::vector<std::int32_t> mid_;
+  std::vector<std::int32_t> side_;
+  std::vector<std::uint32_t> residual_;
+};
+} // namespace AudioPipeline
@@ -0,0 +1,69 @@
+#include "AudioPipeline/AP_LevelAccumulator.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace AudioPipeline
+{
+
+LevelAccumulator::LevelAccumulator(SampleFormat format,
+                                   std::uint32_t sampleRate,
+                                   std::uint32_t channelsCount,
+                                   std::uint32_t publishRateHz)
+    : meter_(format)
+    , samplesPerSecond_(std::uint64_t(sampleRate) * channelsCount)
+{
+  setPublishRate(publishRateHz);
+}
+
+void LevelAccumulator::setPublishRate(std::uint32_t publishRateHz)
+{
+  const auto windowSamples = samplesPerSecond_ / std::max<std::uint32_t>(publishRateHz, 1);
+  windowSamples_.store(std::max<std::uint64_t>(windowSamples, 1), std::memory_order_relaxed);
+}
+
+void LevelAccumulator::accumulate(const void* data, std::size_t bytes)
+{
+  meter_.accumulate(data, bytes, window_);
+
+  if (window_.samplesCount >= windowSamples_.load(std::memory_order_relaxed))
+  {
+    publish();
+  }
+}
+
+void LevelAccumulator::accumulateSilence(std::size_t bytes)
+{
+  window_.samplesCount += bytes / bytesPerSample(meter_.format());
+
+  if (window_.samplesCount >= windowSamples_.load(std::memory_order_relaxed))
+  {
+    publish();
+  }
+}
+
+void LevelAccumulator::publish()
+{
+  const auto peak = std::bit_cast<std::uint32_t>(meter_.peakLevel(window_));
+  const auto rms = std::bit_cast<std::uint32_t>(meter_.rmsLevel(window_));
+
+  levels_.store(std::uint64_t(peak) << 32 | rms, std::memory_order_relaxed);
+  clippedCount_.fetch_add(window_.clippedCount, std::memory_order_relaxed);
+  sequence_.fetch_add(1, std::memory_order_release);
+
+  window_ = {};
+}
+
+LevelSnapshot LevelAccumulator::snapshot() const
+{
+  LevelSnapshot snapshot;
+  snapshot.sequence = sequence_.load(std::memory_order_acquire);
+
+  const auto levels = levels_.load(std::memory_order_relaxed);
+  snapshot.peak = std::bit_cast<float>(std::uint32_t(levels >> 32));
+  snapshot.rms = std::bit_cast<float>(std::uint32_t(levels));
+
+  return snapshot;
+}
+
+} // namespace AudioPipeline
@@ -0,0 +1,67 @@
+#include "AudioPipeline/AP_LevelMeter.h"
+
+#include "AP_CpuFeatures.h"
+#include "AP_LevelMeterKernels.h"
+
+#include <cmath>
+
+namespace AudioPipeline
+{
+
+namespace
+{
+LevelKernel selectLevelKernel(SampleFormat format)
+{
+#ifdef AP_HAVE_X86_KERNELS
+  if (cpuFeatures().avx2)
+    return avx2LevelKernel(format);
+  if (cpuFeatures().sse2)
+    return sse2LevelKernel(format);
+#endif
+
+  return levelKernelFor<ScalarLevelKernel>(format);
+}
+} // namespace
+
+void LevelStats::merge(const LevelStats& other)
+{
+  peak = std::max(peak, other.peak);
+  sumOfSquares += other.sumOfSquares;
+  clippedCount += other.clippedCount;
+  samplesCount += other.samplesCount;
+}
+
+LevelMeter::LevelMeter(SampleFormat format)
+    : format_(format)
+    , kernel_(selectLevelKernel(format))
+{
+}
+
+void LevelMeter::accumulate(const void* data, std::size_t bytes, LevelStats& stats) const
+{
+  kernel_(static_cast<const std::uint8_t*>(data), bytes / bytesPerSample(format_), stats);
+}
+
+LevelStats LevelMeter::measure(const void* data, std::size_t bytes) const
+{
+  LevelStats stats;
+  accumulate(data, bytes, stats);
+
+  return stats;
+}
+
+float LevelMeter::peakLevel(const LevelStats& stats) const
+{
+  return std::min(1.f, float(stats.peak) / fullScaleOf(format_));
+}
+
+float LevelMeter::rmsLevel(const LevelStats& stats) const
+{
+  if (stats.samplesCount == 0)
+    return 0.f;
+
+  const auto meanSquare = double(stats.sumOfSquares) / stats.samplesCount;
+  return std::min(1.f, float(std::sqrt(meanSquare) / fullScaleOf(format_)));
+}
+
+} // namespace AudioPipeline
@@ -0,0 +1,112 @@
+#include "AP_LevelMeterKernels.h"
+
+#include <immintrin.h>
+
+#include <bit>
+
+namespace AudioPipeline
+{
+
+namespace
+{
+template <typename Traits>
+struct AVX2LevelKernel
+{
+  // Turns 16 raw 16-bit samples into host order signed values.
+  static __m256i toSigned16(__m256i raw)
+  {
+    if constexpr (!Traits::IsLittleEndian)
+    {
+      const __m256i swapBytes = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                                 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+      raw = _mm256_shuffle_epi8(raw, swapBytes);
+    }
+    if constexpr (!Traits::IsSigned)
+      raw = _mm256_xor_si256(raw, _mm256_set1_epi16(std::int16_t(0x8000)));
+
+    return raw;
+  }
+
+  static void accumulate(const std::uint8_t* data, std::size_t samplesCount, LevelStats& stats)
+  {
+    constexpr std::size_t SamplesPerVector = sizeof(__m256i) / Traits::SampleBytes;
+    const std::size_t vectorsCount = samplesCount / SamplesPerVector;
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i maxValue = _mm256_set1_epi16(std::int16_t(Traits::MaxValue));
+    const __m256i minValue = _mm256_set1_epi16(std::int16_t(Traits::MinValue));
+
+    __m256i highest = minValue;
+    __m256i lowest = maxValue;
+    __m256i sumOfSquares = zero;
+    std::uint64_t clippedCount = 0;
+
+    const auto accumulateLanes = [&](__m256i samples)
+    {
+      highest = _mm256_max_epi16(highest, samples);
+      lowest = _mm256_min_epi16(lowest, samples);
+
+      // Each pair sum is at most 2^31, so the lanes are read back unsigned.
+      const __m256i squares = _mm256_madd_epi16(samples, samples);
+      sumOfSquares = _mm256_add_epi64(sumOfSquares, _mm256_unpacklo_epi32(squares, zero));
+      sumOfSquares = _mm256_add_epi64(sumOfSquares, _mm256_unpackhi_epi32(squares, zero));
+
+      const __m256i clipped =
+          _mm256_or_si256(_mm256_cmpeq_epi16(samples, maxValue), _mm256_cmpeq_epi16(samples, minValue));
+      clippedCount += std::popcount(unsigned(_mm256_movemask_epi8(clipped))) / 2;
+    };
+
+    for (std::size_t index = 0; index < vectorsCount; ++index, data += sizeof(__m256i))
+    {
+      if constexpr (Traits::SampleBytes == 1)
+      {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + sizeof(__m128i)));
+
+        if constexpr (!Traits::IsSigned)
+        {
+          low = _mm_xor_si128(low, _mm_set1_epi8(std::int8_t(0x80)));
+          high = _mm_xor_si128(high, _mm_set1_epi8(std::int8_t(0x80)));
+        }
+
+        accumulateLanes(_mm256_cvtepi8_epi16(low));
+        accumulateLanes(_mm256_cvtepi8_epi16(high));
+      }
+      else
+      {
+        accumulateLanes(toSigned16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data))));
+      }
+    }
+
+    alignas(32) std::int16_t highestLanes[16];
+    alignas(32) std::int16_t lowestLanes[16];
+    alignas(32) std::uint64_t sumLanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(highestLanes), highest);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lowestLanes), lowest);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(sumLanes), sumOfSquares);
+
+    std::uint32_t peak = stats.peak;
+    for (std::size_t lane = 0; lane < 16; ++lane)
+    {
+      peak = std::max<std::uint32_t>(peak, std::abs(std::int32_t(highestLanes[lane])));
+      peak = std::max<std::uint32_t>(peak, std::abs(std::int32_t(lowestLanes[lane])));
+    }
+
+    const std::size_t vectorizedCount = vectorsCount * SamplesPerVector;
+    if (vectorizedCount != 0)
+      stats.peak = peak;
+    stats.sumOfSquares += sumLanes[0] + sumLanes[1] + sumLanes[2] + sumLanes[3];
+    stats.clippedCount += clippedCount;
+    stats.samplesCount += vectorizedCount;
+
+    ScalarLevelKernel<Traits>::accumulate(data, samplesCount - vectorizedCount, stats);
+  }
+};
+} // namespace
+
+LevelKernel avx2LevelKernel(SampleFormat format)
+{
+  return levelKernelFor<AVX2LevelKernel>(format);
+}
+
+} // namespace AudioPipeline
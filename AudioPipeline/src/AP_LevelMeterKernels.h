@@ -0,0 +1,94 @@
+#pragma once
+
+#include "AudioPipeline/AP_LevelMeter.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+namespace AudioPipeline
+{
+using LevelKernel = void (*)(const std::uint8_t* data, std::size_t samplesCount, LevelStats& stats);
+
+// Compile-time description of a sample encoding; load() yields the sample
+// as a signed value centered at zero.
+template <std::size_t Bytes, bool Signed, bool LittleEndian>
+struct SampleTraits
+{
+  static constexpr std::size_t SampleBytes = Bytes;
+  static constexpr bool IsSigned = Signed;
+  static constexpr bool IsLittleEndian = LittleEndian;
+
+  static constexpr std::int32_t MaxValue = Bytes == 1 ? 127 : 32767;
+  static constexpr std::int32_t MinValue = -MaxValue - 1;
+
+  static std::int32_t load(const std::uint8_t* sample)
+  {
+    std::uint32_t raw = sample[0];
+    if constexpr (Bytes == 2)
+    {
+      raw = LittleEndian ? raw | std::uint32_t(sample[1]) << 8 : raw << 8 | sample[1];
+    }
+
+    if constexpr (!Signed)
+      return std::int32_t(raw) - (MaxValue + 1);
+    else if constexpr (Bytes == 1)
+      return std::int8_t(raw);
+    else
+      return std::int16_t(raw);
+  }
+};
+
+template <typename Traits>
+struct ScalarLevelKernel
+{
+  static void accumulate(const std::uint8_t* data, std::size_t samplesCount, LevelStats& stats)
+  {
+    std::uint32_t peak = stats.peak;
+    std::uint64_t sumOfSquares = 0;
+    std::uint64_t clippedCount = 0;
+
+    for (std::size_t index = 0; index < samplesCount; ++index, data += Traits::SampleBytes)
+    {
+      const auto value = Traits::load(data);
+
+      peak = std::max<std::uint32_t>(peak, std::abs(value));
+      sumOfSquares += std::uint32_t(value * value);
+      clippedCount += value == Traits::MaxValue || value == Traits::MinValue;
+    }
+
+    stats.peak = peak;
+    stats.sumOfSquares += sumOfSquares;
+    stats.clippedCount += clippedCount;
+    stats.samplesCount += samplesCount;
+  }
+};
+
+template <template <typename> typename Kernel>
+LevelKernel levelKernelFor(SampleFormat format)
+{
+  switch (format)
+  {
+    case SampleFormat::U8:
+      return &Kernel<SampleTraits<1, false, true>>::accumulate;
+    case SampleFormat::S8:
+      return &Kernel<SampleTraits<1, true, true>>::accumulate;
+    case SampleFormat::U16LE:
+      return &Kernel<SampleTraits<2, false, true>>::accumulate;
+    case SampleFormat::U16BE:
+      return &Kernel<SampleTraits<2, false, false>>::accumulate;
+    case SampleFormat::S16LE:
+      return &Kernel<SampleTraits<2, true, true>>::accumulate;
+    case SampleFormat::S16BE:
+      return &Kernel<SampleTraits<2, true, false>>::accumulate;
+  }
+
+  return nullptr;
+}
+
+#ifdef AP_HAVE_X86_KERNELS
+LevelKernel sse2LevelKernel(SampleFormat format);
+LevelKernel avx2LevelKernel(SampleFormat format);
+#endif
+} // namespace AudioPipeline
@@ -0,0 +1,104 @@
+#include "AP_LevelMeterKernels.h"
+
+#include <emmintrin.h>
+
+#include <bit>
+
+namespace AudioPipeline
+{
+
+namespace
+{
+template <typename Traits>
+struct SSE2LevelKernel
+{
+  // Turns 8 raw 16-bit samples into host order signed values.
+  static __m128i toSigned16(__m128i raw)
+  {
+    if constexpr (!Traits::IsLittleEndian)
+      raw = _mm_or_si128(_mm_slli_epi16(raw, 8), _mm_srli_epi16(raw, 8));
+    if constexpr (!Traits::IsSigned)
+      raw = _mm_xor_si128(raw, _mm_set1_epi16(std::int16_t(0x8000)));
+
+    return raw;
+  }
+
+  static void accumulate(const std::uint8_t* data, std::size_t samplesCount, LevelStats& stats)
+  {
+    constexpr std::size_t SamplesPerVector = sizeof(__m128i) / Traits::SampleBytes;
+    const std::size_t vectorsCount = samplesCount / SamplesPerVector;
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i maxValue = _mm_set1_epi16(std::int16_t(Traits::MaxValue));
+    const __m128i minValue = _mm_set1_epi16(std::int16_t(Traits::MinValue));
+
+    __m128i highest = minValue;
+    __m128i lowest = maxValue;
+    __m128i sumOfSquares = zero;
+    std::uint64_t clippedCount = 0;
+
+    const auto accumulateLanes = [&](__m128i samples)
+    {
+      highest = _mm_max_epi16(highest, samples);
+      lowest = _mm_min_epi16(lowest, samples);
+
+      // Each pair sum is at most 2^31, so the lanes are read back unsigned.
+      const __m128i squares = _mm_madd_epi16(samples, samples);
+      sumOfSquares = _mm_add_epi64(sumOfSquares, _mm_unpacklo_epi32(squares, zero));
+      sumOfSquares = _mm_add_epi64(sumOfSquares, _mm_unpackhi_epi32(squares, zero));
+
+      const __m128i clipped = _mm_or_si128(_mm_cmpeq_epi16(samples, maxValue), _mm_cmpeq_epi16(samples, minValue));
+      clippedCount += std::popcount(unsigned(_mm_movemask_epi8(clipped))) / 2;
+    };
+
+    for (std::size_t index = 0; index < vectorsCount; ++index, data += sizeof(__m128i))
+    {
+      __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+
+      if constexpr (Traits::SampleBytes == 1)
+      {
+        if constexpr (!Traits::IsSigned)
+          raw = _mm_xor_si128(raw, _mm_set1_epi8(std::int8_t(0x80)));
+
+        // Sign extends every byte into a 16-bit lane.
+        accumulateLanes(_mm_srai_epi16(_mm_unpacklo_epi8(raw, raw), 8));
+        accumulateLanes(_mm_srai_epi16(_mm_unpackhi_epi8(raw, raw), 8));
+      }
+      else
+      {
+        accumulateLanes(toSigned16(raw));
+      }
+    }
+
+    alignas(16) std::int16_t highestLanes[8];
+    alignas(16) std::int16_t lowestLanes[8];
+    alignas(16) std::uint64_t sumLanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(highestLanes), highest);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lowestLanes), lowest);
+    _mm_store_si128(reinterpret_cast<__m128i*>(sumLanes), sumOfSquares);
+
+    std::uint32_t peak = stats.peak;
+    for (std::size_t lane = 0; lane < 8; ++lane)
+    {
+      peak = std::max<std::uint32_t>(peak, std::abs(std::int32_t(highestLanes[lane])));
+      peak = std::max<std::uint32_t>(peak, std::abs(std::int32_t(lowestLanes[lane])));
+    }
+
+    const std::size_t vectorizedCount = vectorsCount * SamplesPerVector;
+    if (vectorizedCount != 0)
+      stats.peak = peak;
+    stats.sumOfSquares += sumLanes[0] + sumLanes[1];
+    stats.clippedCount += clippedCount;
+    stats.samplesCount += vectorizedCount;
+
+    ScalarLevelKernel<Traits>::accumulate(data, samplesCount - vectorizedCount, stats);
+  }
+};
+} // namespace
+
+LevelKernel sse2LevelKernel(SampleFormat format)
+{
+  return levelKernelFor<SSE2LevelKernel>(format);
+}
+
+} // namespace AudioPipeline
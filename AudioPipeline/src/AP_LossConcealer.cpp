@@ -0,0 +1,355 @@
+#include "AudioPipeline/AP_LossConcealer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace AudioPipeline
+{
+
+namespace
+{
+// Pitch periods searched for, 2.5 ms to 15 ms, cover voices and most
+// instruments.
+constexpr std::uint32_t MaxPitchHz = 400;
+constexpr std::uint32_t MinPitchHz = 66;
+
+// As in G.711 Appendix I, the repeated waveform is played at full level
+// for a while and then faded out, longer gaps end up silent.
+constexpr std::uint32_t FullGainMs = 10;
+constexpr std::uint32_t FadeOutMs = 50;
+
+// Gaps longer than this are a new timeline rather than a loss.
+constexpr std::uint32_t MaxGapMs = 1000;
+
+// Shortest cross-fade back into received audio.
+constexpr std::uint32_t MinFadeInMs = 1;
+
+constexpr SampleFormat NativeS16 = std::endian::native == std::endian::little ? SampleFormat::S16LE
+                                                                               : SampleFormat::S16BE;
+} // namespace
+
+void LossConcealer::setFormat(const PcmFormat& format)
+{
+  clockRate_ = format.sampleRate;
+  applyFormat(format);
+  reset();
+}
+
+void LossConcealer::updateFormat(const PcmFormat& format)
+{
+  if (format == format_)
+    return;
+
+  applyFormat(format);
+
+  // The history is of the old format; gaps are repeated from new audio.
+  concealing_ = false;
+  history_.clear();
+}
+
+void LossConcealer::applyFormat(const PcmFormat& format)
+{
+  format_ = format;
+  enabled_ = format.sampleFormat == NativeS16 && format.sampleRate != 0 && format.channelsCount != 0;
+  channelsCount_ = std::max<std::size_t>(format.channelsCount, 1);
+
+  minPeriod_ = std::max<std::size_t>(format.sampleRate / MaxPitchHz, 1);
+  maxPeriod_ = std::max<std::size_t>(format.sampleRate / MinPitchHz, 1);
+  historyFrames_ = maxPeriod_ * 3;
+  fullGainFrames_ = std::size_t(format.sampleRate) * FullGainMs / 1000;
+  fadeOutFrames_ = std::max<std::size_t>(std::size_t(format.sampleRate) * FadeOutMs / 1000, 1);
+  maxGapFrames_ = std::size_t(format.sampleRate) * MaxGapMs / 1000;
+
+  if (!enabled_)
+    return;
+
+  history_.reserve(historyFrames_ * channelsCount_);
+  period_.reserve(maxPeriod_ * channelsCount_);
+  mono_.reserve(historyFrames_);
+}
+
+void LossConcealer::setNativeConcealment(NativeConcealment concealment)
+{
+  nativeConcealment_ = std::move(concealment);
+}
+
+LossConcealer::Gap LossConcealer::onPacket(std::uint16_t sequenceNumber, std::uint32_t rtpTimestamp)
+{
+  Gap gap;
+
+  if (!hasPacket_)
+  {
+    hasPacket_ = true;
+    lastSequenceNumber_ = sequenceNumber;
+    packetTimestamp_ = rtpTimestamp;
+    packetFrames_ = 0;
+    return gap;
+  }
+
+  const auto delta = static_cast<std::int16_t>(std::uint16_t(sequenceNumber - lastSequenceNumber_));
+
+  // Another codec frame of the current packet.
+  if (delta == 0)
+    return gap;
+
+  if (delta < 0)
+  {
+    discardedPackets_.fetch_add(1, std::memory_order_relaxed);
+    gap.discardPacket = true;
+    return gap;
+  }
+
+  // Timestamps count in the RTP clock, frames in the decoded sample rate.
+  const auto toClock = [this](std::uint64_t frames) {
+    return clockRate_ == 0 || clockRate_ == format_.sampleRate ? frames : frames * clockRate_ / format_.sampleRate;
+  };
+  const auto toFrames = [this](std::int64_t ticks) {
+    return clockRate_ == 0 || clockRate_ == format_.sampleRate ? ticks : ticks * format_.sampleRate / clockRate_;
+  };
+
+  const auto expectedTimestamp = packetTimestamp_ + std::uint32_t(toClock(packetFrames_));
+  const auto missingFrames = std::int32_t(toFrames(static_cast<std::int32_t>(rtpTimestamp - expectedTimestamp)));
+
+  lastSequenceNumber_ = sequenceNumber;
+  packetTimestamp_ = rtpTimestamp;
+  packetFrames_ = 0;
+
+  // Timestamp jumps between consecutive packets are the sender's doing,
+  // e.g. silence suppression, and are not concealed.
+  if (delta == 1)
+    return gap;
+
+  lostPackets_.fetch_add(std::uint64_t(delta - 1), std::memory_order_relaxed);
+
+  if (!enabled_ || missingFrames <= 0 || std::size_t(missingFrames) > maxGapFrames_)
+    return gap;
+
+  conceal(std::size_t(missingFrames));
+
+  concealmentEvents_.fetch_add(1, std::memory_order_relaxed);
+  concealedFrames_.fetch_add(std::uint64_t(missingFrames), std::memory_order_relaxed);
+
+  gap.data = reinterpret_cast<const std::uint8_t*>(output_.data());
+  gap.size = std::size_t(missingFrames) * channelsCount_ * sizeof(std::int16_t);
+  return gap;
+}
+
+const std::uint8_t* LossConcealer::onAudio(const std::uint8_t* data, std::size_t size)
+{
+  const auto framesCount = size / (channelsCount_ * sizeof(std::int16_t));
+  packetFrames_ += framesCount;
+
+  if (!enabled_ || framesCount == 0)
+    return data;
+
+  if (!concealing_)
+  {
+    appendHistory(data, framesCount);
+    return data;
+  }
+
+  // Cross-fades from the continued concealment into the received audio.
+  concealing_ = false;
+
+  const auto fadeFrames = std::min(std::max(periodFrames_ / 4, std::size_t(format_.sampleRate) * MinFadeInMs / 1000),
+                                   framesCount);
+
+  output_.resize(framesCount * channelsCount_);
+  std::memcpy(output_.data(), data, framesCount * channelsCount_ * sizeof(std::int16_t));
+
+  fade_.resize(fadeFrames * channelsCount_);
+  synthesize(fade_.data(), fadeFrames);
+
+  for (std::size_t frame = 0; frame < fadeFrames; ++frame)
+  {
+    const auto weight = float(frame + 1) / float(fadeFrames + 1);
+    for (std::size_t channel = 0; channel < channelsCount_; ++channel)
+    {
+      const auto index = frame * channelsCount_ + channel;
+      const auto mixed = float(fade_[index]) * (1.f - weight) + float(output_[index]) * weight;
+      output_[index] = static_cast<std::int16_t>(std::lround(mixed));
+    }
+  }
+
+  appendHistory(output_.data(), framesCount);
+  return reinterpret_cast<const std::uint8_t*>(output_.data());
+}
+
+void LossConcealer::reset()
+{
+  hasPacket_ = false;
+  packetFrames_ = 0;
+  concealing_ = false;
+  history_.clear();
+}
+
+ConcealmentStats LossConcealer::stats() const
+{
+  constexpr auto Relaxed = std::memory_order_relaxed;
+
+  ConcealmentStats stats;
+  stats.lostPackets = lostPackets_.load(Relaxed);
+  stats.concealmentEvents = concealmentEvents_.load(Relaxed);
+  stats.concealedFrames = concealedFrames_.load(Relaxed);
+  stats.discardedPackets = discardedPackets_.load(Relaxed);
+  return stats;
+}
+
+void LossConcealer::conceal(std::size_t framesCount)
+{
+  output_.resize(framesCount * channelsCount_);
+
+  if (nativeConcealment_)
+  {
+    concealNatively(framesCount);
+  }
+  else
+  {
+    if (!concealing_)
+      startSynthesis();
+
+    synthesize(output_.data(), framesCount);
+  }
+
+  appendHistory(output_.data(), framesCount);
+}
+
+void LossConcealer::concealNatively(std::size_t framesCount)
+{
+  std::size_t concealedFrames = 0;
+
+  DecodedAudio decoded;
+  while (concealedFrames < framesCount && nativeConcealment_(decoded))
+  {
+    if (decoded.format != NativeS16 || decoded.channelsCount != channelsCount_)
+      break;
+
+    const auto decodedFrames = decoded.size / (channelsCount_ * sizeof(std::int16_t));
+    if (decodedFrames == 0)
+      break;
+
+    const auto copiedFrames = std::min(decodedFrames, framesCount - concealedFrames);
+    std::memcpy(output_.data() + concealedFrames * channelsCount_,
+                decoded.data,
+                copiedFrames * channelsCount_ * sizeof(std::int16_t));
+    concealedFrames += copiedFrames;
+  }
+
+  // Whatever the codec could not produce is repeated from the waveform.
+  if (concealedFrames < framesCount)
+  {
+    if (!concealing_)
+      startSynthesis();
+
+    synthesize(output_.data() + concealedFrames * channelsCount_, framesCount - concealedFrames);
+  }
+}
+
+void LossConcealer::startSynthesis()
+{
+  concealing_ = true;
+  synthesizedFrames_ = 0;
+  periodPosition_ = 0;
+
+  periodFrames_ = estimatePeriod();
+
+  const auto historyFrames = history_.size() / channelsCount_;
+  period_.assign(history_.end() - std::ptrdiff_t(std::min(periodFrames_, historyFrames) * channelsCount_),
+                 history_.end());
+}
+
+void LossConcealer::synthesize(std::int16_t* output, std::size_t framesCount)
+{
+  if (periodFrames_ == 0)
+  {
+    std::fill_n(output, framesCount * channelsCount_, std::int16_t(0));
+    synthesizedFrames_ += framesCount;
+    return;
+  }
+
+  for (std::size_t frame = 0; frame < framesCount; ++frame)
+  {
+    float gain = 1.f;
+    if (synthesizedFrames_ >= fullGainFrames_)
+      gain = std::max(0.f, 1.f - float(synthesizedFrames_ - fullGainFrames_) / float(fadeOutFrames_));
+
+    const auto* source = period_.data() + periodPosition_ * channelsCount_;
+    for (std::size_t channel = 0; channel < channelsCount_; ++channel)
+    {
+      *output++ = static_cast<std::int16_t>(float(source[channel]) * gain);
+    }
+
+    periodPosition_ = (periodPosition_ + 1) % periodFrames_;
+    ++synthesizedFrames_;
+  }
+}
+
+void LossConcealer::appendHistory(const void* samples, std::size_t framesCount)
+{
+  const auto keptFrames = std::min(framesCount, historyFrames_);
+  const auto* source = static_cast<const std::int16_t*>(samples) + (framesCount - keptFrames) * channelsCount_;
+
+  const auto overflow = history_.size() + keptFrames * channelsCount_;
+  const auto capacity = historyFrames_ * channelsCount_;
+  if (overflow > capacity)
+    history_.erase(history_.begin(), history_.begin() + std::ptrdiff_t(overflow - capacity));
+
+  const auto offset = history_.size();
+  history_.resize(offset + keptFrames * channelsCount_);
+  std::memcpy(history_.data() + offset, source, keptFrames * channelsCount_ * sizeof(std::int16_t));
+}
+
+std::size_t LossConcealer::estimatePeriod()
+{
+  const auto framesCount = history_.size() / channelsCount_;
+  if (framesCount < minPeriod_ * 2)
+    return framesCount;
+
+  // Channels are summed, the period is shared by all of them.
+  auto& mono = mono_;
+  mono.resize(framesCount);
+  for (std::size_t frame = 0; frame < framesCount; ++frame)
+  {
+    float sum = 0.f;
+    for (std::size_t channel = 0; channel < channelsCount_; ++channel)
+      sum += history_[frame * channelsCount_ + channel];
+    mono[frame] = sum;
+  }
+
+  // Normalized cross-correlation of the most recent window with the one a
+  // candidate period earlier; the best match is the pitch period.
+  const auto longestPeriod = std::min(maxPeriod_, framesCount / 2);
+  const auto window = std::min(maxPeriod_, framesCount - longestPeriod);
+  const auto* recent = mono.data() + framesCount - window;
+
+  std::size_t bestPeriod = longestPeriod;
+  float bestScore = -1.f;
+  for (auto period = minPeriod_; period <= longestPeriod; ++period)
+  {
+    const auto* earlier = recent - period;
+
+    float correlation = 0.f;
+    float energy = 0.f;
+    for (std::size_t index = 0; index < window; ++index)
+    {
+      correlation += recent[index] * earlier[index];
+      energy += earlier[index] * earlier[index];
+    }
+
+    if (energy <= 0.f)
+      continue;
+
+    const auto score = correlation / std::sqrt(energy);
+    if (score > bestScore)
+    {
+      bestScore = score;
+      bestPeriod = period;
+    }
+  }
+
+  return bestPeriod;
+}
+
+} // namespace AudioPipeline
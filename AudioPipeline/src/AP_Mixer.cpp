@@ -0,0 +1,479 @@
+#include "AudioPipeline/AP_Mixer.h"
+
+#include "AP_ChannelConversion.h"
+#include "AP_CpuFeatures.h"
+#include "AP_MixerKernels.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace AudioPipeline
+{
+
+namespace
+{
+constexpr SampleFormat NativeS16 = std::endian::native == std::endian::little ? SampleFormat::S16LE
+                                                                               : SampleFormat::S16BE;
+
+// Conversion buffers are sized for this much input when started and only
+// grow for longer writes.
+constexpr std::uint32_t PreallocatedBlockMs = 100;
+
+// Faster than the drift compensation of a device, whose clock is close to
+// ours: the queue has only the delay as margin and phone clocks can be off
+// by much more. Settles in about 15 s, a drift of 3000 ppm then builds up
+// no more than 15 ms in the queue.
+constexpr double InputCorrectionGain = 0.15;
+
+std::size_t framesOf(std::uint32_t sampleRate, std::chrono::milliseconds duration)
+{
+  return std::size_t(sampleRate) * std::size_t(duration.count()) / 1000;
+}
+
+AccumulateKernel selectAccumulate()
+{
+#ifdef AP_HAVE_X86_KERNELS
+  if (cpuFeatures().avx2)
+    return &avx2Accumulate;
+  if (cpuFeatures().sse2)
+    return &sse2Accumulate;
+#endif
+
+  return &scalarAccumulate;
+}
+
+StoreKernel selectStore()
+{
+#ifdef AP_HAVE_X86_KERNELS
+  if (cpuFeatures().avx2)
+    return &avx2Store;
+  if (cpuFeatures().sse2)
+    return &sse2Store;
+#endif
+
+  return &scalarStore;
+}
+} // namespace
+
+class MixerInput::Queue final : public AudioSink
+{
+public:
+  explicit Queue(MixerInput& input)
+      : input_(input)
+  {
+  }
+
+  bool start(const PcmFormat&) override { return true; }
+
+  // The drift compensation writes from buffers of its own, which are
+  // aligned.
+  void write(const std::uint8_t* data, std::size_t size) override { push(data, size, false); }
+  void writeSilence(const std::uint8_t* data, std::size_t size) override { push(data, size, true); }
+  void stop() override {}
+
+  // Nothing is corrected before the input joins the mix at the delay.
+  std::int64_t bufferedFrames() const override
+  {
+    return input_.isMixed_.load(std::memory_order_relaxed)
+               ? std::int64_t(input_.mixerQueuedFrames_.load(std::memory_order_relaxed))
+               : std::int64_t(input_.delayFrames_);
+  }
+  AudioSinkStats stats() const override { return input_.stats(); }
+
+private:
+  void push(const std::uint8_t* data, std::size_t size, bool isSilent)
+  {
+    const auto framesCount = size / (input_.channelsCount_ * sizeof(std::int16_t));
+    input_.push(reinterpret_cast<const std::int16_t*>(data), framesCount, isSilent);
+  }
+
+  MixerInput& input_;
+};
+
+MixerInput::MixerInput(const MixerOptions& options)
+    : channelsCount_(std::max<std::uint32_t>(1, options.channelsCount))
+    , sampleRate_(options.sampleRate)
+    , delayFrames_(std::max(framesOf(options.sampleRate, options.inputDelay), std::max<std::size_t>(1, framesOf(options.sampleRate, options.blockDuration))))
+    // Room for the delay twice over, the point where the input is brought
+    // back to it, and some slack for the producer's bursts.
+    , capacityFrames_(4 * delayFrames_ + 2 * framesOf(options.sampleRate, options.blockDuration))
+    , ring_(std::make_unique<std::int16_t[]>(capacityFrames_ * channelsCount_))
+{
+  DriftCompensationOptions driftOptions;
+  driftOptions.targetDelay = std::chrono::microseconds(std::uint64_t(delayFrames_) * 1'000'000 / std::max<std::uint32_t>(1, sampleRate_));
+  driftOptions.maxCorrectionPpm = options.maxCorrectionPpm;
+  driftOptions.proportionalGain = InputCorrectionGain;
+  driftCompensator_ = std::make_shared<DriftCompensator>(std::make_shared<Queue>(*this), driftOptions);
+}
+
+MixerInput::~MixerInput() = default;
+
+bool MixerInput::start(const PcmFormat& format)
+{
+  started_ = false;
+  isStarted_.store(false, std::memory_order_relaxed);
+  resampler_.reset();
+
+  if (format.sampleFormat != NativeS16 || format.sampleRate == 0 || format.channelsCount == 0 || sampleRate_ == 0)
+  {
+    formatsRejected_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  format_ = format;
+  if (format.sampleRate != sampleRate_)
+    resampler_.emplace(format.sampleRate, sampleRate_, format.channelsCount);
+
+  const auto chunkFrames = resampler_ ? resampler_->maxOutputFrames(Resampler::MaxBlockFrames) + 1 : Resampler::MaxBlockFrames;
+  input_.reserve(std::size_t(format.sampleRate) * PreallocatedBlockMs / 1000 * format.channelsCount);
+  resampled_.resize(chunkFrames * format.channelsCount);
+  converted_.resize(chunkFrames * channelsCount_);
+
+  // Measures the clock of the new stream from scratch.
+  driftCompensator_->start({NativeS16, sampleRate_, std::uint32_t(channelsCount_)});
+
+  started_ = true;
+  isStarted_.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void MixerInput::write(const std::uint8_t* data, std::size_t size)
+{
+  writeAudio(data, size, false);
+}
+
+void MixerInput::writeSilence(const std::uint8_t* data, std::size_t size)
+{
+  writeAudio(data, size, true);
+}
+
+void MixerInput::writeAudio(const std::uint8_t* data, std::size_t size, bool isSilent)
+{
+  if (!started_)
+    return;
+
+  const std::size_t channels = format_.channelsCount;
+  const auto framesCount = size / (channels * sizeof(std::int16_t));
+
+  // The conversions read whole samples.
+  const auto* samples = reinterpret_cast<const std::int16_t*>(data);
+  if (reinterpret_cast<std::uintptr_t>(data) % alignof(std::int16_t) != 0)
+  {
+    input_.resize(framesCount * channels);
+    std::memcpy(input_.data(), data, framesCount * channels * sizeof(std::int16_t));
+    samples = input_.data();
+  }
+
+  for (std::size_t frame = 0; frame < framesCount; frame += Resampler::MaxBlockFrames)
+  {
+    const auto* chunk = samples + frame * channels;
+    auto chunkFrames = std::min(Resampler::MaxBlockFrames, framesCount - frame);
+
+    if (resampler_)
+    {
+      chunkFrames = resampler_->process(chunk, chunkFrames, resampled_.data());
+      chunk = resampled_.data();
+    }
+
+    if (channels != channelsCount_)
+    {
+      convertChannels(chunk, channels, converted_.data(), channelsCount_, chunkFrames);
+      chunk = converted_.data();
+    }
+
+    const auto* bytes = reinterpret_cast<const std::uint8_t*>(chunk);
+    const auto bytesCount = chunkFrames * channelsCount_ * sizeof(std::int16_t);
+    if (isSilent)
+      driftCompensator_->writeSilence(bytes, bytesCount);
+    else
+      driftCompensator_->write(bytes, bytesCount);
+  }
+
+  lastWriteFrames_.store(std::uint32_t(std::uint64_t(framesCount) * sampleRate_ / format_.sampleRate), std::memory_order_relaxed);
+  writes_.fetch_add(1, std::memory_order_relaxed);
+  framesReceived_.fetch_add(framesCount, std::memory_order_relaxed);
+  bytesReceived_.fetch_add(size, std::memory_order_relaxed);
+}
+
+void MixerInput::stop()
+{
+  // What is queued still plays out.
+  started_ = false;
+  isStarted_.store(false, std::memory_order_relaxed);
+  resampler_.reset();
+  driftCompensator_->stop();
+}
+
+void MixerInput::push(const std::int16_t* samples, std::size_t framesCount, bool isSilent)
+{
+  const auto writeFrame = writeFrame_.load(std::memory_order_relaxed);
+  const auto queued = std::size_t(writeFrame - readFrame_.load(std::memory_order_acquire));
+
+  // Only happens when the mixer thread stalls; what does not fit is lost.
+  const auto space = capacityFrames_ - queued;
+  if (framesCount > space)
+  {
+    framesDropped_.fetch_add(framesCount - space, std::memory_order_relaxed);
+    framesCount = space;
+  }
+
+  const auto offset = std::size_t(writeFrame % capacityFrames_);
+  const auto head = std::min(framesCount, capacityFrames_ - offset);
+  std::memcpy(ring_.get() + offset * channelsCount_, samples, head * channelsCount_ * sizeof(std::int16_t));
+  std::memcpy(ring_.get(), samples + head * channelsCount_, (framesCount - head) * channelsCount_ * sizeof(std::int16_t));
+
+  if (!isSilent)
+    audibleEnd_.store(writeFrame + framesCount, std::memory_order_relaxed);
+  writeFrame_.store(writeFrame + framesCount, std::memory_order_release);
+}
+
+std::int64_t MixerInput::bufferedFrames() const
+{
+  return std::int64_t(writeFrame_.load(std::memory_order_relaxed) - readFrame_.load(std::memory_order_relaxed));
+}
+
+AudioSinkStats MixerInput::stats() const
+{
+  AudioSinkStats stats;
+  stats.periodsWritten = writes_.load(std::memory_order_relaxed);
+  stats.bytesWritten = bytesReceived_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+DriftStats MixerInput::driftStats() const
+{
+  return driftCompensator_->driftStats();
+}
+
+MixerInputStats MixerInput::inputStats() const
+{
+  MixerInputStats stats;
+  stats.framesReceived = framesReceived_.load(std::memory_order_relaxed);
+  stats.framesDropped = framesDropped_.load(std::memory_order_relaxed);
+  stats.underruns = underruns_.load(std::memory_order_relaxed);
+  stats.formatsRejected = formatsRejected_.load(std::memory_order_relaxed);
+  stats.bufferedFrames = std::uint32_t(std::max<std::int64_t>(0, bufferedFrames()));
+  stats.isStarted = isStarted_.load(std::memory_order_relaxed);
+  stats.isMixed = isMixed_.load(std::memory_order_relaxed);
+  stats.isMuted = isMuted_.load(std::memory_order_relaxed);
+  stats.gain = gain_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+Mixer::Mixer(std::vector<AudioSinkPtr> outputs, MixerOptions options)
+    : options_(std::move(options))
+    , format_{NativeS16, options_.sampleRate, std::max<std::uint32_t>(1, options_.channelsCount)}
+    , blockFrames_(std::max<std::size_t>(1, framesOf(options_.sampleRate, options_.blockDuration)))
+    , outputs_(std::move(outputs))
+    , accumulate_(selectAccumulate())
+    , store_(selectStore())
+    , mix_(blockFrames_ * format_.channelsCount)
+    , output_(blockFrames_ * format_.channelsCount)
+{
+  thread_ = std::thread([this] { mixLoop(); });
+}
+
+Mixer::~Mixer()
+{
+  stopping_ = true;
+  thread_.join();
+}
+
+MixerInputPtr Mixer::addInput()
+{
+  auto input = std::make_shared<MixerInput>(options_);
+
+  std::lock_guard lock(inputsMutex_);
+  releaseRetiredInputs();
+  inputs_.push_back(input);
+  inputsGeneration_.fetch_add(1, std::memory_order_release);
+  return input;
+}
+
+void Mixer::removeInput(const MixerInputPtr& input)
+{
+  std::lock_guard lock(inputsMutex_);
+  releaseRetiredInputs();
+  if (std::erase(inputs_, input) == 0)
+    return;
+
+  const auto generation = inputsGeneration_.fetch_add(1, std::memory_order_release) + 1;
+  retiredInputs_.push_back({input, generation});
+}
+
+void Mixer::releaseRetiredInputs()
+{
+  // The mixer thread drops its copy of an input when it takes the
+  // generation that removed it.
+  const auto mixedGeneration = mixedGeneration_.load(std::memory_order_acquire);
+  std::erase_if(retiredInputs_, [mixedGeneration](const RetiredInput& retired) {
+    return retired.generation <= mixedGeneration;
+  });
+}
+
+MixerStats Mixer::stats() const
+{
+  MixerStats stats;
+  stats.blocksMixed = blocksMixed_.load(std::memory_order_relaxed);
+  stats.blocksLate = blocksLate_.load(std::memory_order_relaxed);
+  stats.silentBlocks = silentBlocks_.load(std::memory_order_relaxed);
+  {
+    std::lock_guard lock(inputsMutex_);
+    stats.inputsCount = std::uint32_t(inputs_.size());
+  }
+  stats.mixedInputs = mixedInputs_.load(std::memory_order_relaxed);
+  stats.averageMixNs = stats.blocksMixed != 0 ? totalMixNs_.load(std::memory_order_relaxed) / stats.blocksMixed : 0;
+  stats.maxMixNs = maxMixNs_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void Mixer::mixLoop()
+{
+  using Clock = std::chrono::steady_clock;
+
+  std::vector<AudioSinkPtr> outputs;
+  for (const auto& output : outputs_)
+  {
+    if (output && output->start(format_))
+      outputs.push_back(output);
+  }
+
+  const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(
+      std::uint64_t(blockFrames_) * 1'000'000'000 / std::max<std::uint32_t>(1, format_.sampleRate)));
+  auto deadline = Clock::now();
+
+  Inputs inputs;
+  std::uint64_t inputsGeneration = 0;
+
+  while (!stopping_.load(std::memory_order_relaxed))
+  {
+    deadline += period;
+    std::this_thread::sleep_until(deadline);
+
+    // Missed cycles are skipped rather than caught up in a burst the
+    // outputs could not take; inputs that ran ahead meanwhile are brought
+    // back to their delay.
+    const auto begin = Clock::now();
+    if (begin - deadline >= period)
+    {
+      const auto missed = (begin - deadline) / period;
+      blocksLate_.fetch_add(std::uint64_t(missed), std::memory_order_relaxed);
+      deadline += missed * period;
+    }
+
+    std::fill(mix_.begin(), mix_.end(), 0.f);
+
+    if (inputsGeneration_.load(std::memory_order_acquire) != inputsGeneration)
+    {
+      std::unique_lock lock(inputsMutex_, std::try_to_lock);
+      if (lock.owns_lock())
+      {
+        inputs = inputs_;
+        inputsGeneration = inputsGeneration_.load(std::memory_order_relaxed);
+        mixedGeneration_.store(inputsGeneration, std::memory_order_release);
+      }
+    }
+
+    std::uint32_t mixedInputs = 0;
+    std::uint32_t audibleInputs = 0;
+    for (const auto& input : inputs)
+    {
+      const auto block = mixInput(*input);
+      if (block != InputBlock::Missing)
+        ++mixedInputs;
+      if (block == InputBlock::Audible)
+        ++audibleInputs;
+    }
+
+    const bool isSilent = audibleInputs == 0;
+    if (isSilent)
+    {
+      std::fill(output_.begin(), output_.end(), std::int16_t(0));
+      silentBlocks_.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+      store_(mix_.data(), output_.data(), mix_.size());
+    }
+
+    const auto elapsed = std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count());
+    totalMixNs_.fetch_add(elapsed, std::memory_order_relaxed);
+    if (elapsed > maxMixNs_.load(std::memory_order_relaxed))
+      maxMixNs_.store(elapsed, std::memory_order_relaxed);
+    mixedInputs_.store(mixedInputs, std::memory_order_relaxed);
+    blocksMixed_.fetch_add(1, std::memory_order_relaxed);
+
+    const auto* data = reinterpret_cast<const std::uint8_t*>(output_.data());
+    const auto size = output_.size() * sizeof(std::int16_t);
+    for (const auto& output : outputs)
+    {
+      if (isSilent)
+        output->writeSilence(data, size);
+      else
+        output->write(data, size);
+    }
+  }
+
+  for (const auto& output : outputs)
+    output->stop();
+}
+
+Mixer::InputBlock Mixer::mixInput(MixerInput& input)
+{
+  const auto writeFrame = input.writeFrame_.load(std::memory_order_acquire);
+  auto readFrame = input.readFrame_.load(std::memory_order_relaxed);
+  const auto available = std::size_t(writeFrame - readFrame);
+  input.mixerQueuedFrames_.store(available, std::memory_order_relaxed);
+
+  // The level swings by a write of the source between its writes; an input
+  // takes half of one more than the delay, so the delay is what it holds on
+  // average.
+  const auto alignedFrames = std::min(input.delayFrames_ + input.lastWriteFrames_.load(std::memory_order_relaxed) / 2,
+                                      2 * input.delayFrames_);
+
+  if (!input.isMixed_.load(std::memory_order_relaxed))
+  {
+    if (available < alignedFrames)
+      return InputBlock::Missing;
+
+    // Joins with exactly that buffered, whatever piled up before.
+    input.framesDropped_.fetch_add(available - alignedFrames, std::memory_order_relaxed);
+    readFrame = writeFrame - alignedFrames;
+  }
+  else if (available < blockFrames_)
+  {
+    // Leaves the mix until it has buffered the delay again; what is left
+    // is too little to be worth a partial block. Only a stalled source, or
+    // drift beyond what the compensation follows, gets here.
+    input.underruns_.fetch_add(1, std::memory_order_relaxed);
+    input.isMixed_.store(false, std::memory_order_relaxed);
+    return InputBlock::Missing;
+  }
+  else if (available > 2 * input.delayFrames_)
+  {
+    // A burst, or drift faster than the input's compensation can follow.
+    input.framesDropped_.fetch_add(available - alignedFrames, std::memory_order_relaxed);
+    readFrame = writeFrame - alignedFrames;
+  }
+
+  // Only frames from the audible end on are known to be silence.
+  const auto gain = input.gain_.load(std::memory_order_relaxed);
+  const bool isSilent = input.isMuted_.load(std::memory_order_relaxed) || gain == 0.f
+                        || readFrame >= input.audibleEnd_.load(std::memory_order_relaxed);
+  if (!isSilent)
+  {
+    const std::size_t channels = format_.channelsCount;
+    const auto offset = std::size_t(readFrame % input.capacityFrames_);
+    const auto head = std::min(blockFrames_, input.capacityFrames_ - offset);
+    accumulate_(mix_.data(), input.ring_.get() + offset * channels, head * channels, gain);
+    accumulate_(mix_.data() + head * channels, input.ring_.get(), (blockFrames_ - head) * channels, gain);
+  }
+
+  // A muted input is still consumed, so it stays aligned with the others.
+  input.readFrame_.store(readFrame + blockFrames_, std::memory_order_release);
+  input.isMixed_.store(true, std::memory_order_relaxed);
+  return isSilent ? InputBlock::Silent : InputBlock::Audible;
+}
+
+} // namespace AudioPipeline
@@ -0,0 +1,49 @@
+#include "AP_MixerKernels.h"
+
+#include <immintrin.h>
+
+namespace AudioPipeline
+{
+
+void avx2Accumulate(float* mix, const std::int16_t* samples, std::size_t count, float gain)
+{
+  const __m256 gains = _mm256_set1_ps(gain);
+
+  std::size_t index = 0;
+  for (; index + 16 <= count; index += 16)
+  {
+    const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + index));
+    const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + index + 8));
+
+    const __m256 lowSamples = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(low));
+    const __m256 highSamples = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(high));
+
+    _mm256_storeu_ps(mix + index, _mm256_add_ps(_mm256_loadu_ps(mix + index), _mm256_mul_ps(lowSamples, gains)));
+    _mm256_storeu_ps(mix + index + 8,
+                     _mm256_add_ps(_mm256_loadu_ps(mix + index + 8), _mm256_mul_ps(highSamples, gains)));
+  }
+
+  scalarAccumulate(mix + index, samples + index, count - index, gain);
+}
+
+void avx2Store(const float* mix, std::int16_t* output, std::size_t count)
+{
+  const __m256 minimum = _mm256_set1_ps(-32768.f);
+  const __m256 maximum = _mm256_set1_ps(32767.f);
+
+  std::size_t index = 0;
+  for (; index + 16 <= count; index += 16)
+  {
+    const __m256 low = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(mix + index), minimum), maximum);
+    const __m256 high = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(mix + index + 8), minimum), maximum);
+
+    // Packing works within 128-bit lanes, the permute puts the halves back
+    // in order.
+    const __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(low), _mm256_cvtps_epi32(high));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + index), _mm256_permute4x64_epi64(packed, 0xD8));
+  }
+
+  scalarStore(mix + index, output + index, count - index);
+}
+
+} // namespace AudioPipeline
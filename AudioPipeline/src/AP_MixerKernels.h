@@ -0,0 +1,33 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace AudioPipeline
+{
+using AccumulateKernel = void (*)(float* mix, const std::int16_t* samples, std::size_t count, float gain);
+using StoreKernel = void (*)(const float* mix, std::int16_t* output, std::size_t count);
+
+// Adds samples scaled by the gain to the mix.
+inline void scalarAccumulate(float* mix, const std::int16_t* samples, std::size_t count, float gain)
+{
+  for (std::size_t index = 0; index < count; ++index)
+    mix[index] += float(samples[index]) * gain;
+}
+
+// Rounds the mix to the nearest sample, saturating.
+inline void scalarStore(const float* mix, std::int16_t* output, std::size_t count)
+{
+  for (std::size_t index = 0; index < count; ++index)
+    output[index] = static_cast<std::int16_t>(std::lrintf(std::clamp(mix[index], -32768.f, 32767.f)));
+}
+
+#ifdef AP_HAVE_X86_KERNELS
+void sse2Accumulate(float* mix, const std::int16_t* samples, std::size_t count, float gain);
+void sse2Store(const float* mix, std::int16_t* output, std::size_t count);
+void avx2Accumulate(float* mix, const std::int16_t* samples, std::size_t count, float gain);
+void avx2Store(const float* mix, std::int16_t* output, std::size_t count);
+#endif
+} // namespace AudioPipeline
@@ -0,0 +1,46 @@
+#include "AP_MixerKernels.h"
+
+#include <emmintrin.h>
+
+namespace AudioPipeline
+{
+
+void sse2Accumulate(float* mix, const std::int16_t* samples, std::size_t count, float gain)
+{
+  const __m128 gains = _mm_set1_ps(gain);
+
+  std::size_t index = 0;
+  for (; index + 8 <= count; index += 8)
+  {
+    const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + index));
+    // Sign extends by placing each sample in the high half and shifting back.
+    const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+    const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16);
+
+    _mm_storeu_ps(mix + index, _mm_add_ps(_mm_loadu_ps(mix + index), _mm_mul_ps(_mm_cvtepi32_ps(low), gains)));
+    _mm_storeu_ps(mix + index + 4,
+                  _mm_add_ps(_mm_loadu_ps(mix + index + 4), _mm_mul_ps(_mm_cvtepi32_ps(high), gains)));
+  }
+
+  scalarAccumulate(mix + index, samples + index, count - index, gain);
+}
+
+void sse2Store(const float* mix, std::int16_t* output, std::size_t count)
+{
+  const __m128 minimum = _mm_set1_ps(-32768.f);
+  const __m128 maximum = _mm_set1_ps(32767.f);
+
+  std::size_t index = 0;
+  for (; index + 8 <= count; index += 8)
+  {
+    const __m128 low = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(mix + index), minimum), maximum);
+    const __m128 high = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(mix + index + 4), minimum), maximum);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + index),
+                     _mm_packs_epi32(_mm_cvtps_epi32(low), _mm_cvtps_epi32(high)));
+  }
+
+  scalarStore(mix + index, output + index, count - index);
+}
+
+} // namespace AudioPipeline
@@ -0,0 +1,125 @@
+#include "AudioPipeline/AP_AudioSink.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace AudioPipeline
+{
+
+PeriodicAudioSink::PeriodicAudioSink(std::chrono::microseconds period)
+    : periodDuration_(period)
+{
+}
+
+bool PeriodicAudioSink::start(const PcmFormat& format)
+{
+  stop();
+
+  const auto frameBytes = format.bytesPerFrame();
+  const auto periodFrames = std::max<std::uint64_t>(1, format.sampleRate * periodDuration_.count() / 1000000);
+  if (frameBytes == 0)
+    return false;
+
+  // Backends may size their own buffers after periodSize().
+  period_.resize(periodFrames * frameBytes);
+  periodFill_ = 0;
+  frameBytes_ = frameBytes;
+  started_ = openBackend(format);
+
+  return started_;
+}
+
+void PeriodicAudioSink::write(const std::uint8_t* data, std::size_t size)
+{
+  append(data, size, false);
+}
+
+void PeriodicAudioSink::writeSilence(const std::uint8_t* data, std::size_t size)
+{
+  append(data, size, true);
+}
+
+void PeriodicAudioSink::stop()
+{
+  if (!started_)
+    return;
+
+  if (periodFill_ != 0)
+    flushPeriod(period_.data(), periodFill_, isPeriodSilent_);
+
+  periodFill_ = 0;
+  started_ = false;
+  closeBackend();
+}
+
+std::int64_t PeriodicAudioSink::bufferedFrames() const
+{
+  if (!started_)
+    return -1;
+
+  const auto backendBytes = backendBufferedBytes();
+  if (backendBytes < 0)
+    return -1;
+
+  return (backendBytes + std::int64_t(periodFill_)) / std::int64_t(frameBytes_);
+}
+
+AudioSinkStats PeriodicAudioSink::stats() const
+{
+  AudioSinkStats stats;
+  stats.periodsWritten = periodsWritten_.load(std::memory_order_relaxed);
+  stats.periodsDropped = periodsDropped_.load(std::memory_order_relaxed);
+  stats.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+
+  return stats;
+}
+
+void PeriodicAudioSink::append(const std::uint8_t* data, std::size_t size, bool isSilent)
+{
+  if (!started_)
+    return;
+
+  // Complete a partially filled period first.
+  if (periodFill_ != 0)
+  {
+    const auto chunk = std::min(size, period_.size() - periodFill_);
+    std::memcpy(period_.data() + periodFill_, data, chunk);
+    periodFill_ += chunk;
+    isPeriodSilent_ = isPeriodSilent_ && isSilent;
+    data += chunk;
+    size -= chunk;
+
+    if (periodFill_ < period_.size())
+      return;
+
+    flushPeriod(period_.data(), period_.size(), isPeriodSilent_);
+    periodFill_ = 0;
+  }
+
+  // Whole periods are handed over straight from the input.
+  while (size >= period_.size())
+  {
+    flushPeriod(data, period_.size(), isSilent);
+    data += period_.size();
+    size -= period_.size();
+  }
+
+  std::memcpy(period_.data(), data, size);
+  periodFill_ = size;
+  isPeriodSilent_ = isSilent;
+}
+
+void PeriodicAudioSink::flushPeriod(const std::uint8_t* data, std::size_t size, bool isSilent)
+{
+  if (isSilent ? writeSilentPeriod(data, size) : writePeriod(data, size))
+  {
+    periodsWritten_.fetch_add(1, std::memory_order_relaxed);
+    bytesWritten_.fetch_add(size, std::memory_order_relaxed);
+  }
+  else
+  {
+    periodsDropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+} // namespace AudioPipeline
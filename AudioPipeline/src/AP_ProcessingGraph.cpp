@@ -0,0 +1,131 @@
+#include "AudioPipeline/AP_ProcessingGraph.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace AudioPipeline
+{
+
+std::size_t ProcessingGraph::Wiring::add(ProcessingStagePtr stage, std::optional<std::size_t> after)
+{
+  const auto index = nodes_.size();
+  nodes_.push_back({std::move(stage), {}});
+
+  if (after && *after < index)
+    nodes_[*after].successors.push_back(index);
+  else
+    roots_.push_back(index);
+
+  return index;
+}
+
+ProcessingGraph::ProcessingGraph(Wiring wiring)
+{
+  rewire(std::move(wiring));
+}
+
+void ProcessingGraph::rewire(Wiring wiring)
+{
+  auto topology = std::make_shared<Topology>();
+  topology->nodesCount = wiring.nodes_.size();
+  topology->nodes = std::make_unique<Node[]>(topology->nodesCount);
+  topology->roots = std::move(wiring.roots_);
+
+  for (std::size_t index = 0; index < topology->nodesCount; ++index)
+  {
+    topology->nodes[index].stage = std::move(wiring.nodes_[index].stage);
+    topology->nodes[index].successors = std::move(wiring.nodes_[index].successors);
+  }
+
+  std::lock_guard lock(topologyMutex_);
+  topology_ = std::move(topology);
+  topologyGeneration_.fetch_add(1, std::memory_order_release);
+}
+
+void ProcessingGraph::process(const AudioBlock& block)
+{
+  if (topologyGeneration_.load(std::memory_order_acquire) != processedGeneration_)
+  {
+    std::lock_guard lock(topologyMutex_);
+    processedTopology_ = topology_;
+    processedGeneration_ = topologyGeneration_.load(std::memory_order_relaxed);
+  }
+
+  if (!processedTopology_)
+    return;
+
+  for (const auto root : processedTopology_->roots)
+    run(*processedTopology_, root, block);
+}
+
+void ProcessingGraph::run(Topology& topology, std::size_t index, const AudioBlock& block)
+{
+  auto& node = topology.nodes[index];
+
+  if (node.configuredFormat != block.format)
+  {
+    node.configuredFormat = block.format;
+    node.isUsable = node.stage->configure(block.format);
+  }
+  if (!node.isUsable)
+    return;
+
+  const auto started = std::chrono::steady_clock::now();
+  const auto output = node.stage->process(block);
+  const auto elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+
+  // The processing thread is the only writer of the timings, timings()
+  // merely reads them. A relaxed load and store per counter is enough and
+  // spares the locked read-modify-write of fetch_add.
+  const auto add = [](std::atomic<std::uint64_t>& counter, std::uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  };
+
+  const auto ns = std::uint32_t(std::min<std::int64_t>(elapsedNs.count(), UINT32_MAX));
+  add(node.blocks, 1);
+  add(node.totalNs, ns);
+  node.maxNs.store(std::max(node.maxNs.load(std::memory_order_relaxed), ns), std::memory_order_relaxed);
+  if (block.isSilent)
+  {
+    add(node.silentBlocks, 1);
+    add(node.silentTotalNs, ns);
+  }
+
+  if (output.empty())
+    return;
+
+  for (const auto successor : node.successors)
+    run(topology, successor, output);
+}
+
+std::vector<StageTiming> ProcessingGraph::timings() const
+{
+  std::vector<StageTiming> timings;
+
+  std::shared_ptr<Topology> topology;
+  {
+    std::lock_guard lock(topologyMutex_);
+    topology = topology_;
+  }
+  if (!topology)
+    return timings;
+
+  timings.reserve(topology->nodesCount);
+  for (std::size_t index = 0; index < topology->nodesCount; ++index)
+  {
+    const auto& node = topology->nodes[index];
+
+    StageTiming timing;
+    timing.name = node.stage->name();
+    timing.blocks = node.blocks.load(std::memory_order_relaxed);
+    timing.averageNs = timing.blocks == 0 ? 0 : std::uint32_t(node.totalNs.load(std::memory_order_relaxed) / timing.blocks);
+    timing.maxNs = node.maxNs.load(std::memory_order_relaxed);
+    timing.silentBlocks = node.silentBlocks.load(std::memory_order_relaxed);
+    timing.averageSilentNs = timing.silentBlocks == 0 ? 0 : std::uint32_t(node.silentTotalNs.load(std::memory_order_relaxed) / timing.silentBlocks);
+    timings.push_back(std::move(timing));
+  }
+
+  return timings;
+}
+
+} // namespace AudioPipeline
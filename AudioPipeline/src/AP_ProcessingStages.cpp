@@ -0,0 +1,250 @@
+#include "AudioPipeline/AP_ProcessingStages.h"
+
+#include "AP_ChannelConversion.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+namespace AudioPipeline
+{
+
+namespace
+{
+constexpr SampleFormat NativeS16 = std::endian::native == std::endian::little ? SampleFormat::S16LE
+                                                                               : SampleFormat::S16BE;
+
+// Block buffers are sized for this much audio when configured and only grow
+// for longer blocks.
+constexpr std::uint32_t PreallocatedBlockMs = 100;
+
+std::size_t preallocatedFrames(const PcmFormat& format)
+{
+  return std::size_t(format.sampleRate) * PreallocatedBlockMs / 1000;
+}
+
+bool isNativeS16(const PcmFormat& format)
+{
+  return format.sampleFormat == NativeS16 && format.channelsCount != 0;
+}
+
+AudioBlock makeBlock(const AudioBlock& input, const std::int16_t* samples, std::size_t samplesCount)
+{
+  AudioBlock block = input;
+  block.data = reinterpret_cast<const std::uint8_t*>(samples);
+  block.size = samplesCount * sizeof(std::int16_t);
+  return block;
+}
+} // namespace
+
+DecodeStage::DecodeStage(AudioDecoderPtr decoder)
+    : decoder_(std::move(decoder))
+{
+}
+
+AudioBlock DecodeStage::process(const AudioBlock& input)
+{
+  if (!input.isEncoded)
+    return input;
+
+  DecodedAudio decoded;
+  if (!decoder_ || !decoder_->decode(input.data, input.size, decoded))
+    return {};
+
+  AudioBlock block;
+  block.data = decoded.data;
+  block.size = decoded.size;
+  block.format.sampleFormat = decoded.format;
+  block.format.sampleRate = decoded.sampleRate;
+  block.format.channelsCount = decoded.channelsCount;
+  return block;
+}
+
+ConcealStage::ConcealStage(LossConcealer& concealer)
+    : concealer_(concealer)
+{
+}
+
+bool ConcealStage::configure(const PcmFormat& format)
+{
+  concealer_.updateFormat(format);
+  return true;
+}
+
+AudioBlock ConcealStage::process(const AudioBlock& input)
+{
+  if (input.isConcealment || input.isEncoded)
+    return input;
+
+  AudioBlock block = input;
+  block.data = concealer_.onAudio(input.data, input.size);
+  return block;
+}
+
+VoiceActivityStage::VoiceActivityStage(VoiceActivityOptions options)
+    : detector_(options)
+{
+}
+
+bool VoiceActivityStage::configure(const PcmFormat& format)
+{
+  detector_.setFormat(format);
+  return true;
+}
+
+AudioBlock VoiceActivityStage::process(const AudioBlock& input)
+{
+  if (input.isEncoded)
+    return input;
+
+  AudioBlock block = input;
+  block.isSilent = detector_.isSilent(input.data, input.size);
+  return block;
+}
+
+RemixStage::RemixStage(std::uint32_t outputChannels)
+    : outputChannels_(outputChannels)
+{
+}
+
+bool RemixStage::configure(const PcmFormat& format)
+{
+  if (!isNativeS16(format) || outputChannels_ == 0)
+    return false;
+
+  outputFormat_ = format;
+  outputFormat_.channelsCount = outputChannels_;
+
+  isRemixing_ = format.channelsCount != outputChannels_;
+  if (isRemixing_)
+  {
+    const auto frames = preallocatedFrames(format);
+    input_.reserve(frames * format.channelsCount);
+    output_.reserve(frames * outputChannels_);
+  }
+
+  return true;
+}
+
+AudioBlock RemixStage::process(const AudioBlock& input)
+{
+  if (!isRemixing_ || input.isEncoded)
+    return input;
+
+  const std::size_t channels = input.format.channelsCount;
+  const auto framesCount = input.size / (channels * sizeof(std::int16_t));
+
+  // The conversion reads whole samples.
+  const auto* samples = reinterpret_cast<const std::int16_t*>(input.data);
+  if (reinterpret_cast<std::uintptr_t>(input.data) % alignof(std::int16_t) != 0)
+  {
+    input_.resize(framesCount * channels);
+    std::memcpy(input_.data(), input.data, framesCount * channels * sizeof(std::int16_t));
+    samples = input_.data();
+  }
+
+  output_.resize(framesCount * outputChannels_);
+  convertChannels(samples, channels, output_.data(), outputChannels_, framesCount);
+
+  auto block = makeBlock(input, output_.data(), output_.size());
+  block.format = outputFormat_;
+  return block;
+}
+
+ResampleStage::ResampleStage(std::uint32_t outputRate)
+    : outputRate_(outputRate)
+{
+}
+
+bool ResampleStage::configure(const PcmFormat& format)
+{
+  resampler_.reset();
+  if (!isNativeS16(format) || format.sampleRate == 0 || outputRate_ == 0)
+    return false;
+
+  outputFormat_ = format;
+  outputFormat_.sampleRate = outputRate_;
+
+  if (format.sampleRate == outputRate_)
+    return true;
+
+  resampler_.emplace(format.sampleRate, outputRate_, format.channelsCount);
+
+  const auto frames = preallocatedFrames(format);
+  input_.reserve(frames * format.channelsCount);
+  output_.reserve((resampler_->maxOutputFrames(frames) + frames / Resampler::MaxBlockFrames + 1) * format.channelsCount);
+
+  return true;
+}
+
+AudioBlock ResampleStage::process(const AudioBlock& input)
+{
+  if (!resampler_ || input.isEncoded)
+    return input;
+
+  const std::size_t channels = input.format.channelsCount;
+  const auto framesCount = input.size / (channels * sizeof(std::int16_t));
+
+  // The resampler reads whole samples.
+  const auto* samples = reinterpret_cast<const std::int16_t*>(input.data);
+  if (reinterpret_cast<std::uintptr_t>(input.data) % alignof(std::int16_t) != 0)
+  {
+    input_.resize(framesCount * channels);
+    std::memcpy(input_.data(), input.data, framesCount * channels * sizeof(std::int16_t));
+    samples = input_.data();
+  }
+
+  const auto chunksCount = (framesCount + Resampler::MaxBlockFrames - 1) / Resampler::MaxBlockFrames;
+  output_.resize((resampler_->maxOutputFrames(framesCount) + chunksCount) * channels);
+
+  std::size_t outputFrames = 0;
+  for (std::size_t frame = 0; frame < framesCount; frame += Resampler::MaxBlockFrames)
+  {
+    const auto chunkFrames = std::min(Resampler::MaxBlockFrames, framesCount - frame);
+    outputFrames += resampler_->process(samples + frame * channels, chunkFrames, output_.data() + outputFrames * channels);
+  }
+
+  auto block = makeBlock(input, output_.data(), outputFrames * channels);
+  block.format = outputFormat_;
+  return block;
+}
+
+SinkStage::SinkStage(AudioSinkPtr sink)
+    : sink_(std::move(sink))
+{
+}
+
+SinkStage::~SinkStage()
+{
+  if (startedFormat_)
+    sink_->stop();
+}
+
+bool SinkStage::configure(const PcmFormat& format)
+{
+  if (startedFormat_ == format)
+    return true;
+
+  startedFormat_.reset();
+  if (!sink_->start(format))
+    return false;
+
+  startedFormat_ = format;
+  return true;
+}
+
+AudioBlock SinkStage::process(const AudioBlock& input)
+{
+  if (input.isEncoded)
+    return {};
+
+  if (input.isSilent)
+    sink_->writeSilence(input.data, input.size);
+  else
+    sink_->write(input.data, input.size);
+
+  return {};
+}
+
+} // namespace AudioPipeline
@@ -0,0 +1,224 @@
+#include "AudioPipeline/AP_Recorder.h"
+
+#include "AP_RecordingFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+namespace AudioPipeline
+{
+
+namespace
+{
+std::string timestamp()
+{
+  const auto now = std::time(nullptr);
+  std::tm local = {};
+#ifdef _WIN32
+  localtime_s(&local, &now);
+#else
+  localtime_r(&now, &local);
+#endif
+
+  char text[32] = {};
+  std::strftime(text, sizeof(text), "%Y%m%d-%H%M%S", &local);
+  return text;
+}
+} // namespace
+
+Recorder::Recorder(RecorderOptions options)
+    : PeriodicAudioSink(options.blockDuration)
+    , options_(std::move(options))
+    , blocksCount_(std::max<std::uint32_t>(2, std::uint32_t(options_.queueDuration / std::max(options_.blockDuration, std::chrono::milliseconds(1)))))
+    , blocks_(std::make_unique<Block[]>(blocksCount_))
+{
+  ioThread_ = std::thread([this] { ioLoop(); });
+}
+
+Recorder::~Recorder()
+{
+  stop();
+
+  stopping_ = true;
+  wakeups_.fetch_add(1, std::memory_order_release);
+  wakeups_.notify_one();
+  ioThread_.join();
+}
+
+void Recorder::writeSilence(const std::uint8_t* data, std::size_t size)
+{
+  if (!options_.skipSilence)
+  {
+    PeriodicAudioSink::writeSilence(data, size);
+    return;
+  }
+
+  silentBytesSkipped_.fetch_add(size, std::memory_order_relaxed);
+}
+
+RecorderStats Recorder::recorderStats() const
+{
+  RecorderStats stats;
+  stats.blocksRecorded = blocksRecorded_.load(std::memory_order_relaxed);
+  stats.blocksDropped = blocksDropped_.load(std::memory_order_relaxed);
+  stats.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+  stats.silentBytesSkipped = silentBytesSkipped_.load(std::memory_order_relaxed);
+  stats.filesCompleted = filesCompleted_.load(std::memory_order_relaxed);
+  stats.writeErrors = writeErrors_.load(std::memory_order_relaxed);
+  stats.queuedBlocks = writeIndex_.load(std::memory_order_relaxed) - readIndex_.load(std::memory_order_relaxed);
+  stats.maxQueuedBlocks = maxQueuedBlocks_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+bool Recorder::openBackend(const PcmFormat& format)
+{
+  if (format.channelsCount == 0 || format.sampleRate == 0)
+    return false;
+
+  format_ = format;
+
+  // Never zero, which stands for stopped.
+  lastSession_ = lastSession_ + 1 == 0 ? 1 : lastSession_ + 1;
+  session_.store(lastSession_, std::memory_order_release);
+
+  // Blocks the producer owns are sized now; the queued ones are resized
+  // when they come back, if the new format needs more room.
+  const auto readIndex = readIndex_.load(std::memory_order_acquire);
+  const auto writeIndex = writeIndex_.load(std::memory_order_relaxed);
+  for (auto index = writeIndex; index != readIndex + blocksCount_; ++index)
+    blocks_[index % blocksCount_].data.resize(std::max(blocks_[index % blocksCount_].data.size(), periodSize()));
+
+  return true;
+}
+
+bool Recorder::writePeriod(const std::uint8_t* data, std::size_t size)
+{
+  const auto writeIndex = writeIndex_.load(std::memory_order_relaxed);
+  const auto queued = writeIndex - readIndex_.load(std::memory_order_acquire);
+  if (queued == blocksCount_)
+  {
+    blocksDropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  auto& block = blocks_[writeIndex % blocksCount_];
+  if (block.data.size() < size)
+    block.data.resize(size);
+
+  std::memcpy(block.data.data(), data, size);
+  block.size = size;
+  block.format = format_;
+  block.session = lastSession_;
+
+  writeIndex_.store(writeIndex + 1, std::memory_order_release);
+  if (queued + 1 > maxQueuedBlocks_.load(std::memory_order_relaxed))
+    maxQueuedBlocks_.store(queued + 1, std::memory_order_relaxed);
+
+  wakeups_.fetch_add(1, std::memory_order_release);
+  wakeups_.notify_one();
+  return true;
+}
+
+void Recorder::closeBackend()
+{
+  // The I/O thread finishes the file once it has written what is queued.
+  session_.store(0, std::memory_order_release);
+  wakeups_.fetch_add(1, std::memory_order_release);
+  wakeups_.notify_one();
+}
+
+void Recorder::ioLoop()
+{
+  std::unique_ptr<RecordingFile> file;
+  std::uint32_t fileSession = 0;
+  std::uint32_t fileIndex = 0;
+  std::string sessionStart;
+
+  const auto finishFile = [&] {
+    if (!file)
+      return;
+
+    if (file->finish())
+      filesCompleted_.fetch_add(1, std::memory_order_relaxed);
+    else
+      writeErrors_.fetch_add(1, std::memory_order_relaxed);
+    file.reset();
+  };
+
+  const auto exceedsLimits = [this](const RecordingFile& recording, std::size_t size) {
+    if (recording.framesWritten() == 0)
+      return false;
+
+    const auto frames = recording.framesWritten() + size / recording.format().bytesPerFrame();
+    const auto maxFrames = std::uint64_t(options_.maxFileDuration.count()) * recording.format().sampleRate;
+    return (options_.maxFileBytes != 0 && recording.size() + size > options_.maxFileBytes)
+           || (recording.maxSize() != 0 && recording.size() + size > recording.maxSize())
+           || (maxFrames != 0 && frames > maxFrames);
+  };
+
+  for (;;)
+  {
+    const auto wakeups = wakeups_.load(std::memory_order_acquire);
+
+    auto readIndex = readIndex_.load(std::memory_order_relaxed);
+    while (readIndex != writeIndex_.load(std::memory_order_acquire))
+    {
+      const auto& block = blocks_[readIndex % blocksCount_];
+
+      if (file && (fileSession != block.session || exceedsLimits(*file, block.size)))
+        finishFile();
+
+      if (!file)
+      {
+        if (fileSession != block.session)
+        {
+          fileSession = block.session;
+          fileIndex = 0;
+          sessionStart = timestamp();
+        }
+
+        const auto path = options_.pathPrefix + "-" + sessionStart + "-" + std::to_string(++fileIndex)
+                          + extensionOf(options_.container);
+        file = createRecordingFile(options_.container, block.format);
+        if (!file || !file->open(path))
+        {
+          writeErrors_.fetch_add(1, std::memory_order_relaxed);
+          file.reset();
+        }
+      }
+
+      if (file)
+      {
+        const auto sizeBefore = file->size();
+        if (file->write(block.data.data(), block.size))
+        {
+          blocksRecorded_.fetch_add(1, std::memory_order_relaxed);
+          bytesWritten_.fetch_add(file->size() - sizeBefore, std::memory_order_relaxed);
+        }
+        else
+        {
+          // Whatever made the disk fail, the next block tries a new file.
+          finishFile();
+        }
+      }
+
+      readIndex_.store(++readIndex, std::memory_order_release);
+    }
+
+    // Blocks queued before the recording stopped are all visible once the
+    // stop is; they belong in the file too.
+    if (file && session_.load(std::memory_order_acquire) != fileSession
+        && writeIndex_.load(std::memory_order_acquire) == readIndex)
+      finishFile();
+
+    if (stopping_)
+      break;
+
+    wakeups_.wait(wakeups, std::memory_order_acquire);
+  }
+
+  finishFile();
+}
+
+} // namespace AudioPipeline
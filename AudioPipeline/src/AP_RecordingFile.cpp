@@ -0,0 +1,329 @@
+#include "AP_RecordingFile.h"
+
+#include "AP_FlacEncoder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace AudioPipeline
+{
+
+namespace
+{
+// Writes reach the disk in chunks of this size, aligned for the storage.
+constexpr std::size_t WriteBufferSize = 1 << 20;
+constexpr std::size_t WriteBufferAlignment = 4096;
+
+// A file on disk written through one large aligned buffer.
+class BufferedFile
+{
+public:
+  BufferedFile() = default;
+  BufferedFile(const BufferedFile&) = delete;
+  BufferedFile& operator=(const BufferedFile&) = delete;
+  ~BufferedFile() { close(); }
+
+  bool open(const std::string& path)
+  {
+    if (!buffer_)
+      buffer_.reset(static_cast<std::uint8_t*>(::operator new(WriteBufferSize, std::align_val_t(WriteBufferAlignment))));
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (file_)
+      std::setvbuf(file_, nullptr, _IONBF, 0);
+
+    fill_ = 0;
+    size_ = 0;
+    failed_ = file_ == nullptr;
+    return !failed_;
+  }
+
+  bool append(const std::uint8_t* data, std::size_t size)
+  {
+    size_ += size;
+    while (size != 0 && !failed_)
+    {
+      const auto chunk = std::min(size, WriteBufferSize - fill_);
+      std::memcpy(buffer_.get() + fill_, data, chunk);
+      fill_ += chunk;
+      data += chunk;
+      size -= chunk;
+
+      if (fill_ == WriteBufferSize)
+        flush();
+    }
+    return !failed_;
+  }
+
+  // Overwrites bytes already written, e.g. a header once the sizes are known.
+  bool rewrite(std::uint64_t offset, const std::uint8_t* data, std::size_t size)
+  {
+    flush();
+    failed_ = failed_ || std::fseek(file_, long(offset), SEEK_SET) != 0 || std::fwrite(data, 1, size, file_) != size
+              || std::fseek(file_, 0, SEEK_END) != 0;
+    return !failed_;
+  }
+
+  // Returns false when anything failed since open().
+  bool close()
+  {
+    if (!file_)
+      return false;
+
+    flush();
+    failed_ = std::fclose(file_) != 0 || failed_;
+    file_ = nullptr;
+    return !failed_;
+  }
+
+  std::uint64_t size() const { return size_; }
+
+private:
+  struct AlignedDelete
+  {
+    void operator()(std::uint8_t* buffer) const { ::operator delete(buffer, std::align_val_t(WriteBufferAlignment)); }
+  };
+
+  void flush()
+  {
+    if (fill_ != 0 && !failed_)
+      failed_ = std::fwrite(buffer_.get(), 1, fill_, file_) != fill_;
+    fill_ = 0;
+  }
+
+private:
+  std::FILE* file_ = nullptr;
+  std::unique_ptr<std::uint8_t, AlignedDelete> buffer_;
+  std::size_t fill_ = 0;
+  std::uint64_t size_ = 0;
+  bool failed_ = false;
+};
+
+// Samples of any pipeline format as signed integers, with their width.
+std::int32_t readSample(SampleFormat format, const std::uint8_t* sample)
+{
+  switch (format)
+  {
+    case SampleFormat::U8:
+      return std::int32_t(sample[0]) - 128;
+    case SampleFormat::S8:
+      return std::int8_t(sample[0]);
+    case SampleFormat::U16LE:
+      return std::int32_t(sample[0] | (sample[1] << 8)) - 32768;
+    case SampleFormat::U16BE:
+      return std::int32_t(sample[1] | (sample[0] << 8)) - 32768;
+    case SampleFormat::S16LE:
+      return std::int16_t(sample[0] | (sample[1] << 8));
+    case SampleFormat::S16BE:
+      return std::int16_t(sample[1] | (sample[0] << 8));
+  }
+  return 0;
+}
+
+std::uint32_t bitsOf(SampleFormat format)
+{
+  return std::uint32_t(bytesPerSample(format) * 8);
+}
+
+class BufferedRecordingFile : public RecordingFile
+{
+public:
+  explicit BufferedRecordingFile(const PcmFormat& format)
+      : format_(format)
+  {
+  }
+
+  const PcmFormat& format() const override { return format_; }
+  std::uint64_t framesWritten() const override { return framesWritten_; }
+  std::uint64_t size() const override { return file_.size(); }
+
+protected:
+  const PcmFormat format_;
+  BufferedFile file_;
+  std::uint64_t framesWritten_ = 0;
+};
+
+// Little endian PCM, unsigned for 8-bit samples and signed otherwise.
+class WavFile final : public BufferedRecordingFile
+{
+public:
+  using BufferedRecordingFile::BufferedRecordingFile;
+
+  bool open(const std::string& path) override { return file_.open(path) && writeHeader(); }
+
+  // The RIFF size counts the file minus its first 8 bytes in 32 bits.
+  std::uint64_t maxSize() const override { return std::uint64_t(UINT32_MAX) + 8; }
+
+  bool write(const std::uint8_t* data, std::size_t size) override
+  {
+    const auto sampleBytes = bytesPerSample(format_.sampleFormat);
+    const auto samplesCount = size / sampleBytes;
+    framesWritten_ += samplesCount / format_.channelsCount;
+
+    if (format_.sampleFormat == SampleFormat::U8 || format_.sampleFormat == SampleFormat::S16LE)
+      return file_.append(data, size);
+
+    converted_.resize(samplesCount * sampleBytes);
+    for (std::size_t index = 0; index < samplesCount; ++index)
+    {
+      const auto sample = readSample(format_.sampleFormat, data + index * sampleBytes);
+      if (sampleBytes == 1)
+      {
+        converted_[index] = std::uint8_t(sample + 128);
+      }
+      else
+      {
+        converted_[2 * index] = std::uint8_t(sample);
+        converted_[2 * index + 1] = std::uint8_t(sample >> 8);
+      }
+    }
+    return file_.append(converted_.data(), converted_.size());
+  }
+
+  bool finish() override
+  {
+    writeHeader();
+    return file_.close();
+  }
+
+private:
+  bool writeHeader()
+  {
+    const auto blockAlign = std::uint32_t(format_.bytesPerFrame());
+    // Within 32 bits, the file is rotated before maxSize() is passed.
+    const auto dataSize = std::uint32_t(framesWritten_ * blockAlign);
+
+    std::uint8_t header[HeaderSize];
+    auto* out = header;
+    const auto put = [&out](std::uint32_t value, int bytes) {
+      for (int index = 0; index < bytes; ++index)
+        *out++ = std::uint8_t(value >> (8 * index));
+    };
+    const auto tag = [&out](const char* name) {
+      std::memcpy(out, name, 4);
+      out += 4;
+    };
+
+    tag("RIFF");
+    put(36 + dataSize, 4);
+    tag("WAVE");
+    tag("fmt ");
+    put(16, 4);
+    put(1, 2);
+    put(format_.channelsCount, 2);
+    put(format_.sampleRate, 4);
+    put(format_.sampleRate * blockAlign, 4);
+    put(blockAlign, 2);
+    put(bitsOf(format_.sampleFormat), 2);
+    tag("data");
+    put(dataSize, 4);
+
+    if (file_.size() == 0)
+      return file_.append(header, HeaderSize);
+    return file_.rewrite(0, header, HeaderSize);
+  }
+
+private:
+  static constexpr std::size_t HeaderSize = 44;
+
+  std::vector<std::uint8_t> converted_;
+};
+
+class FlacFile final : public BufferedRecordingFile
+{
+public:
+  explicit FlacFile(const PcmFormat& format)
+      : BufferedRecordingFile(format)
+      , encoder_(format.sampleRate, format.channelsCount, bitsOf(format.sampleFormat))
+      , pending_(FlacEncoder::BlockFrames * format.channelsCount)
+  {
+  }
+
+  // STREAMINFO counts samples in 36 bits, far beyond any recording.
+  std::uint64_t maxSize() const override { return 0; }
+
+  bool open(const std::string& path) override
+  {
+    encoded_.clear();
+    encoder_.writeStreamHeader(encoded_);
+    return file_.open(path) && file_.append(encoded_.data(), encoded_.size());
+  }
+
+  bool write(const std::uint8_t* data, std::size_t size) override
+  {
+    const auto sampleBytes = bytesPerSample(format_.sampleFormat);
+    const std::size_t channels = format_.channelsCount;
+    const auto framesCount = size / (sampleBytes * channels);
+    framesWritten_ += framesCount;
+
+    // The encoder takes the channels of a block one after the other.
+    bool succeeded = true;
+    for (std::size_t frame = 0; frame < framesCount; ++frame)
+    {
+      for (std::size_t channel = 0; channel < channels; ++channel)
+        pending_[channel * FlacEncoder::BlockFrames + pendingFrames_] =
+            readSample(format_.sampleFormat, data + (frame * channels + channel) * sampleBytes);
+
+      if (++pendingFrames_ == FlacEncoder::BlockFrames)
+        succeeded = encodePending() && succeeded;
+    }
+    return succeeded;
+  }
+
+  bool finish() override
+  {
+    encodePending();
+
+    encoded_.clear();
+    encoder_.writeStreamHeader(encoded_);
+    file_.rewrite(0, encoded_.data(), encoded_.size());
+    return file_.close();
+  }
+
+private:
+  bool encodePending()
+  {
+    if (pendingFrames_ == 0)
+      return true;
+
+    // A short last block keeps its channels where a full one would have them.
+    if (pendingFrames_ < FlacEncoder::BlockFrames)
+    {
+      for (std::size_t channel = 1; channel < format_.channelsCount; ++channel)
+        std::copy_n(pending_.data() + channel * FlacEncoder::BlockFrames, pendingFrames_,
+                    pending_.data() + channel * pendingFrames_);
+    }
+
+    encoded_.clear();
+    encoder_.encodeFrame(pending_.data(), pendingFrames_, encoded_);
+    pendingFrames_ = 0;
+    return file_.append(encoded_.data(), encoded_.size());
+  }
+
+private:
+  FlacEncoder encoder_;
+  std::vector<std::int32_t> pending_;
+  std::size_t pendingFrames_ = 0;
+  std::vector<std::uint8_t> encoded_;
+};
+} // namespace
+
+std::unique_ptr<RecordingFile> createRecordingFile(RecordingContainer container, const PcmFormat& format)
+{
+  if (format.channelsCount == 0 || format.sampleRate == 0)
+    return nullptr;
+
+  if (container == RecordingContainer::Flac)
+    return std::make_unique<FlacFile>(format);
+  return std::make_unique<WavFile>(format);
+}
+
+const char* extensionOf(RecordingContainer container)
+{
+  return container == RecordingContainer::Flac ? ".flac" : ".wav";
+}
+
+} // namespace AudioPipeline
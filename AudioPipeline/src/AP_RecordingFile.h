@@ -0,0 +1,39 @@
+#pragma once
+
+#include "AudioPipeline/AP_AudioSink.h"
+#include "AudioPipeline/AP_Recorder.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace AudioPipeline
+{
+// One audio file in the encoding of its container, written through one
+// large aligned buffer. Used from a single thread.
+class RecordingFile
+{
+public:
+  virtual ~RecordingFile() = default;
+
+  virtual bool open(const std::string& path) = 0;
+  // Takes whole frames of the format the file was created with.
+  virtual bool write(const std::uint8_t* data, std::size_t size) = 0;
+  // Completes the headers and closes the file; false when anything failed.
+  virtual bool finish() = 0;
+
+  virtual const PcmFormat& format() const = 0;
+  virtual std::uint64_t framesWritten() const = 0;
+  // Bytes in the file so far.
+  virtual std::uint64_t size() const = 0;
+  // Largest file the headers of the container can describe, zero when
+  // there is no such limit. Writes past it corrupt the file.
+  virtual std::uint64_t maxSize() const = 0;
+};
+
+// Null when the format cannot be recorded.
+std::unique_ptr<RecordingFile> createRecordingFile(RecordingContainer container, const PcmFormat& format);
+
+const char* extensionOf(RecordingContainer container);
+} // namespace AudioPipeline
@@ -0,0 +1,124 @@
+#include "AudioPipeline/AP_ReplayCapture.h"
+
+#include "AP_RecordingFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace AudioPipeline
+{
+
+ReplayCapture::ReplayCapture(std::chrono::seconds duration)
+    : duration_(duration)
+{
+}
+
+bool ReplayCapture::start(const PcmFormat& format)
+{
+  const auto frameBytes = format.bytesPerFrame();
+  if (frameBytes == 0 || format.sampleRate == 0)
+    return false;
+
+  // A stream that comes back in the same format keeps what was captured
+  // before it dropped.
+  if (!producerRing_ || producerRing_->format != format)
+  {
+    auto ring = std::make_shared<Ring>();
+    ring->format = format;
+    ring->capacity = std::max<std::size_t>(1, std::size_t(duration_.count()) * format.sampleRate) * frameBytes;
+    ring->data = std::make_unique<std::uint8_t[]>(ring->capacity);
+
+    producerRing_ = ring;
+    std::lock_guard lock(ringMutex_);
+    ring_ = std::move(ring);
+  }
+
+  started_ = true;
+  return true;
+}
+
+void ReplayCapture::write(const std::uint8_t* data, std::size_t size)
+{
+  if (!started_)
+    return;
+
+  auto& ring = *producerRing_;
+
+  // Only the most recent capacity bytes of a long write can be kept.
+  auto written = ring.written.load(std::memory_order_relaxed);
+  if (size > ring.capacity)
+  {
+    const auto skipped = size - ring.capacity;
+    data += skipped;
+    size -= skipped;
+    written += skipped;
+  }
+
+  ring.reserved.store(written + size, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  const auto offset = std::size_t(written % ring.capacity);
+  const auto head = std::min(size, ring.capacity - offset);
+  std::memcpy(ring.data.get() + offset, data, head);
+  std::memcpy(ring.data.get(), data + head, size - head);
+
+  ring.written.store(written + size, std::memory_order_release);
+
+  writes_.fetch_add(1, std::memory_order_relaxed);
+  bytesWritten_.fetch_add(size, std::memory_order_relaxed);
+}
+
+void ReplayCapture::stop()
+{
+  started_ = false;
+}
+
+AudioSinkStats ReplayCapture::stats() const
+{
+  AudioSinkStats stats;
+  stats.periodsWritten = writes_.load(std::memory_order_relaxed);
+  stats.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+bool ReplayCapture::dump(const std::string& path, RecordingContainer container) const
+{
+  std::shared_ptr<Ring> ring;
+  {
+    std::lock_guard lock(ringMutex_);
+    ring = ring_;
+  }
+  if (!ring)
+    return false;
+
+  const auto frameBytes = ring->format.bytesPerFrame();
+  const auto end = ring->written.load(std::memory_order_acquire);
+  auto begin = end > ring->capacity ? end - ring->capacity : 0;
+
+  std::vector<std::uint8_t> snapshot(std::size_t(end - begin));
+  for (auto position = begin; position < end;)
+  {
+    const auto offset = std::size_t(position % ring->capacity);
+    const auto chunk = std::min<std::uint64_t>(end - position, ring->capacity - offset);
+    std::memcpy(snapshot.data() + (position - begin), ring->data.get() + offset, std::size_t(chunk));
+    position += chunk;
+  }
+
+  // Whatever the producer started overwriting meanwhile is not trusted.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const auto reserved = ring->reserved.load(std::memory_order_relaxed);
+  const auto firstIntact = reserved > ring->capacity ? reserved - ring->capacity : 0;
+  const auto skipped = firstIntact > begin ? (firstIntact - begin + frameBytes - 1) / frameBytes * frameBytes : 0;
+  if (skipped >= snapshot.size())
+    return false;
+
+  auto file = createRecordingFile(container, ring->format);
+  if (!file || !file->open(path))
+    return false;
+
+  const auto written = file->write(snapshot.data() + skipped, snapshot.size() - std::size_t(skipped));
+  return file->finish() && written;
+}
+
+} // namespace AudioPipeline
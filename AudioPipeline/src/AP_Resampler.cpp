@@ -0,0 +1,178 @@
+#include "AudioPipeline/AP_Resampler.h"
+
+#include "AP_CpuFeatures.h"
+#include "AP_ResamplerKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <numeric>
+
+namespace AudioPipeline
+{
+
+namespace
+{
+// Ratios with more phases than this, e.g. 44100 to 44101 Hz, use a table of
+// InterpolatedPhases phases and interpolate between them.
+constexpr std::size_t MaxExactPhases = 1024;
+constexpr std::size_t InterpolatedPhases = 256;
+
+// Sinc lobes on each side of the center at full bandwidth, and the share of
+// the narrower Nyquist frequency that is kept.
+constexpr std::size_t ZeroCrossings = 16;
+constexpr double PassBand = 0.95;
+
+constexpr std::size_t TapsAlignment = 8;
+
+DotProductKernel selectDotProduct()
+{
+#ifdef AP_HAVE_X86_KERNELS
+  if (cpuFeatures().avx2)
+    return &avx2DotProduct;
+  if (cpuFeatures().sse2)
+    return &sse2DotProduct;
+#endif
+
+  return &scalarDotProduct;
+}
+
+double sinc(double x)
+{
+  return x == 0. ? 1. : std::sin(std::numbers::pi * x) / (std::numbers::pi * x);
+}
+
+// Blackman window over [-1, 1].
+double window(double x)
+{
+  if (std::abs(x) >= 1.)
+    return 0.;
+
+  return 0.42 + 0.5 * std::cos(std::numbers::pi * x) + 0.08 * std::cos(2. * std::numbers::pi * x);
+}
+} // namespace
+
+Resampler::Resampler(std::uint32_t inputRate, std::uint32_t outputRate, std::uint32_t channelsCount)
+    : inputRate_(std::max<std::uint32_t>(inputRate, 1))
+    , outputRate_(std::max<std::uint32_t>(outputRate, 1))
+    , channelsCount_(std::max<std::uint32_t>(channelsCount, 1))
+    , dotProduct_(selectDotProduct())
+{
+  const auto divisor = std::gcd(inputRate_, outputRate_);
+  inputStep_ = inputRate_ / divisor;
+  outputStep_ = outputRate_ / divisor;
+
+  interpolatesPhases_ = outputStep_ > MaxExactPhases;
+  phasesCount_ = interpolatesPhases_ ? InterpolatedPhases : std::size_t(outputStep_);
+
+  const auto cutoff = std::min(1., double(outputRate_) / double(inputRate_)) * PassBand;
+  const auto halfLength = std::size_t(std::ceil(double(ZeroCrossings) / cutoff));
+  tapsCount_ = (2 * halfLength + TapsAlignment - 1) / TapsAlignment * TapsAlignment;
+
+  // Tap j of phase p weighs the input frame j - tapsCount_ / 2 + 1 frames
+  // away from the output position's integer part, p / phasesCount_ ahead
+  // of it. Interpolated tables get one more phase, the next frame's first.
+  const auto tablePhases = phasesCount_ + (interpolatesPhases_ ? 1 : 0);
+  const auto center = double(tapsCount_ / 2 - 1);
+  taps_.resize(tablePhases * tapsCount_);
+  for (std::size_t phase = 0; phase < tablePhases; ++phase)
+  {
+    auto* taps = taps_.data() + phase * tapsCount_;
+    const auto fraction = double(phase) / double(phasesCount_);
+
+    double sum = 0.;
+    for (std::size_t tap = 0; tap < tapsCount_; ++tap)
+    {
+      const auto distance = double(tap) - center - fraction;
+      const auto value = cutoff * sinc(cutoff * distance) * window(distance / double(tapsCount_ / 2));
+      taps[tap] = float(value);
+      sum += value;
+    }
+
+    // Unity gain at DC for every phase.
+    for (std::size_t tap = 0; tap < tapsCount_; ++tap)
+      taps[tap] = float(taps[tap] / sum);
+  }
+
+  historyCapacity_ = tapsCount_ + MaxBlockFrames;
+  history_.resize(historyCapacity_ * channelsCount_);
+
+  reset();
+}
+
+std::size_t Resampler::maxOutputFrames(std::size_t inputFrames) const
+{
+  return std::size_t((std::uint64_t(inputFrames) + tapsCount_) * outputStep_ / inputStep_) + 1;
+}
+
+void Resampler::reset()
+{
+  // Silence before the first frame, which then sits at the filter center.
+  std::fill(history_.begin(), history_.end(), 0.f);
+  historyFrames_ = tapsCount_ / 2 - 1;
+  historyStart_ = 0;
+  phaseAccumulator_ = 0;
+}
+
+std::size_t Resampler::process(const std::int16_t* input, std::size_t framesCount, std::int16_t* output)
+{
+  framesCount = std::min(framesCount, MaxBlockFrames);
+
+  for (std::size_t channel = 0; channel < channelsCount_; ++channel)
+  {
+    auto* history = history_.data() + channel * historyCapacity_ + historyFrames_;
+    for (std::size_t frame = 0; frame < framesCount; ++frame)
+      history[frame] = input[frame * channelsCount_ + channel];
+  }
+  historyFrames_ += framesCount;
+
+  std::size_t outputFrames = 0;
+  while (historyStart_ + tapsCount_ <= historyFrames_)
+  {
+    const float* taps = nullptr;
+    const float* nextTaps = nullptr;
+    float weight = 0.f;
+    if (interpolatesPhases_)
+    {
+      const auto position = double(phaseAccumulator_) * double(phasesCount_) / double(outputStep_);
+      const auto phase = std::size_t(position);
+      taps = phaseTaps(phase);
+      nextTaps = phaseTaps(phase + 1);
+      weight = float(position - double(phase));
+    }
+    else
+    {
+      taps = phaseTaps(std::size_t(phaseAccumulator_));
+    }
+
+    for (std::size_t channel = 0; channel < channelsCount_; ++channel)
+    {
+      const auto* samples = history_.data() + channel * historyCapacity_ + historyStart_;
+
+      auto value = dotProduct_(samples, taps, tapsCount_);
+      if (nextTaps)
+        value += (dotProduct_(samples, nextTaps, tapsCount_) - value) * weight;
+
+      *output++ = static_cast<std::int16_t>(std::clamp(std::lround(value), -32768L, 32767L));
+    }
+    ++outputFrames;
+
+    phaseAccumulator_ += inputStep_;
+    historyStart_ += std::size_t(phaseAccumulator_ / outputStep_);
+    phaseAccumulator_ %= outputStep_;
+  }
+
+  // Moves what the next outputs still need to the front.
+  const auto keptFrames = historyFrames_ - std::min(historyStart_, historyFrames_);
+  for (std::size_t channel = 0; channel < channelsCount_; ++channel)
+  {
+    auto* history = history_.data() + channel * historyCapacity_;
+    std::copy_n(history + std::min(historyStart_, historyFrames_), keptFrames, history);
+  }
+  historyStart_ -= historyFrames_ - keptFrames;
+  historyFrames_ = keptFrames;
+
+  return outputFrames;
+}
+
+} // namespace AudioPipeline
@@ -0,0 +1,24 @@
+#include "AP_ResamplerKernels.h"
+
+#include <immintrin.h>
+
+namespace AudioPipeline
+{
+
+float avx2DotProduct(const float* samples, const float* taps, std::size_t tapsCount)
+{
+  __m256 sum = _mm256_setzero_ps();
+
+  for (std::size_t index = 0; index < tapsCount; index += 8)
+  {
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(samples + index), _mm256_loadu_ps(taps + index)));
+  }
+
+  __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+  half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+  half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+
+  return _mm_cvtss_f32(half);
+}
+
+} // namespace AudioPipeline
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+namespace AudioPipeline
+{
+using DotProductKernel = float (*)(const float* samples, const float* taps, std::size_t tapsCount);
+
+// Dot product of a history window with the taps of one filter phase. The
+// taps count is a multiple of 8.
+inline float scalarDotProduct(const float* samples, const float* taps, std::size_t tapsCount)
+{
+  float sum = 0.f;
+  for (std::size_t index = 0; index < tapsCount; ++index)
+    sum += samples[index] * taps[index];
+
+  return sum;
+}
+
+#ifdef AP_HAVE_X86_KERNELS
+float sse2DotProduct(const float* samples, const float* taps, std::size_t tapsCount);
+float avx2DotProduct(const float* samples, const float* taps, std::size_t tapsCount);
+#endif
+} // namespace AudioPipeline
@@ -0,0 +1,27 @@
+#include "AP_ResamplerKernels.h"
+
+#include <emmintrin.h>
+
+namespace AudioPipeline
+{
+
+float sse2DotProduct(const float* samples, const float* taps, std::size_t tapsCount)
+{
+  // Two accumulators hide the latency of the additions.
+  __m128 first = _mm_setzero_ps();
+  __m128 second = _mm_setzero_ps();
+
+  for (std::size_t index = 0; index < tapsCount; index += 8)
+  {
+    first = _mm_add_ps(first, _mm_mul_ps(_mm_loadu_ps(samples + index), _mm_loadu_ps(taps + index)));
+    second = _mm_add_ps(second, _mm_mul_ps(_mm_loadu_ps(samples + index + 4), _mm_loadu_ps(taps + index + 4)));
+  }
+
+  __m128 sum = _mm_add_ps(first, second);
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+
+  return _mm_cvtss_f32(sum);
+}
+
+} // namespace AudioPipeline
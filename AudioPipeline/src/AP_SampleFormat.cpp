@@ -0,0 +1,31 @@
+#include "AudioPipeline/AP_SampleFormat.h"
+
+namespace AudioPipeline
+{
+
+std::optional<SampleFormat> makeSampleFormat(std::uint8_t sampleBits, bool isSigned, bool isLittleEndian)
+{
+  switch (sampleBits)
+  {
+    case 8:
+      return isSigned ? SampleFormat::S8 : SampleFormat::U8;
+    case 16:
+      if (isSigned)
+        return isLittleEndian ? SampleFormat::S16LE : SampleFormat::S16BE;
+      return isLittleEndian ? SampleFormat::U16LE : SampleFormat::U16BE;
+    default:
+      return std::nullopt;
+  }
+}
+
+std::size_t bytesPerSample(SampleFormat format)
+{
+  return format == SampleFormat::U8 || format == SampleFormat::S8 ? 1 : 2;
+}
+
+std::uint32_t fullScaleOf(SampleFormat format)
+{
+  return bytesPerSample(format) == 1 ? 128 : 32768;
+}
+
+} // namespace AudioPipeline
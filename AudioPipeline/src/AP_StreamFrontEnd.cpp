@@ -0,0 +1,139 @@
+#include "AudioPipeline/AP_StreamFrontEnd.h"
+
+#include "AudioPipeline/AP_ProcessingStages.h"
+
+#include <bit>
+#include <iostream>
+#include <optional>
+
+namespace AudioPipeline
+{
+
+namespace
+{
+// Samples of uncompressed frames as the listener delivers them. MicBridge
+// phones send host order (little endian) samples; float is not taken by
+// the pipeline.
+std::optional<SampleFormat> sampleFormatOf(Broadcast::PcmConversion conversion)
+{
+  switch (conversion)
+  {
+    case Broadcast::PcmConversion::None:
+      return SampleFormat::S16LE;
+    case Broadcast::PcmConversion::NetworkToHostS16:
+      return std::endian::native == std::endian::little ? SampleFormat::S16LE : SampleFormat::S16BE;
+    case Broadcast::PcmConversion::NetworkToHostFloat:
+      break;
+  }
+
+  return std::nullopt;
+}
+} // namespace
+
+StreamFrontEnd::StreamFrontEnd(OutputsWiring outputsWiring, ErrorCallback onError)
+    : outputsWiring_(std::move(outputsWiring))
+    , onError_(std::move(onError))
+    , concealStage_(std::make_shared<ConcealStage>(concealer_))
+    , voiceActivityStage_(std::make_shared<VoiceActivityStage>())
+{
+}
+
+StreamFrontEnd::~StreamFrontEnd() = default;
+
+VoiceActivityStats StreamFrontEnd::voiceActivityStats() const
+{
+  return voiceActivityStage_->stats();
+}
+
+void StreamFrontEnd::onStreamFormat(const Broadcast::StreamFormat& format)
+{
+  isCompressedStream_ = format.codecName == "MPEG4-GENERIC";
+
+  // Compressed streams nominally decode to 16-bit samples, the decoder
+  // tells the actual format.
+  const auto sampleFormat = isCompressedStream_ ? SampleFormat::S16LE : sampleFormatOf(format.pcmConversion);
+  if (!sampleFormat)
+  {
+    reportError("Float PCM delivery is not supported, the stream will be dropped");
+    graph_.rewire({});
+    return;
+  }
+
+  streamFormat_.sampleFormat = *sampleFormat;
+  streamFormat_.sampleRate = format.sampleRate;
+  streamFormat_.channelsCount = format.channelsCount;
+
+  concealer_.setFormat(streamFormat_);
+  concealer_.setNativeConcealment(nullptr);
+
+  AudioDecoderPtr decoder;
+  if (isCompressedStream_)
+  {
+    DecoderConfig config;
+    config.sampleRate = format.sampleRate;
+    config.channelsCount = format.channelsCount;
+    config.codecConfig = format.codecConfig;
+
+    decoder = createAacDecoder(config);
+    if (decoder)
+    {
+      concealer_.setNativeConcealment([decoder = decoder.get()](DecodedAudio& output) {
+        return decoder->conceal(output);
+      });
+    }
+    else
+    {
+      reportError("No AAC decoder available, the stream will be dropped");
+    }
+  }
+
+  ProcessingGraph::Wiring wiring;
+  const auto decode = wiring.add(std::make_shared<DecodeStage>(std::move(decoder)));
+  const auto conceal = wiring.add(concealStage_, decode);
+  const auto voiceActivity = wiring.add(voiceActivityStage_, conceal);
+  outputsWiring_(wiring, voiceActivity);
+  graph_.rewire(std::move(wiring));
+}
+
+void StreamFrontEnd::onFrameBuffer(const Broadcast::FrameBuffer& frame)
+{
+  if (frame.hasRtpInfo())
+  {
+    const auto gap = concealer_.onPacket(frame.rtpSequenceNumber(), frame.rtpTimestamp());
+    if (gap.discardPacket)
+      return;
+
+    if (gap.size != 0)
+    {
+      AudioBlock block;
+      block.data = gap.data;
+      block.size = gap.size;
+      // Gaps are filled in the format the stream decodes to.
+      block.format = concealer_.format();
+      block.isConcealment = true;
+      graph_.process(block);
+    }
+  }
+
+  onFrame(frame.data(), frame.size());
+}
+
+void StreamFrontEnd::onFrame(const std::uint8_t* data, std::size_t len)
+{
+  AudioBlock block;
+  block.data = data;
+  block.size = len;
+  block.format = streamFormat_;
+  block.isEncoded = isCompressedStream_;
+  graph_.process(block);
+}
+
+void StreamFrontEnd::reportError(const std::string& message)
+{
+  if (onError_)
+    onError_(message);
+  else
+    std::cerr << message << std::endl;
+}
+
+} // namespace AudioPipeline
@@ -0,0 +1,217 @@
+#include "AudioPipeline/AP_SubmissionEngine.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace AudioPipeline
+{
+
+namespace
+{
+constexpr std::chrono::milliseconds CompletionPollInterval(50);
+// Upper bound for waiting on cancelled requests when stopping.
+constexpr std::chrono::seconds DrainTimeout(1);
+} // namespace
+
+SubmissionEngine::SubmissionEngine(SubmissionDevicePtr device,
+                                   std::chrono::microseconds period,
+                                   std::uint32_t requestsCount)
+    : PeriodicAudioSink(period)
+    , device_(std::move(device))
+    , requestsCount_(std::max<std::uint32_t>(requestsCount, 1))
+{
+}
+
+SubmissionEngine::~SubmissionEngine()
+{
+  stop();
+
+  // A device still holding requests may write to their chunks at any time;
+  // they are leaked rather than freed under it.
+  if (isDeviceOpen_ && !collectStrandedRequests())
+    static_cast<void>(requests_.release());
+}
+
+bool SubmissionEngine::openBackend(const PcmFormat& format)
+{
+  if (isDeviceOpen_ && !collectStrandedRequests())
+    return false;
+
+  requests_ = std::make_unique<Request[]>(requestsCount_);
+  for (std::uint32_t index = 0; index < requestsCount_; ++index)
+  {
+    requests_[index].chunk = std::make_unique<std::uint8_t[]>(periodSize());
+  }
+  nextRequest_ = 0;
+
+  if (!device_->open(format, requestsCount_))
+    return false;
+  isDeviceOpen_ = true;
+
+  stopping_ = false;
+  completionThread_ = std::thread([this]() { completionLoop(); });
+
+  return true;
+}
+
+bool SubmissionEngine::writePeriod(const std::uint8_t* data, std::size_t size)
+{
+  return submitPeriod(data, size, false);
+}
+
+bool SubmissionEngine::writeSilentPeriod(const std::uint8_t* data, std::size_t size)
+{
+  return submitPeriod(data, size, true);
+}
+
+bool SubmissionEngine::submitPeriod(const std::uint8_t* data, std::size_t size, bool isSilent)
+{
+  auto& request = requests_[nextRequest_];
+  if (request.inFlight.load(std::memory_order_acquire))
+  {
+    chunksDropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // The device has no notion of silence, it gets zeros; in a silent stretch
+  // the chunks already hold them.
+  if (!isSilent)
+  {
+    std::memcpy(request.chunk.get(), data, size);
+    request.zeroedSize = 0;
+  }
+  else if (request.zeroedSize < size)
+  {
+    std::memset(request.chunk.get(), 0, size);
+    request.zeroedSize = size;
+  }
+  request.submittedAt = std::chrono::steady_clock::now();
+  request.inFlight.store(true, std::memory_order_relaxed);
+  inFlight_.fetch_add(1, std::memory_order_relaxed);
+
+  if (!device_->submit(request.chunk.get(), size, nextRequest_))
+  {
+    request.inFlight.store(false, std::memory_order_relaxed);
+    inFlight_.fetch_sub(1, std::memory_order_relaxed);
+    chunksFailed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  chunksSubmitted_.fetch_add(1, std::memory_order_relaxed);
+  if (isSilent)
+    silentChunks_.fetch_add(1, std::memory_order_relaxed);
+  nextRequest_ = (nextRequest_ + 1) % requestsCount_;
+
+  return true;
+}
+
+void SubmissionEngine::closeBackend()
+{
+  if (!completionThread_.joinable())
+    return;
+
+  stopping_ = true;
+  device_->cancel();
+  completionThread_.join();
+
+  if (inFlight_.load(std::memory_order_relaxed) != 0)
+    return;
+
+  device_->close();
+  isDeviceOpen_ = false;
+}
+
+bool SubmissionEngine::collectStrandedRequests()
+{
+  const auto deadline = std::chrono::steady_clock::now() + DrainTimeout;
+  while (inFlight_.load(std::memory_order_relaxed) != 0 && std::chrono::steady_clock::now() < deadline)
+  {
+    SubmissionCompletion completion;
+    if (device_->waitCompletion(CompletionPollInterval, completion))
+      onCompleted(completion);
+  }
+
+  if (inFlight_.load(std::memory_order_relaxed) != 0)
+    return false;
+
+  device_->close();
+  isDeviceOpen_ = false;
+  return true;
+}
+
+std::int64_t SubmissionEngine::backendBufferedBytes() const
+{
+  // A chunk completes once the device has played it.
+  return std::int64_t(inFlight_.load(std::memory_order_relaxed)) * std::int64_t(periodSize());
+}
+
+void SubmissionEngine::completionLoop()
+{
+  auto drainDeadline = std::chrono::steady_clock::time_point::max();
+
+  while (!stopping_ || inFlight_.load(std::memory_order_relaxed) != 0)
+  {
+    const auto now = std::chrono::steady_clock::now();
+    if (stopping_ && drainDeadline == std::chrono::steady_clock::time_point::max())
+      drainDeadline = now + DrainTimeout;
+    if (now >= drainDeadline)
+      break;
+
+    SubmissionCompletion completion;
+    if (device_->waitCompletion(CompletionPollInterval, completion))
+      onCompleted(completion);
+  }
+}
+
+void SubmissionEngine::onCompleted(const SubmissionCompletion& completion)
+{
+  if (completion.token >= requestsCount_)
+    return;
+
+  auto& request = requests_[completion.token];
+
+  const auto latency = std::chrono::steady_clock::now() - request.submittedAt;
+  const auto latencyUs = static_cast<std::uint32_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+
+  if (completion.succeeded)
+  {
+    // Only this thread updates latencies, plain load/store pairs suffice.
+    const auto average = averageLatencyUs_.load(std::memory_order_relaxed);
+    const auto updatedAverage = chunksCompleted_.load(std::memory_order_relaxed) == 0
+                                    ? latencyUs
+                                    : std::uint32_t(std::int64_t(average) + (std::int64_t(latencyUs) - average) / 16);
+
+    lastLatencyUs_.store(latencyUs, std::memory_order_relaxed);
+    averageLatencyUs_.store(updatedAverage, std::memory_order_relaxed);
+    maxLatencyUs_.store(std::max(maxLatencyUs_.load(std::memory_order_relaxed), latencyUs), std::memory_order_relaxed);
+    chunksCompleted_.fetch_add(1, std::memory_order_relaxed);
+  }
+  else
+  {
+    chunksFailed_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  inFlight_.fetch_sub(1, std::memory_order_relaxed);
+  request.inFlight.store(false, std::memory_order_release);
+}
+
+SubmissionStats SubmissionEngine::submissionStats() const
+{
+  constexpr auto Relaxed = std::memory_order_relaxed;
+
+  SubmissionStats stats;
+  stats.chunksSubmitted = chunksSubmitted_.load(Relaxed);
+  stats.chunksCompleted = chunksCompleted_.load(Relaxed);
+  stats.chunksFailed = chunksFailed_.load(Relaxed);
+  stats.chunksDropped = chunksDropped_.load(Relaxed);
+  stats.silentChunks = silentChunks_.load(Relaxed);
+  stats.inFlight = inFlight_.load(Relaxed);
+  stats.lastLatencyUs = lastLatencyUs_.load(Relaxed);
+  stats.averageLatencyUs = averageLatencyUs_.load(Relaxed);
+  stats.maxLatencyUs = maxLatencyUs_.load(Relaxed);
+
+  return stats;
+}
+
+} // namespace AudioPipeline
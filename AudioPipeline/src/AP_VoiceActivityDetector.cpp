@@ -0,0 +1,76 @@
+#include "AudioPipeline/AP_VoiceActivityDetector.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace AudioPipeline
+{
+
+VoiceActivityDetector::VoiceActivityDetector(VoiceActivityOptions options)
+    : options_(options)
+    , threshold_(std::pow(10.f, options.thresholdDb / 20.f))
+{
+}
+
+void VoiceActivityDetector::setFormat(const PcmFormat& format)
+{
+  meter_.reset();
+  frameBytes_ = format.bytesPerFrame();
+  hangoverFrames_ = std::uint64_t(format.sampleRate) * std::uint64_t(options_.hangover.count()) / 1000;
+  hangoverLeft_ = 0;
+  isSpeaking_ = false;
+
+  if (frameBytes_ != 0 && format.sampleRate != 0)
+    meter_.emplace(format.sampleFormat);
+}
+
+bool VoiceActivityDetector::isSilent(const void* data, std::size_t bytes)
+{
+  if (!meter_)
+    return false;
+
+  const auto started = std::chrono::steady_clock::now();
+
+  const auto framesCount = bytes / frameBytes_;
+  const auto isLoud = meter_->rmsLevel(meter_->measure(data, framesCount * frameBytes_)) >= threshold_;
+
+  bool isSilent = false;
+  if (isLoud)
+  {
+    if (!isSpeaking_)
+      speechOnsets_.fetch_add(1, std::memory_order_relaxed);
+
+    isSpeaking_ = true;
+    hangoverLeft_ = hangoverFrames_;
+  }
+  else if (hangoverLeft_ != 0)
+  {
+    hangoverLeft_ -= std::min<std::uint64_t>(hangoverLeft_, framesCount);
+  }
+  else
+  {
+    isSpeaking_ = false;
+    isSilent = true;
+  }
+
+  framesAnalyzed_.fetch_add(framesCount, std::memory_order_relaxed);
+  if (isSilent)
+    silentFrames_.fetch_add(framesCount, std::memory_order_relaxed);
+
+  const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+  detectionNs_.fetch_add(std::uint64_t(elapsed.count()), std::memory_order_relaxed);
+
+  return isSilent;
+}
+
+VoiceActivityStats VoiceActivityDetector::stats() const
+{
+  VoiceActivityStats stats;
+  stats.framesAnalyzed = framesAnalyzed_.load(std::memory_order_relaxed);
+  stats.silentFrames = silentFrames_.load(std::memory_order_relaxed);
+  stats.speechOnsets = speechOnsets_.load(std::memory_order_relaxed);
+  stats.detectionNs = detectionNs_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+} // namespace AudioPipeline
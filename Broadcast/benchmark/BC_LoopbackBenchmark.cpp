@@ -0,0 +1,548 @@
+#include "BC_LoopbackServer.h"
+
+#include "Broadcast/BC_Listener.h"
+#include "Broadcast/BC_Runtime.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+namespace
+{
+using namespace Broadcast;
+using Clock = std::chrono::steady_clock;
+
+struct BenchmarkOptions
+{
+  Benchmark::LoopbackServerOptions server;
+
+  std::size_t streamsCount = 1;
+  std::size_t eventLoopsCount = 1;
+  std::chrono::seconds duration{10};
+  // Streams that have not delivered a frame by then are reported as failed.
+  std::chrono::seconds connectTimeout{10};
+
+  ListenerOptions listener = []()
+  {
+    ListenerOptions options;
+    options.transport = RtpTransport::Udp;
+    return options;
+  }();
+};
+
+std::int64_t wallClockUs()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+std::int64_t processCpuTimeUs()
+{
+  rusage usage = {};
+  getrusage(RUSAGE_SELF, &usage);
+
+  const auto toUs = [](const timeval& time) { return std::int64_t(time.tv_sec) * 1000000 + time.tv_usec; };
+  return toUs(usage.ru_utime) + toUs(usage.ru_stime);
+}
+
+// Latency distribution with fixed-width buckets; the last bucket collects
+// everything above the covered range.
+class LatencyHistogram
+{
+public:
+  static constexpr std::int64_t BucketUs = 100;
+  static constexpr std::size_t BucketsCount = 2000;
+
+  void add(std::int64_t latencyUs)
+  {
+    const auto bucket = std::min<std::size_t>(std::max<std::int64_t>(latencyUs, 0) / BucketUs, BucketsCount - 1);
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void merge(const LatencyHistogram& other)
+  {
+    for (std::size_t bucket = 0; bucket < BucketsCount; ++bucket)
+    {
+      buckets_[bucket].fetch_add(other.buckets_[bucket].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+  }
+
+  // Upper bound of the bucket the given fraction of samples falls into.
+  std::int64_t percentileUs(double fraction) const
+  {
+    std::uint64_t total = 0;
+    for (const auto& bucket : buckets_)
+      total += bucket.load(std::memory_order_relaxed);
+
+    if (total == 0)
+      return 0;
+
+    const auto rank = static_cast<std::uint64_t>(fraction * double(total - 1));
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < BucketsCount; ++bucket)
+    {
+      seen += buckets_[bucket].load(std::memory_order_relaxed);
+      if (seen > rank)
+        return std::int64_t(bucket + 1) * BucketUs;
+    }
+
+    return std::int64_t(BucketsCount) * BucketUs;
+  }
+
+private:
+  std::array<std::atomic<std::uint64_t>, BucketsCount> buckets_ = {};
+};
+
+// Counts what one stream delivers. Frames are only timed while the
+// measurement window is open, connection setup and warm-up are excluded.
+class StreamProbe final : public AudioFramesHandler
+{
+public:
+  StreamProbe(Clock::time_point started, const std::atomic_bool& measuring)
+      : started_(started)
+      , measuring_(measuring)
+  {
+  }
+
+  void onFrame(const std::uint8_t*, std::size_t len) override { countFrame(len); }
+
+  void onFrameBuffer(const FrameBuffer& frame) override
+  {
+    const auto latencyUs = wallClockUs() - frame.presentationTimeUs();
+    countFrame(frame.size());
+
+    if (!measuring_.load(std::memory_order_relaxed))
+      return;
+
+    latency.add(latencyUs);
+    latencySumUs.fetch_add(latencyUs, std::memory_order_relaxed);
+    latencySamples.fetch_add(1, std::memory_order_relaxed);
+
+    auto maxUs = latencyMaxUs.load(std::memory_order_relaxed);
+    while (latencyUs > maxUs && !latencyMaxUs.compare_exchange_weak(maxUs, latencyUs, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  bool hasFirstFrame() const { return firstFrameUs.load(std::memory_order_acquire) >= 0; }
+  bool isReleased() const { return releasedAt.load(std::memory_order_acquire) != Clock::rep(0); }
+
+  std::atomic<std::int64_t> firstFrameUs = -1;
+  std::atomic<std::uint64_t> framesCount = 0;
+  std::atomic<std::uint64_t> bytesCount = 0;
+
+  LatencyHistogram latency;
+  std::atomic<std::int64_t> latencySumUs = 0;
+  std::atomic<std::uint64_t> latencySamples = 0;
+  std::atomic<std::int64_t> latencyMaxUs = 0;
+
+  // When the listener let go of its frames handler, see ReleaseProbe.
+  std::atomic<Clock::rep> releasedAt = 0;
+
+private:
+  void countFrame(std::size_t len)
+  {
+    if (framesCount.fetch_add(1, std::memory_order_relaxed) == 0)
+    {
+      const auto sinceStart = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - started_);
+      firstFrameUs.store(sinceStart.count(), std::memory_order_release);
+    }
+    bytesCount.fetch_add(len, std::memory_order_relaxed);
+  }
+
+  const Clock::time_point started_;
+  const std::atomic_bool& measuring_;
+};
+
+// The frames handler a listener is given in front of its StreamProbe. The
+// event loop destroys the listener some time after ~Listener returned, and
+// the handler goes with it; the probe outlives both and keeps the moment.
+class ReleaseProbe final : public AudioFramesHandler
+{
+public:
+  explicit ReleaseProbe(std::shared_ptr<StreamProbe> probe)
+      : probe_(std::move(probe))
+  {
+  }
+
+  ~ReleaseProbe() override
+  {
+    probe_->releasedAt.store(Clock::now().time_since_epoch().count(), std::memory_order_release);
+  }
+
+  void onStreamFormat(const StreamFormat& format) override { probe_->onStreamFormat(format); }
+  void onFrame(const std::uint8_t* data, std::size_t len) override { probe_->onFrame(data, len); }
+  void onFrameBuffer(const FrameBuffer& frame) override { probe_->onFrameBuffer(frame); }
+
+private:
+  const std::shared_ptr<StreamProbe> probe_;
+};
+
+// The event loops belong to the runtime, which stops them when it is
+// destroyed after main returns. Being constant initialized, the timer is
+// destroyed after the runtime and reports how long stopping the loops took.
+class EventLoopsStopTimer
+{
+public:
+  void start() { started_ = Clock::now(); }
+
+  ~EventLoopsStopTimer()
+  {
+    if (!started_)
+      return;
+
+    const auto stopUs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - *started_).count();
+    std::cout << "event loops stop      " << stopUs << " us (at exit)" << std::endl;
+  }
+
+private:
+  std::optional<Clock::time_point> started_;
+};
+
+EventLoopsStopTimer eventLoopsStopTimer;
+
+class ImmediateDispatchQueue : public DispatchQueue
+{
+public:
+  void dispatchEvent(VoidEvent event) override { event(); }
+};
+
+class CountingEventsHandler : public ErrorHandler
+                            , public SuccessHandler
+{
+public:
+  void onErrorOccured(int code, const std::string& errorMsg) override
+  {
+    errorsCount.fetch_add(1, std::memory_order_relaxed);
+    std::cerr << "Error " << code << ": " << errorMsg << std::endl;
+  }
+
+  void onConnectSuccess(const std::string&) override { connectedCount.fetch_add(1, std::memory_order_relaxed); }
+
+  std::atomic<std::size_t> errorsCount = 0;
+  std::atomic<std::size_t> connectedCount = 0;
+};
+
+void printUsage(const char* executable)
+{
+  std::cerr << "Usage: " << executable << " [options]\n"
+            << "Streams synthetic L16 audio from an in-process RTSP server on 127.0.0.1 to Broadcast\n"
+            << "listeners and reports throughput, latency, CPU cost, time to first frame and teardown.\n"
+            << "  --streams N        concurrent listeners (1)\n"
+            << "  --seconds S        measurement window (10)\n"
+            << "  --loops N          live555 event loops listeners are spread across (1)\n"
+            << "  --rate HZ          sample rate (48000)\n"
+            << "  --channels N       channels count (1)\n"
+            << "  --frame-samples N  samples per channel in one RTP packet (240)\n"
+            << "  --port N           RTSP server port (8554)\n"
+            << "  --queued           deliver frames through the frames queue\n"
+            << "  --jitter           enable the jitter buffer\n"
+            << "  --pipelined        pipeline SETUP and PLAY requests\n"
+            << "  --transport T      udp, tcp or auto (udp)\n"
+            << "  --pcm C            none, s16 or float conversion of the network order samples (none)" << std::endl;
+}
+
+bool parseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+  for (int arg = 1; arg < argc; ++arg)
+  {
+    const std::string name = argv[arg];
+    if (name == "--queued")
+    {
+      options.listener.framesDelivery = FramesDelivery::Queued;
+      continue;
+    }
+    if (name == "--jitter")
+    {
+      options.listener.jitterBuffer.enabled = true;
+      continue;
+    }
+    if (name == "--pipelined")
+    {
+      options.listener.pipelinedSetup = true;
+      continue;
+    }
+
+    if (arg + 1 >= argc)
+      return false;
+
+    if (name == "--transport")
+    {
+      const std::string transport = argv[++arg];
+      if (transport == "udp")
+        options.listener.transport = RtpTransport::Udp;
+      else if (transport == "tcp")
+        options.listener.transport = RtpTransport::Tcp;
+      else if (transport == "auto")
+        options.listener.transport = RtpTransport::Auto;
+      else
+        return false;
+      continue;
+    }
+
+    if (name == "--pcm")
+    {
+      const std::string conversion = argv[++arg];
+      if (conversion == "none")
+        options.listener.pcmConversion = PcmConversion::None;
+      else if (conversion == "s16")
+        options.listener.pcmConversion = PcmConversion::NetworkToHostS16;
+      else if (conversion == "float")
+        options.listener.pcmConversion = PcmConversion::NetworkToHostFloat;
+      else
+        return false;
+      continue;
+    }
+
+    const auto value = std::stoul(argv[++arg]);
+    if (name == "--streams")
+      options.streamsCount = value;
+    else if (name == "--seconds")
+      options.duration = std::chrono::seconds(value);
+    else if (name == "--loops")
+      options.eventLoopsCount = value;
+    else if (name == "--rate")
+      options.server.sampleRate = static_cast<std::uint32_t>(value);
+    else if (name == "--channels")
+      options.server.channelsCount = static_cast<std::uint32_t>(value);
+    else if (name == "--frame-samples")
+      options.server.frameSamples = static_cast<std::uint32_t>(value);
+    else if (name == "--port")
+      options.server.port = static_cast<std::uint16_t>(value);
+    else
+      return false;
+  }
+
+  return options.streamsCount > 0 && options.server.sampleRate > 0 && options.server.channelsCount > 0
+         && options.server.frameSamples > 0;
+}
+
+int runBenchmark(const BenchmarkOptions& options)
+{
+  Benchmark::LoopbackServer server(options.server);
+  if (!server.isRunning())
+    return 1;
+
+  auto eventsHandler = std::make_shared<CountingEventsHandler>();
+  auto dispatchQueue = std::make_shared<ImmediateDispatchQueue>();
+  std::atomic_bool measuring = false;
+
+  std::vector<std::shared_ptr<StreamProbe>> probes;
+  std::vector<std::unique_ptr<Listener>> listeners;
+
+  const auto started = Clock::now();
+  for (std::size_t stream = 0; stream < options.streamsCount; ++stream)
+  {
+    probes.push_back(std::make_shared<StreamProbe>(started, measuring));
+    listeners.push_back(std::make_unique<Listener>("127.0.0.1",
+                                                   options.server.port,
+                                                   options.server.authCode,
+                                                   std::make_shared<ReleaseProbe>(probes.back()),
+                                                   dispatchQueue,
+                                                   eventsHandler,
+                                                   eventsHandler,
+                                                   options.listener));
+  }
+
+  const auto allStreaming = [&probes]()
+  { return std::all_of(probes.begin(), probes.end(), [](const auto& probe) { return probe->hasFirstFrame(); }); };
+
+  while (!allStreaming() && Clock::now() - started < options.connectTimeout)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // Lets every stream settle past its first frames before measuring.
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+  std::vector<std::uint64_t> framesAtStart;
+  for (const auto& probe : probes)
+    framesAtStart.push_back(probe->framesCount.load(std::memory_order_relaxed));
+
+  const auto processCpuAtStart = processCpuTimeUs();
+  const auto serverCpuAtStart = server.cpuTimeUs();
+  const auto windowStart = Clock::now();
+  measuring = true;
+
+  std::this_thread::sleep_for(options.duration);
+
+  measuring = false;
+  const auto windowUs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - windowStart).count();
+  const auto processCpuUs = processCpuTimeUs() - processCpuAtStart;
+  const auto serverCpuUs = server.cpuTimeUs() - serverCpuAtStart;
+
+  // Phases not reached are zero, so each one is averaged over the streams
+  // that got through it rather than over every stream started.
+  struct PhaseSum
+  {
+    void add(std::uint64_t us)
+    {
+      if (us == 0)
+        return;
+      sumUs += us;
+      ++count;
+    }
+    double averageMs() const { return count ? sumUs / 1000. / count : 0.; }
+
+    std::uint64_t sumUs = 0;
+    std::size_t count = 0;
+  };
+
+  ListenerStats listenerStats;
+  PhaseSum setup;
+  PhaseSum play;
+  PhaseSum firstFrame;
+  PhaseSum transit;
+  std::size_t overTcpCount = 0;
+  for (const auto& listener : listeners)
+  {
+    const auto stats = listener->getStats();
+    setup.add(stats.connection.setupUs);
+    play.add(stats.connection.playUs);
+    firstFrame.add(stats.connection.firstFrameUs);
+    transit.add(stats.connection.transitUs);
+    // Only a stream that got to PLAY has a transport.
+    if (stats.connection.playUs != 0)
+      overTcpCount += stats.connection.streamingOverTcp ? 1 : 0;
+    listenerStats.receive.framesDroppedNoBuffer += stats.receive.framesDroppedNoBuffer;
+    listenerStats.receive.framesTruncated += stats.receive.framesTruncated;
+    listenerStats.receive.bufferResizes += stats.receive.bufferResizes;
+    listenerStats.receive.frameBufferSize = std::max(listenerStats.receive.frameBufferSize, stats.receive.frameBufferSize);
+    listenerStats.jitterBuffer.underruns += stats.jitterBuffer.underruns;
+    listenerStats.jitterBuffer.lateDrops += stats.jitterBuffer.lateDrops;
+  }
+
+  // Every listener is torn down on its event loop, from destroying it to
+  // the loop releasing its frames handler.
+  std::vector<Clock::time_point> releaseRequested;
+  for (auto& listener : listeners)
+  {
+    releaseRequested.push_back(Clock::now());
+    listener.reset();
+  }
+
+  const auto allReleased = [&probes]()
+  { return std::all_of(probes.begin(), probes.end(), [](const auto& probe) { return probe->isReleased(); }); };
+
+  const auto teardownStarted = Clock::now();
+  while (!allReleased() && Clock::now() - teardownStarted < options.connectTimeout)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  LatencyHistogram teardown;
+  std::int64_t teardownMaxUs = 0;
+  std::size_t releasedCount = 0;
+  for (std::size_t stream = 0; stream < probes.size(); ++stream)
+  {
+    if (!probes[stream]->isReleased())
+      continue;
+
+    const auto releasedAt =
+        Clock::time_point(Clock::duration(probes[stream]->releasedAt.load(std::memory_order_acquire)));
+    const auto teardownUs =
+        std::chrono::duration_cast<std::chrono::microseconds>(releasedAt - releaseRequested[stream]).count();
+    teardown.add(teardownUs);
+    teardownMaxUs = std::max(teardownMaxUs, teardownUs);
+    ++releasedCount;
+  }
+
+  // Aggregates the streams and reports per stream averages.
+  LatencyHistogram latency;
+  std::uint64_t framesCount = 0;
+  std::uint64_t latencySamples = 0;
+  std::int64_t latencySumUs = 0;
+  std::int64_t latencyMaxUs = 0;
+  std::int64_t firstFrameMaxUs = 0;
+  std::int64_t firstFrameSumUs = 0;
+  std::size_t streamingCount = 0;
+
+  for (std::size_t stream = 0; stream < probes.size(); ++stream)
+  {
+    const auto& probe = *probes[stream];
+    framesCount += probe.framesCount.load(std::memory_order_relaxed) - framesAtStart[stream];
+
+    latency.merge(probe.latency);
+    latencySamples += probe.latencySamples.load(std::memory_order_relaxed);
+    latencySumUs += probe.latencySumUs.load(std::memory_order_relaxed);
+    latencyMaxUs = std::max(latencyMaxUs, probe.latencyMaxUs.load(std::memory_order_relaxed));
+
+    if (probe.hasFirstFrame())
+    {
+      const auto firstFrameUs = probe.firstFrameUs.load(std::memory_order_relaxed);
+      firstFrameSumUs += firstFrameUs;
+      firstFrameMaxUs = std::max(firstFrameMaxUs, firstFrameUs);
+      ++streamingCount;
+    }
+  }
+
+  const auto windowSeconds = double(windowUs) / 1e6;
+  const auto expectedFramesPerSecond = double(options.server.sampleRate) / options.server.frameSamples;
+  const auto clientCpuUs = std::max<std::int64_t>(processCpuUs - serverCpuUs, 0);
+
+  std::cout << std::fixed << std::setprecision(2)
+            << "streams               " << streamingCount << " of " << options.streamsCount << " streaming, "
+            << eventsHandler->connectedCount.load() << " connected, " << eventsHandler->errorsCount.load() << " errors\n"
+            << "window                " << windowSeconds << " s\n"
+            << "frames/s per stream   " << (streamingCount ? framesCount / windowSeconds / streamingCount : 0.)
+            << " (expected " << expectedFramesPerSecond << ")\n"
+            << "frames/s total        " << framesCount / windowSeconds << "\n"
+            << "handler latency       avg " << (latencySamples ? latencySumUs / std::int64_t(latencySamples) : 0)
+            << " us, p50 <" << latency.percentileUs(0.5) << " us, p99 <" << latency.percentileUs(0.99)
+            << " us, max " << latencyMaxUs << " us\n"
+            << "time to first frame   avg " << (streamingCount ? firstFrameSumUs / 1000. / streamingCount : 0.)
+            << " ms, max " << firstFrameMaxUs / 1000. << " ms\n"
+            << "handshake             SETUP " << setup.averageMs() << " ms (" << setup.count << "), PLAY "
+            << play.averageMs() << " ms (" << play.count << "), first frame " << firstFrame.averageMs()
+            << " ms (" << firstFrame.count << ") (avg since connecting)\n"
+            << "transport             " << overTcpCount << " over TCP, " << play.count - overTcpCount
+            << " over UDP, transit " << transit.averageMs() * 1000. << " us (avg, after RTCP sync)\n"
+            << "client CPU per stream " << 100. * clientCpuUs / windowUs / options.streamsCount << " % of a core\n"
+            << "server CPU            " << 100. * serverCpuUs / windowUs << " % of a core\n"
+            << "dropped (no buffer)   " << listenerStats.receive.framesDroppedNoBuffer << "\n"
+            << "truncated frames      " << listenerStats.receive.framesTruncated << ", buffers regrown "
+            << listenerStats.receive.bufferResizes << " times, up to " << listenerStats.receive.frameBufferSize
+            << " bytes\n"
+            << "jitter buffer         " << listenerStats.jitterBuffer.underruns << " underruns, "
+            << listenerStats.jitterBuffer.lateDrops << " late drops\n"
+            << "listener teardown     " << releasedCount << " of " << listeners.size() << " released, p99 <"
+            << teardown.percentileUs(0.99) << " us, max " << teardownMaxUs << " us" << std::endl;
+
+  return streamingCount == options.streamsCount ? 0 : 2;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+  BenchmarkOptions options;
+  try
+  {
+    if (!parseOptions(argc, argv, options))
+    {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+  catch (const std::exception&)
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  configureRuntime({options.eventLoopsCount});
+
+  const auto result = runBenchmark(options);
+  eventLoopsStopTimer.start();
+  return result;
+}
@@ -0,0 +1,210 @@
+#include "BC_LoopbackServer.h"
+
+#include <BasicUsageEnvironment.hh>
+#include <liveMedia.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <pthread.h>
+#include <time.h>
+
+namespace Broadcast::Benchmark
+{
+namespace
+{
+// Must match the user name ListenerImpl authenticates with.
+constexpr const char* AuthUserName = "velvetSweatshop";
+
+constexpr unsigned char L16PayloadType = 96;
+constexpr double ToneFrequencyHz = 440.;
+constexpr double ToneAmplitude = 0.5 * 32767.;
+
+// Produces big-endian 16-bit sine frames back to back. Presentation times
+// advance by the frame duration from the wall clock at start, which is what
+// MultiFramedRTPSink paces the stream by.
+class SyntheticPcmSource final : public FramedSource
+{
+public:
+  static SyntheticPcmSource* createNew(UsageEnvironment& env, const LoopbackServerOptions& options)
+  {
+    return new SyntheticPcmSource(env, options);
+  }
+
+protected:
+  SyntheticPcmSource(UsageEnvironment& env, const LoopbackServerOptions& options)
+      : FramedSource(env)
+      , channelsCount_(options.channelsCount)
+      , frameSamples_(options.frameSamples)
+      , frameDurationUs_(unsigned(std::uint64_t(options.frameSamples) * 1000000 / options.sampleRate))
+      , phaseStep_(2. * M_PI * ToneFrequencyHz / options.sampleRate)
+  {
+  }
+
+  ~SyntheticPcmSource() override { envir().taskScheduler().unscheduleDelayedTask(deliveryTask_); }
+
+  void doGetNextFrame() override
+  {
+    // Delivering from a task keeps the sink from recursing into us.
+    deliveryTask_ = envir().taskScheduler().scheduleDelayedTask(0, SyntheticPcmSource::deliver, this);
+  }
+
+private:
+  static void deliver(void* source)
+  {
+    auto* self = static_cast<SyntheticPcmSource*>(source);
+    self->deliveryTask_ = nullptr;
+    self->deliverFrame();
+  }
+
+  void deliverFrame()
+  {
+    if (!isCurrentlyAwaitingData())
+      return;
+
+    const auto frameBytes = frameSamples_ * channelsCount_ * 2;
+    const auto samplesCount = std::min(frameBytes, fMaxSize) / (channelsCount_ * 2);
+
+    for (unsigned sample = 0; sample < samplesCount; ++sample)
+    {
+      const auto value = static_cast<std::int16_t>(ToneAmplitude * std::sin(phase_));
+      phase_ = std::fmod(phase_ + phaseStep_, 2. * M_PI);
+
+      for (unsigned channel = 0; channel < channelsCount_; ++channel)
+      {
+        *fTo++ = static_cast<unsigned char>(std::uint16_t(value) >> 8);
+        *fTo++ = static_cast<unsigned char>(value & 0xff);
+      }
+    }
+
+    fFrameSize = samplesCount * channelsCount_ * 2;
+    fNumTruncatedBytes = frameBytes - fFrameSize;
+
+    if (nextPresentationTime_.tv_sec == 0 && nextPresentationTime_.tv_usec == 0)
+      gettimeofday(&nextPresentationTime_, nullptr);
+
+    fPresentationTime = nextPresentationTime_;
+    fDurationInMicroseconds = frameDurationUs_;
+
+    nextPresentationTime_.tv_usec += frameDurationUs_;
+    nextPresentationTime_.tv_sec += nextPresentationTime_.tv_usec / 1000000;
+    nextPresentationTime_.tv_usec %= 1000000;
+
+    FramedSource::afterGetting(this);
+  }
+
+private:
+  const unsigned channelsCount_;
+  const unsigned frameSamples_;
+  const unsigned frameDurationUs_;
+  const double phaseStep_;
+
+  double phase_ = 0.;
+  timeval nextPresentationTime_ = {};
+  TaskToken deliveryTask_ = nullptr;
+};
+
+class L16ServerMediaSubsession final : public OnDemandServerMediaSubsession
+{
+public:
+  static L16ServerMediaSubsession* createNew(UsageEnvironment& env, const LoopbackServerOptions& options)
+  {
+    return new L16ServerMediaSubsession(env, options);
+  }
+
+protected:
+  L16ServerMediaSubsession(UsageEnvironment& env, const LoopbackServerOptions& options)
+      : OnDemandServerMediaSubsession(env, False)
+      , options_(options)
+  {
+  }
+
+  FramedSource* createNewStreamSource(unsigned, unsigned& estBitrate) override
+  {
+    estBitrate = (options_.sampleRate * options_.channelsCount * 16 + 500) / 1000;
+    return SyntheticPcmSource::createNew(envir(), options_);
+  }
+
+  RTPSink* createNewRTPSink(Groupsock* rtpGroupsock, unsigned char, FramedSource*) override
+  {
+    // One frame per packet, so packetization adds no latency on its own.
+    return SimpleRTPSink::createNew(envir(),
+                                    rtpGroupsock,
+                                    L16PayloadType,
+                                    options_.sampleRate,
+                                    "audio",
+                                    "L16",
+                                    options_.channelsCount,
+                                    False);
+  }
+
+private:
+  const LoopbackServerOptions options_;
+};
+} // namespace
+
+LoopbackServer::LoopbackServer(const LoopbackServerOptions& options)
+    : options_(options)
+{
+  scheduler_ = BasicTaskScheduler::createNew();
+  envir_ = BasicUsageEnvironment::createNew(*scheduler_);
+
+  // The server does not take ownership of the database.
+  authDatabase_ = new UserAuthenticationDatabase;
+  authDatabase_->addUserRecord(AuthUserName, options_.authCode.c_str());
+
+  server_ = RTSPServer::createNew(*envir_, Port(options_.port), authDatabase_);
+  if (!server_)
+  {
+    std::cerr << "Failed to create the RTSP server: " << envir_->getResultMsg() << std::endl;
+    return;
+  }
+
+  // Listeners open "rtsp://<ip>:<port>/", so the session has an empty name.
+  auto* session = ServerMediaSession::createNew(*envir_, "", "MicBridge loopback", "Synthetic L16 tone");
+  session->addSubsession(L16ServerMediaSubsession::createNew(*envir_, options_));
+  server_->addServerMediaSession(session);
+
+  stopEventID_ = scheduler_->createEventTrigger(LoopbackServer::stop);
+
+  runnerThread_ = std::thread(
+      [this]()
+      {
+        scheduler_->doEventLoop(&stopFlag_);
+        Medium::close(server_);
+      });
+}
+
+LoopbackServer::~LoopbackServer()
+{
+  if (runnerThread_.joinable())
+  {
+    scheduler_->triggerEvent(stopEventID_, this);
+    runnerThread_.join();
+    scheduler_->deleteEventTrigger(stopEventID_);
+  }
+
+  delete authDatabase_;
+  envir_->reclaim();
+  delete scheduler_;
+}
+
+std::int64_t LoopbackServer::cpuTimeUs()
+{
+  clockid_t clock = 0;
+  timespec time = {};
+  if (!runnerThread_.joinable() || pthread_getcpuclockid(runnerThread_.native_handle(), &clock) != 0
+      || clock_gettime(clock, &time) != 0)
+  {
+    return 0;
+  }
+
+  return std::int64_t(time.tv_sec) * 1000000 + time.tv_nsec / 1000;
+}
+
+void LoopbackServer::stop(void* server)
+{
+  static_cast<LoopbackServer*>(server)->stopFlag_ = 1;
+}
+} // namespace Broadcast::Benchmark
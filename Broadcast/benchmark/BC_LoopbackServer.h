@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <thread>
+
+class TaskScheduler;
+class UsageEnvironment;
+class RTSPServer;
+class UserAuthenticationDatabase;
+
+namespace Broadcast::Benchmark
+{
+struct LoopbackServerOptions
+{
+  std::uint16_t port = 8554;
+  std::string authCode = "benchmark";
+
+  std::uint32_t sampleRate = 48000;
+  std::uint32_t channelsCount = 1;
+  // Samples per channel carried by each RTP packet.
+  std::uint32_t frameSamples = 240;
+};
+
+// In-process RTSP server streaming a synthetic L16 sine tone on its own
+// live555 scheduler thread. Every client gets its own source, paced in real
+// time by the RTP sink, and is authenticated the same way a phone does it.
+class LoopbackServer final
+{
+public:
+  explicit LoopbackServer(const LoopbackServerOptions& options);
+  ~LoopbackServer();
+
+  bool isRunning() const { return server_ != nullptr; }
+
+  // CPU time consumed by the server thread so far.
+  std::int64_t cpuTimeUs();
+
+private:
+  static void stop(void* server);
+
+private:
+  LoopbackServerOptions options_;
+
+  TaskScheduler* scheduler_ = nullptr;
+  UsageEnvironment* envir_ = nullptr;
+  UserAuthenticationDatabase* authDatabase_ = nullptr;
+  RTSPServer* server_ = nullptr;
+
+  unsigned stopEventID_ = 0;
+  char stopFlag_ = 0;
+
+  std::thread runnerThread_;
+};
+} // namespace Broadcast::Benchmark
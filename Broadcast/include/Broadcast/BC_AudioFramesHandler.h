@@ -1,5 +1,8 @@
 #pragma once
 
+#include "BC_FrameBuffer.h"
+#include "BC_StreamFormat.h"
+
 #include <memory>
 
 namespace Broadcast
@@ -8,7 +11,16 @@ class AudioFramesHandler
 {
  public:
   virtual ~AudioFramesHandler() = default;
+
+  // Called before the first frame of a stream, on the thread frames are
+  // delivered on.
+  virtual void onStreamFormat(const StreamFormat&) {}
+
   virtual void onFrame(const std::uint8_t*, std::size_t len) = 0;
+
+  // Handlers that need the frame after returning override this and keep a
+  // copy of the buffer instead of copying its bytes.
+  virtual void onFrameBuffer(const FrameBuffer& frame) { onFrame(frame.data(), frame.size()); }
 };
 using AudioFramesHandlerPtr = std::shared_ptr<AudioFramesHandler>;
 } // namespace Broadcast
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+namespace Broadcast
+{
+class FrameBufferPool;
+
+// Reference counted read-only view of a received frame. The frame lives in a
+// preallocated slab of a pool; copying a FrameBuffer only bumps the slab's
+// reference count, and the slab goes back to its pool once the last copy is
+// released. Copies may be held and released on any thread.
+class FrameBuffer final
+{
+public:
+  FrameBuffer() = default;
+
+  FrameBuffer(const FrameBuffer& other) noexcept
+      : slab_(other.slab_)
+  {
+    if (slab_)
+      slab_->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  FrameBuffer(FrameBuffer&& other) noexcept
+      : slab_(other.slab_)
+  {
+    other.slab_ = nullptr;
+  }
+
+  FrameBuffer& operator=(const FrameBuffer& other) noexcept
+  {
+    FrameBuffer(other).swap(*this);
+    return *this;
+  }
+
+  FrameBuffer& operator=(FrameBuffer&& other) noexcept
+  {
+    FrameBuffer(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  ~FrameBuffer() { reset(); }
+
+  void reset() noexcept;
+  void swap(FrameBuffer& other) noexcept { std::swap(slab_, other.slab_); }
+
+  explicit operator bool() const { return slab_ != nullptr; }
+
+  const std::uint8_t* data() const { return slab_->data; }
+  std::size_t size() const { return slab_->size; }
+
+  // RTP presentation time of the frame, in microseconds.
+  std::int64_t presentationTimeUs() const { return slab_->presentationTimeUs; }
+
+  // RTP header fields of the packet the frame came in. Frames of one packet
+  // share them; consumers use them to find lost packets.
+  bool hasRtpInfo() const { return slab_->hasRtpInfo; }
+  std::uint16_t rtpSequenceNumber() const { return slab_->rtpSequenceNumber; }
+  std::uint32_t rtpTimestamp() const { return slab_->rtpTimestamp; }
+
+private:
+  friend class FrameBufferPool;
+
+  struct Slab
+  {
+    std::atomic<std::uint32_t> refs = 0;
+    FrameBufferPool* pool = nullptr;
+    Slab* next = nullptr;
+
+    std::uint8_t* data = nullptr;
+    std::size_t capacity = 0;
+    std::size_t size = 0;
+    std::int64_t presentationTimeUs = 0;
+
+    bool hasRtpInfo = false;
+    std::uint16_t rtpSequenceNumber = 0;
+    std::uint32_t rtpTimestamp = 0;
+  };
+
+  explicit FrameBuffer(Slab* slab) noexcept
+      : slab_(slab)
+  {
+  }
+
+  Slab* slab_ = nullptr;
+};
+} // namespace Broadcast
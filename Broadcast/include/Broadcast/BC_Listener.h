@@ -3,6 +3,8 @@
 #include "BC_AudioFramesHandler.h"
 #include "BC_DispatchQueue.h"
 #include "BC_ErrorHandler.h"
+#include "BC_ListenerOptions.h"
+#include "BC_ListenerStats.h"
 #include "BC_SuccessHandler.h"
 
 #include <string>
@@ -21,10 +23,14 @@ class Listener final
            AudioFramesHandlerPtr framesHandler,
            DispatchQueuePtr dispatchQueue,
            SuccessHandlerPtr successHandler,
-           ErrorHandlerPtr errorHandler);
+           ErrorHandlerPtr errorHandler,
+           const ListenerOptions& options = {});
 
   ~Listener();
 
+  // Safe to call from any thread, never blocks the network thread.
+  ListenerStats getStats() const;
+
  private:
   std::shared_ptr<ListenerImpl> impl_;
 };
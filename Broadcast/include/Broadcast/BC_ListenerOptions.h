@@ -0,0 +1,112 @@
+#pragma once
+
+#include "BC_StreamFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Broadcast
+{
+enum class FramesDelivery
+{
+  // Frames handler is invoked directly on the live555 event loop thread.
+  Synchronous = 0,
+  // Frames are passed through a preallocated lock-free ring and handed to
+  // the frames handler from a dedicated consumer thread.
+  Queued
+};
+
+enum class RtpTransport
+{
+  Udp = 0,
+  // RTP and RTCP interleaved into the RTSP TCP connection.
+  Tcp,
+  // Starts with UDP and switches to TCP for good when no RTP arrives within
+  // udpFallbackTimeoutMs after PLAY.
+  Auto
+};
+
+struct JitterBufferOptions
+{
+  bool enabled = false;
+
+  // Playout delay is kept at jitterMultiplier times the measured
+  // inter-arrival jitter, within [minDelayMs, maxDelayMs].
+  std::uint32_t minDelayMs = 10;
+  std::uint32_t maxDelayMs = 200;
+  float jitterMultiplier = 3.f;
+
+  // Frames waiting for their playout time; the oldest one is played early
+  // when the buffer is full.
+  std::size_t maxFrames = 64;
+};
+
+struct ReconnectOptions
+{
+  // Re-establishes a session lost after it had been streaming (RTCP BYE,
+  // failed request or no RTP for inactivityTimeoutMs) instead of reporting
+  // an error. Reconnects reuse the cached session description and
+  // credentials and go straight to SETUP and PLAY.
+  bool enabled = false;
+
+  std::uint32_t inactivityTimeoutMs = 1000;
+
+  // The first retry waits initialDelayMs, every further one backoffMultiplier
+  // times longer up to maxDelayMs; each delay is randomized by +/- jitter.
+  std::uint32_t initialDelayMs = 20;
+  std::uint32_t maxDelayMs = 2000;
+  float backoffMultiplier = 2.f;
+  float jitter = 0.25f;
+
+  // Failed attempts in a row before the error is reported; zero retries
+  // until the listener is destroyed.
+  std::uint32_t maxAttempts = 0;
+};
+
+struct ListenerOptions
+{
+  // Every stream receives straight into a fixed pool of frame buffers that
+  // are handed to the frames handler without copying. A frame is dropped
+  // when all buffers are still held downstream.
+  std::size_t frameBuffersCount = 64;
+  // Zero sizes the buffers for the largest frame the session description
+  // allows: the packet time of PCM streams, the largest access unit of
+  // AAC, or an MTU sized payload otherwise. A frame that does not fit is
+  // dropped and the buffers of the stream are regrown, up to
+  // maxFrameBufferSize.
+  std::size_t frameBufferSize = 0;
+  std::size_t maxFrameBufferSize = 1024 * 64;
+  // Largest IP packet on the path, which bounds RTP payloads over UDP.
+  std::size_t mtu = 1500;
+
+  FramesDelivery framesDelivery = FramesDelivery::Synchronous;
+
+  // Applies to "L16" streams only. Float conversion halves the largest
+  // frame that fits into a buffer.
+  PcmConversion pcmConversion = PcmConversion::None;
+
+  // Queued delivery only: number of frames the ring holds. Frames arriving
+  // while it is full are dropped. Frames passed as raw bytes rather than
+  // frame buffers are copied into slots of queueSlotSize.
+  std::size_t queueSlotsCount = 64;
+  std::size_t queueSlotSize = 1024 * 4;
+
+  // Reorders and paces frames by their RTP presentation time before they
+  // reach the frames handler.
+  JitterBufferOptions jitterBuffer;
+
+  RtpTransport transport = RtpTransport::Auto;
+  std::uint32_t udpFallbackTimeoutMs = 1500;
+
+  ReconnectOptions reconnect;
+
+  // Sends the SETUPs of all subsessions but the first one and PLAY back to
+  // back instead of waiting for each response, saving a round trip per
+  // extra subsession. The server has to accept pipelined requests.
+  bool pipelinedSetup = false;
+
+  // How often RTP statistics are sampled and the round trip time probed.
+  // Zero disables both.
+  std::uint32_t statsIntervalMs = 1000;
+};
+} // namespace Broadcast
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Broadcast
+{
+struct ReceiveStats
+{
+  // Frames dropped because every frame buffer was still held downstream.
+  std::uint64_t framesDroppedNoBuffer = 0;
+  // Frames dropped because they did not fit into a frame buffer, and the
+  // times the buffers of a stream were regrown after one.
+  std::uint64_t framesTruncated = 0;
+  std::uint64_t bufferResizes = 0;
+  // Size of the frame buffers of the last stream set up or regrown.
+  std::uint32_t frameBufferSize = 0;
+};
+
+struct JitterBufferStats
+{
+  // Times the playout clock reached the next expected frame before it arrived.
+  std::uint64_t underruns = 0;
+  // Frames that arrived after their playout slot had already been passed.
+  std::uint64_t lateDrops = 0;
+  // Frames currently held by the buffer.
+  std::uint32_t depthFrames = 0;
+  // Current playout delay and the measured inter-arrival jitter it follows.
+  std::uint32_t targetDelayUs = 0;
+  std::uint32_t jitterUs = 0;
+};
+
+// Sampled from live555's RTP reception statistics every statsIntervalMs,
+// summed over the stream's sources.
+struct RtpStats
+{
+  std::uint64_t packetsReceived = 0;
+  // Sequence numbers never received.
+  std::uint64_t packetsLost = 0;
+  // Packets that arrived after a later one had already been played out and
+  // were discarded, duplicates included. Packets reordered within the RTP
+  // source's reordering window are not counted.
+  std::uint64_t outOfOrderPackets = 0;
+  // Bytes cut off frames that did not fit into a frame buffer.
+  std::uint64_t truncatedBytes = 0;
+  // RFC 3550 inter-arrival jitter.
+  std::uint32_t jitterUs = 0;
+  // Round trip of an RTSP OPTIONS request on the session's connection; the
+  // sender does not send the RTCP receiver reports RTT is usually taken from.
+  std::uint32_t rttUs = 0;
+  // Payload bitrate over the last sampling interval.
+  std::uint32_t bitrateKbps = 0;
+};
+
+struct ConnectionStats
+{
+  // Sessions re-established after being lost, and every attempt made to.
+  std::uint64_t reconnects = 0;
+  std::uint64_t reconnectAttempts = 0;
+  // From detecting the loss to the first frame of the new session.
+  std::uint32_t lastReconnectLatencyUs = 0;
+  // Time the event loop took to close the last session, sending TEARDOWN
+  // included; zero until one was closed.
+  std::uint32_t lastTeardownUs = 0;
+
+  // Time from opening the last (re)connection to the end of each phase of
+  // the handshake: DESCRIBE response (zero when the cached description was
+  // used), last SETUP response, PLAY response and first received frame.
+  // Phases not reached yet are zero.
+  std::uint32_t describeUs = 0;
+  std::uint32_t setupUs = 0;
+  std::uint32_t playUs = 0;
+  std::uint32_t firstFrameUs = 0;
+
+  // Transport the current session streams over, and how often UDP was
+  // given up for TCP.
+  bool streamingOverTcp = false;
+  std::uint64_t udpFallbacks = 0;
+
+  // Smoothed one-way transit of frames, from the sender's presentation
+  // time to their arrival. Only measured once the sender's clock is known
+  // through RTCP, and includes the offset between the two clocks.
+  std::uint32_t transitUs = 0;
+};
+
+struct ListenerStats
+{
+  ReceiveStats receive;
+  JitterBufferStats jitterBuffer;
+  RtpStats rtp;
+  ConnectionStats connection;
+};
+} // namespace Broadcast
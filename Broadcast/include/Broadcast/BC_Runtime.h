@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Broadcast
+{
+struct RuntimeOptions
+{
+  // Number of live555 event loop threads listeners are spread across. Each
+  // listener stays on the loop it was assigned to for its whole lifetime.
+  std::size_t eventLoopsCount = 1;
+};
+
+// Valid only before the first Listener is created, which starts the event
+// loops with the options in effect at that moment. Later calls change nothing
+// and return false. Safe to call from any thread.
+bool configureRuntime(const RuntimeOptions& options);
+} // namespace Broadcast
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Broadcast
+{
+// Conversion of uncompressed "L16" frames, done as they are received.
+enum class PcmConversion
+{
+  // Frames are delivered as they come in; MicBridge phones send host order
+  // (little endian) samples.
+  None = 0,
+  // RFC 3551 network order (big endian) samples to host order int16.
+  NetworkToHostS16,
+  // Network order samples to host order float32 in [-1, 1); frames double
+  // in size.
+  NetworkToHostFloat
+};
+
+// Media description of a received subsession, as announced in its SDP.
+struct StreamFormat
+{
+  // RTP payload format name, e.g. "L16" or "MPEG4-GENERIC".
+  std::string codecName;
+  std::uint32_t sampleRate = 0;
+  std::uint32_t channelsCount = 0;
+  // Decoder specific configuration ("config" fmtp parameter), e.g. the AAC
+  // AudioSpecificConfig. Empty when the stream does not carry one.
+  std::vector<std::uint8_t> codecConfig;
+
+  // Conversion applied to the frames of the stream before delivery.
+  PcmConversion pcmConversion = PcmConversion::None;
+};
+} // namespace Broadcast
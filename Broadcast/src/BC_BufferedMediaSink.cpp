@@ -1,25 +1,52 @@
 #include "BC_BufferedMediaSink.h"
 
-#include <uLawAudioFilter.hh>
+#include "BC_PcmConversion.h"
 
+#include <algorithm>
 #include <chrono>
 #include <ctime>
-#include <iostream>
+#include <utility>
 
 namespace Broadcast
 {
 
 BufferedMediaSink* BufferedMediaSink::createNew(UsageEnvironment& env,
                                                 MediaSubsession& subsession,
+                                                FrameBufferPool::Ptr framesPool,
+                                                ListenerCountersPtr counters,
+                                                PcmConversion conversion,
+                                                std::size_t maxBufferSize,
                                                 char const* streamId)
 {
-  return new BufferedMediaSink(env, subsession, streamId);
+  return new BufferedMediaSink(env,
+                               subsession,
+                               std::move(framesPool),
+                               std::move(counters),
+                               conversion,
+                               maxBufferSize,
+                               streamId);
 }
 
-BufferedMediaSink::BufferedMediaSink(UsageEnvironment& env, MediaSubsession&, char const* streamID)
+BufferedMediaSink::BufferedMediaSink(UsageEnvironment& env,
+                                     MediaSubsession& subsession,
+                                     FrameBufferPool::Ptr framesPool,
+                                     ListenerCountersPtr counters,
+                                     PcmConversion conversion,
+                                     std::size_t maxBufferSize,
+                                     char const* streamID)
     : MediaSink(env)
     , streamID_(streamID)
+    , rtpSource_(subsession.rtpSource())
+    , conversion_(conversion)
+    , framesPool_(std::move(framesPool))
+    , maxBufferSize_(std::max(maxBufferSize, framesPool_->slabSize()))
+    , droppedFrameBuffer_(framesPool_->slabSize())
+    , counters_(std::move(counters))
 {
+  if (conversion_ == PcmConversion::NetworkToHostFloat)
+    conversionBuffer_.resize(maxFrameSize());
+
+  counters_->receive.frameBufferSize.store(std::uint32_t(framesPool_->slabSize()), std::memory_order_relaxed);
 }
 
 void BufferedMediaSink::setFramesHandler(std::weak_ptr<AudioFramesHandler> handler)
@@ -27,6 +54,16 @@ void BufferedMediaSink::setFramesHandler(std::weak_ptr<AudioFramesHandler> handl
   framesHandler_ = handler;
 }
 
+void BufferedMediaSink::setJitterBuffer(std::unique_ptr<JitterBuffer> jitterBuffer)
+{
+  jitterBuffer_ = std::move(jitterBuffer);
+}
+
+void BufferedMediaSink::setFirstFrameHandler(std::function<void()> handler)
+{
+  firstFrameHandler_ = std::move(handler);
+}
+
 void BufferedMediaSink::afterGettingFrame(void* clientData,
                                           std::uint32_t frameSize,
                                           std::uint32_t numTruncatedBytes,
@@ -37,65 +74,147 @@ void BufferedMediaSink::afterGettingFrame(void* clientData,
   self->afterGettingFrame(frameSize, numTruncatedBytes, presentationTime, durationInMicroseconds);
 }
 
-namespace
-{
-void normalizeFrame(std::uint8_t* data, std::size_t length)
-{
-  unsigned numValues = length / 2;
-  u_int16_t* value = (u_int16_t*)data;
-  for (unsigned i = 0; i < numValues; ++i) {
-    u_int16_t const orig = value[i];
-    value[i] = ((orig & 0xFF) << 8) | ((orig & 0xFF00) >> 8);
-  }
-}
-} // namespace
-
 void BufferedMediaSink::afterGettingFrame(unsigned frameSize,
                                           unsigned numTruncatedBytes,
-                                          struct timeval /*presentationTime*/,
+                                          struct timeval presentationTime,
                                           unsigned /*durationInMicroseconds*/)
 {
     if (isExprired_)
         return;
 
-    if (numTruncatedBytes != 0)
-        std::cout << numTruncatedBytes << std::endl << std::flush;
+  // Frames of one packet share its sequence number.
+  if (rtpSource_ && (!hasSeqNum_ || rtpSource_->curPacketRTPSeqNum() != lastSeqNum_))
+  {
+    hasSeqNum_ = true;
+    lastSeqNum_ = rtpSource_->curPacketRTPSeqNum();
+    ++packetsDelivered_;
+  }
+
+  if (firstFrameHandler_)
+    std::exchange(firstFrameHandler_, nullptr)();
 
-  // Normalize audio frame after transmission
-//  normalizeFrame(recieveBuffer_.data(), frameSize);
+  const auto presentationTimeUs = std::int64_t(presentationTime.tv_sec) * 1000000 + presentationTime.tv_usec;
+  if (rtpSource_ && rtpSource_->hasBeenSynchronizedUsingRTCP())
+    updateTransit(presentationTimeUs);
 
-  // Notify client
-  if (auto handler = framesHandler_.lock())
+  // A cut off frame would only decode to noise, it is dropped and left to
+  // loss concealment; the next ones get buffers they fit into.
+  if (numTruncatedBytes != 0)
   {
-    handler->onFrame(recieveBuffer_.data(), frameSize);
+    counters_->rtp.truncatedBytes.fetch_add(numTruncatedBytes, std::memory_order_relaxed);
+    counters_->receive.framesTruncated.fetch_add(1, std::memory_order_relaxed);
+
+    recieveBuffer_.reset();
+    growBuffers(std::size_t(frameSize) + numTruncatedBytes);
+    continuePlaying();
+    return;
   }
 
+  if (!recieveBuffer_)
+  {
+    counters_->receive.framesDroppedNoBuffer.fetch_add(1, std::memory_order_relaxed);
+    continuePlaying();
+    return;
+  }
+
+  FrameBufferPool::commit(recieveBuffer_, convertFrame(frameSize), presentationTimeUs);
+  if (rtpSource_)
+    FrameBufferPool::setRtpInfo(recieveBuffer_, rtpSource_->curPacketRTPSeqNum(), rtpSource_->curPacketRTPTimestamp());
+
+  // Notify client, either through the jitter buffer or right away
+  if (jitterBuffer_)
+  {
+    jitterBuffer_->push(std::move(recieveBuffer_));
+  }
+  else if (auto handler = framesHandler_.lock())
+  {
+    handler->onFrameBuffer(recieveBuffer_);
+  }
+  recieveBuffer_.reset();
+
   // Then continue, to request the next frame of data:
   continuePlaying();
 }
 
+std::size_t BufferedMediaSink::convertFrame(std::size_t frameSize)
+{
+  const auto samplesCount = frameSize / sizeof(std::int16_t);
+  auto* frame = FrameBufferPool::writableData(recieveBuffer_);
+
+  switch (conversion_)
+  {
+    case PcmConversion::None:
+      return frameSize;
+    case PcmConversion::NetworkToHostS16:
+      pcmConversionKernels().toS16(frame, samplesCount, reinterpret_cast<std::int16_t*>(frame));
+      return samplesCount * sizeof(std::int16_t);
+    case PcmConversion::NetworkToHostFloat:
+      pcmConversionKernels().toFloat(conversionBuffer_.data(), samplesCount, reinterpret_cast<float*>(frame));
+      return samplesCount * sizeof(float);
+  }
+
+  return frameSize;
+}
+
+std::size_t BufferedMediaSink::maxFrameSize() const
+{
+  const auto slabSize = framesPool_->slabSize();
+  return conversion_ == PcmConversion::NetworkToHostFloat ? slabSize / 2 : slabSize;
+}
+
+void BufferedMediaSink::growBuffers(std::size_t frameSize)
+{
+  // Float frames take twice the room they are received in.
+  const std::size_t factor = conversion_ == PcmConversion::NetworkToHostFloat ? 2 : 1;
+  const auto currentSize = framesPool_->slabSize();
+  if (currentSize >= maxBufferSize_)
+    return;
+
+  // Frames of compressed streams vary in size, leave room for the next
+  // larger one rather than regrowing for each.
+  const auto size = std::min(std::max(frameSize * factor, currentSize * 2), maxBufferSize_);
+
+  framesPool_ = FrameBufferPool::create(framesPool_->slabsCount(), size);
+  droppedFrameBuffer_.resize(framesPool_->slabSize());
+  if (conversion_ == PcmConversion::NetworkToHostFloat)
+    conversionBuffer_.resize(maxFrameSize());
+
+  counters_->receive.bufferResizes.fetch_add(1, std::memory_order_relaxed);
+  counters_->receive.frameBufferSize.store(std::uint32_t(size), std::memory_order_relaxed);
+}
+
+void BufferedMediaSink::updateTransit(std::int64_t presentationTimeUs)
+{
+  using namespace std::chrono;
+  const auto nowUs = duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+  const auto transitUs = double(std::max<std::int64_t>(nowUs - presentationTimeUs, 0));
+
+  // Same smoothing as the RFC 3550 jitter estimate.
+  transitUs_ = hasTransit_ ? transitUs_ + (transitUs - transitUs_) / 16. : transitUs;
+  hasTransit_ = true;
+
+  counters_->connection.transitUs.store(std::uint32_t(std::min(transitUs_, double(UINT32_MAX))),
+                                        std::memory_order_relaxed);
+}
+
 Boolean BufferedMediaSink::continuePlaying()
 {
   if (fSource == NULL)
     return False; // sanity check (should not happen)
 
-  if (!swapEndianFilter_)
+  recieveBuffer_ = framesPool_->acquire();
+
+  auto* receiveTo = droppedFrameBuffer_.data();
+  if (recieveBuffer_)
   {
-      swapEndianFilter_ = EndianSwap16::createNew(this->envir(), fSource);
-
-      if (swapEndianFilter_ == NULL)
-      {
-          envir() << "Unable to create a little->bit-endian order filter from the "
-                     "PCM audio source: "
-                  << envir().getResultMsg() << "\n";
-          return False;
-      }
+    receiveTo = conversion_ == PcmConversion::NetworkToHostFloat ? conversionBuffer_.data()
+                                                                 : FrameBufferPool::writableData(recieveBuffer_);
   }
 
   // Request the next frame of data from our input source.
   // "afterGettingFrame()" will get called later, when it arrives:
-  fSource->getNextFrame(recieveBuffer_.data(),
-                        recieveBuffer_.size(),
+  fSource->getNextFrame(receiveTo,
+                        maxFrameSize(),
                         afterGettingFrame,
                         this,
                         onSourceClosure,
@@ -2,27 +2,52 @@
 
 #include "Broadcast/BC_AudioFramesHandler.h"
 
+#include "BC_FrameBufferPool.h"
+#include "BC_JitterBuffer.h"
+#include "BC_ListenerCounters.h"
+
 #include <MediaSink.hh>
 #include <MediaSession.hh>
 
-#include <array>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace Broadcast
 {
 class BufferedMediaSink : public MediaSink
 {
 public:
-  static BufferedMediaSink* createNew(UsageEnvironment& env, MediaSubsession& subsession, char const* streamID = NULL);
+  static BufferedMediaSink* createNew(UsageEnvironment& env,
+                                      MediaSubsession& subsession,
+                                      FrameBufferPool::Ptr framesPool,
+                                      ListenerCountersPtr counters,
+                                      PcmConversion conversion,
+                                      std::size_t maxBufferSize,
+                                      char const* streamID = NULL);
 
   void setFramesHandler(std::weak_ptr<AudioFramesHandler> framesHandler);
+  void setJitterBuffer(std::unique_ptr<JitterBuffer> jitterBuffer);
+
+  // Called on the event loop when the first frame of the stream arrives.
+  void setFirstFrameHandler(std::function<void()> handler);
 
   void setExpired() { isExprired_ = true; }
 
+  // RTP packets the source handed over, whether or not their frames fit
+  // into a buffer.
+  std::uint64_t packetsDelivered() const { return packetsDelivered_; }
+
 private:
-  BufferedMediaSink(UsageEnvironment& env, MediaSubsession& subsession, char const* streamID);
+  BufferedMediaSink(UsageEnvironment& env,
+                    MediaSubsession& subsession,
+                    FrameBufferPool::Ptr framesPool,
+                    ListenerCountersPtr counters,
+                    PcmConversion conversion,
+                    std::size_t maxBufferSize,
+                    char const* streamID);
 
   virtual ~BufferedMediaSink() = default;
 
@@ -39,15 +64,52 @@ private:
                                 timeval presentationTime,
                                 std::uint32_t durationInMicroseconds);
 
+  void updateTransit(std::int64_t presentationTimeUs);
+
+  // Converts the received frame into the receive buffer, returns its size.
+  std::size_t convertFrame(std::size_t frameSize);
+
+  // Largest frame that fits into a buffer once converted.
+  std::size_t maxFrameSize() const;
+
+  // Replaces the pool with one whose buffers fit a frame of the given
+  // received size, when the size limit allows for it.
+  void growBuffers(std::size_t frameSize);
+
 private:
     bool isExprired_ = false;
 
   std::string streamID_;
 
-  FramedFilter* swapEndianFilter_ = nullptr;
+  RTPSource* rtpSource_ = nullptr;
+  bool hasSeqNum_ = false;
+  std::uint16_t lastSeqNum_ = 0;
+  std::uint64_t packetsDelivered_ = 0;
+
+  std::function<void()> firstFrameHandler_;
+
+  bool hasTransit_ = false;
+  double transitUs_ = 0.;
+
+  // Float frames are twice the size of what came in, they are received
+  // into conversionBuffer_ and converted into the pool buffer; int16 ones
+  // are converted in place.
+  const PcmConversion conversion_;
+  std::vector<std::uint8_t> conversionBuffer_;
+
+  // Frames are received straight into a buffer of the pool, which is then
+  // handed downstream as is. When the whole pool is held downstream the
+  // frame lands in droppedFrameBuffer_ and is discarded. A regrown pool
+  // replaces this one; buffers still held downstream keep the old one
+  // alive until they are released.
+  FrameBufferPool::Ptr framesPool_;
+  const std::size_t maxBufferSize_;
+  FrameBuffer recieveBuffer_;
+  std::vector<u_int8_t> droppedFrameBuffer_;
 
-  std::array<u_int8_t, 1024 * 64> recieveBuffer_;
+  ListenerCountersPtr counters_;
 
   std::weak_ptr<AudioFramesHandler> framesHandler_;
+  std::unique_ptr<JitterBuffer> jitterBuffer_;
 };
 } // namespace Broadcast
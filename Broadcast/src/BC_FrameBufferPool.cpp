@@ -0,0 +1,89 @@
+#include "BC_FrameBufferPool.h"
+
+#include <algorithm>
+
+namespace Broadcast
+{
+
+void FrameBuffer::reset() noexcept
+{
+  if (slab_ && slab_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    slab_->pool->recycle(slab_);
+  }
+
+  slab_ = nullptr;
+}
+
+FrameBufferPool::Ptr FrameBufferPool::create(std::size_t slabsCount, std::size_t slabSize)
+{
+  return Ptr(new FrameBufferPool(slabsCount, slabSize), [](FrameBufferPool* pool) { pool->release(); });
+}
+
+FrameBufferPool::FrameBufferPool(std::size_t slabsCount, std::size_t slabSize)
+    : slabsCount_(std::max<std::size_t>(slabsCount, 1))
+    , slabSize_(slabSize)
+{
+  const auto stride = (slabSize_ + SlabAlignment - 1) / SlabAlignment * SlabAlignment;
+
+  slabs_ = std::make_unique<FrameBuffer::Slab[]>(slabsCount_);
+  storage_.resize(slabsCount_ * stride + SlabAlignment);
+
+  auto* base = storage_.data();
+  base += (SlabAlignment - reinterpret_cast<std::uintptr_t>(base) % SlabAlignment) % SlabAlignment;
+
+  FrameBuffer::Slab* head = nullptr;
+  for (auto index = slabsCount_; index > 0; --index)
+  {
+    auto& slab = slabs_[index - 1];
+    slab.pool = this;
+    slab.data = base + (index - 1) * stride;
+    slab.capacity = slabSize_;
+    slab.next = head;
+    head = &slab;
+  }
+
+  freeList_ = head;
+}
+
+FrameBuffer FrameBufferPool::acquire()
+{
+  // Only this thread pops, so the head cannot be popped and pushed back
+  // behind our back (no ABA), while other threads may still push.
+  auto* head = freeList_.load(std::memory_order_acquire);
+  while (head && !freeList_.compare_exchange_weak(head, head->next, std::memory_order_acquire))
+  {
+  }
+
+  if (!head)
+    return {};
+
+  head->refs.store(1, std::memory_order_relaxed);
+  head->size = 0;
+  head->presentationTimeUs = 0;
+  head->hasRtpInfo = false;
+
+  refs_.fetch_add(1, std::memory_order_relaxed);
+  return FrameBuffer(head);
+}
+
+void FrameBufferPool::recycle(FrameBuffer::Slab* slab)
+{
+  auto* head = freeList_.load(std::memory_order_relaxed);
+  do
+  {
+    slab->next = head;
+  } while (!freeList_.compare_exchange_weak(head, slab, std::memory_order_release, std::memory_order_relaxed));
+
+  release();
+}
+
+void FrameBufferPool::release()
+{
+  if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    delete this;
+  }
+}
+
+} // namespace Broadcast
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Broadcast/BC_FrameBuffer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Broadcast
+{
+// Fixed set of equally sized slabs backing FrameBuffers. Slabs are acquired
+// by a single thread (the one filling them, e.g. the live555 event loop) and
+// returned from any thread through a lock-free free list. The pool memory
+// stays alive until both the owner and every outstanding FrameBuffer are
+// gone.
+class FrameBufferPool final
+{
+public:
+  using Ptr = std::shared_ptr<FrameBufferPool>;
+
+  static Ptr create(std::size_t slabsCount, std::size_t slabSize);
+
+  // Producer thread only. Returns an empty buffer when every slab is in use.
+  FrameBuffer acquire();
+
+  std::size_t slabsCount() const { return slabsCount_; }
+  std::size_t slabSize() const { return slabSize_; }
+
+  // Writers may only touch a buffer they have just acquired and not shared.
+  static std::uint8_t* writableData(FrameBuffer& buffer) { return buffer.slab_->data; }
+  static void commit(FrameBuffer& buffer, std::size_t size, std::int64_t presentationTimeUs)
+  {
+    buffer.slab_->size = size;
+    buffer.slab_->presentationTimeUs = presentationTimeUs;
+  }
+  static void setRtpInfo(FrameBuffer& buffer, std::uint16_t sequenceNumber, std::uint32_t timestamp)
+  {
+    buffer.slab_->hasRtpInfo = true;
+    buffer.slab_->rtpSequenceNumber = sequenceNumber;
+    buffer.slab_->rtpTimestamp = timestamp;
+  }
+
+private:
+  friend class FrameBuffer;
+
+  FrameBufferPool(std::size_t slabsCount, std::size_t slabSize);
+  ~FrameBufferPool() = default;
+
+  void recycle(FrameBuffer::Slab* slab);
+  void release();
+
+private:
+  static constexpr std::size_t SlabAlignment = 64;
+
+  const std::size_t slabsCount_;
+  const std::size_t slabSize_;
+
+  std::unique_ptr<FrameBuffer::Slab[]> slabs_;
+  std::vector<std::uint8_t> storage_;
+
+  std::atomic<FrameBuffer::Slab*> freeList_ = nullptr;
+
+  // One reference for the owner plus one per outstanding FrameBuffer.
+  std::atomic<std::size_t> refs_ = 1;
+};
+} // namespace Broadcast
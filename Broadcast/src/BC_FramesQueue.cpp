@@ -0,0 +1,123 @@
+#include "BC_FramesQueue.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Broadcast
+{
+
+FramesQueue::FramesQueue(AudioFramesHandlerPtr clientHandler, std::size_t slotsCount, std::size_t rawFrameSize)
+    : clientHandler_(std::move(clientHandler))
+{
+  slotsCount = std::clamp<std::size_t>(slotsCount, 1, MaxSlotsCount);
+
+  rawFramesPool_ = FrameBufferPool::create(slotsCount, rawFrameSize);
+  slots_.resize(slotsCount);
+
+  for (std::uint32_t slot = 0; slot < slotsCount; ++slot)
+  {
+    freeSlots_.insert(slot);
+  }
+
+  consumerThread_ = std::thread([this]() { consumerLoop(); });
+}
+
+FramesQueue::~FramesQueue()
+{
+  stopped_ = true;
+  publishedCount_.fetch_add(1, std::memory_order_release);
+  publishedCount_.notify_one();
+
+  consumerThread_.join();
+}
+
+void FramesQueue::onStreamFormat(const StreamFormat& format)
+{
+  {
+    const std::lock_guard<std::mutex> lock(formatGuard_);
+    pendingFormat_ = format;
+  }
+  formatChanged_.store(true, std::memory_order_release);
+
+  publishedCount_.fetch_add(1, std::memory_order_release);
+  publishedCount_.notify_one();
+}
+
+void FramesQueue::onFrame(const std::uint8_t* data, std::size_t len)
+{
+  auto frame = len <= rawFramesPool_->slabSize() ? rawFramesPool_->acquire() : FrameBuffer();
+  if (!frame)
+  {
+    droppedFrames_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  std::memcpy(FrameBufferPool::writableData(frame), data, len);
+  FrameBufferPool::commit(frame, len, 0);
+
+  publish(std::move(frame));
+}
+
+void FramesQueue::onFrameBuffer(const FrameBuffer& frame)
+{
+  publish(frame);
+}
+
+void FramesQueue::publish(FrameBuffer frame)
+{
+  std::uint32_t slot = 0;
+  if (!freeSlots_.remove(slot))
+  {
+    droppedFrames_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  slots_[slot] = std::move(frame);
+  readySlots_.insert(slot);
+
+  publishedCount_.fetch_add(1, std::memory_order_release);
+  publishedCount_.notify_one();
+}
+
+void FramesQueue::consumerLoop()
+{
+  while (true)
+  {
+    const auto published = publishedCount_.load(std::memory_order_acquire);
+
+    deliverStreamFormat();
+
+    std::uint32_t slot = 0;
+    while (readySlots_.remove(slot))
+    {
+      deliverStreamFormat();
+
+      clientHandler_->onFrameBuffer(slots_[slot]);
+      slots_[slot].reset();
+      freeSlots_.insert(slot);
+    }
+
+    if (stopped_)
+      break;
+
+    // Sleeps until the producer publishes anything after the snapshot above.
+    publishedCount_.wait(published, std::memory_order_acquire);
+  }
+}
+
+void FramesQueue::deliverStreamFormat()
+{
+  if (!formatChanged_.load(std::memory_order_acquire))
+    return;
+
+  StreamFormat format;
+  {
+    const std::lock_guard<std::mutex> lock(formatGuard_);
+    format = pendingFormat_;
+    formatChanged_.store(false, std::memory_order_relaxed);
+  }
+
+  clientHandler_->onStreamFormat(format);
+}
+
+} // namespace Broadcast
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Broadcast/BC_AudioFramesHandler.h"
+#include "Broadcast/BC_Ringbuffer.h"
+
+#include "BC_FrameBufferPool.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Broadcast
+{
+// Single-producer/single-consumer frames pipeline. The producer (live555
+// event loop) parks a reference to each frame buffer in a free preallocated
+// slot and publishes the slot index; a dedicated thread drains published
+// slots into the client handler and returns them to the free list. Neither
+// side allocates, copies frame data or takes a lock, and the producer never
+// waits for the consumer.
+class FramesQueue final : public AudioFramesHandler
+{
+public:
+  static constexpr std::size_t MaxSlotsCount = 256;
+
+  FramesQueue(AudioFramesHandlerPtr clientHandler, std::size_t slotsCount, std::size_t rawFrameSize);
+  ~FramesQueue();
+
+  void onStreamFormat(const StreamFormat& format) override;
+  void onFrame(const std::uint8_t* data, std::size_t len) override;
+  void onFrameBuffer(const FrameBuffer& frame) override;
+
+  std::uint64_t droppedFrames() const { return droppedFrames_.load(std::memory_order_relaxed); }
+
+private:
+  void publish(FrameBuffer frame);
+  void consumerLoop();
+  void deliverStreamFormat();
+
+private:
+  using SlotsRing = jnk0le::Ringbuffer<std::uint32_t, MaxSlotsCount, false, 64>;
+
+  AudioFramesHandlerPtr clientHandler_;
+
+  // Backs frames that arrive as raw bytes and have to be copied.
+  FrameBufferPool::Ptr rawFramesPool_;
+
+  // Format changes are rare, they take a lock and are picked up by the
+  // consumer before the first frame published after them.
+  std::mutex formatGuard_;
+  StreamFormat pendingFormat_;
+  std::atomic_bool formatChanged_ = false;
+
+  std::vector<FrameBuffer> slots_;
+  SlotsRing freeSlots_;
+  SlotsRing readySlots_;
+
+  std::atomic<std::uint32_t> publishedCount_ = 0;
+  std::atomic_bool stopped_ = false;
+  std::atomic<std::uint64_t> droppedFrames_ = 0;
+
+  std::thread consumerThread_;
+};
+} // namespace Broadcast
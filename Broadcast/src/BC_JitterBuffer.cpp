@@ -0,0 +1,230 @@
+#include "BC_JitterBuffer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace Broadcast
+{
+
+namespace
+{
+// Transit time jumps this large mean a new timeline (e.g. presentation time
+// switching to the sender's clock after the first RTCP SR), not jitter.
+constexpr std::int64_t ResyncThresholdUs = 1000 * 1000;
+
+// Bound on how fast the playout delay follows the jitter estimate, per frame.
+constexpr std::int64_t MaxTargetStepUs = 1000;
+
+// Frames due within the scheduler granularity are released together.
+constexpr std::int64_t PlayoutSlackUs = 1000;
+
+std::int64_t nowUs()
+{
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+} // namespace
+
+JitterBuffer::JitterBuffer(TaskScheduler& scheduler,
+                           std::weak_ptr<AudioFramesHandler> framesHandler,
+                           const JitterBufferOptions& options,
+                           ListenerCountersPtr counters)
+    : scheduler_(scheduler)
+    , framesHandler_(std::move(framesHandler))
+    , counters_(std::move(counters))
+    , minDelayUs_(std::int64_t(options.minDelayMs) * 1000)
+    , maxDelayUs_(std::max<std::int64_t>(options.maxDelayMs, options.minDelayMs) * 1000)
+    , jitterMultiplier_(options.jitterMultiplier)
+    , maxFrames_(std::max<std::size_t>(options.maxFrames, 1))
+    , targetDelayUs_(minDelayUs_)
+{
+  pending_.reserve(maxFrames_);
+
+  counters_->jitterBuffer.targetDelayUs = std::uint32_t(targetDelayUs_);
+}
+
+JitterBuffer::~JitterBuffer()
+{
+  scheduler_.unscheduleDelayedTask(playoutTask_);
+  counters_->jitterBuffer.depthFrames = 0;
+}
+
+void JitterBuffer::push(FrameBuffer frame)
+{
+  const auto presentationTimeUs = frame.presentationTimeUs();
+  const auto transitUs = nowUs() - presentationTimeUs;
+
+  if (!hasTimeline_ || std::abs(transitUs - baseTransitUs_) > ResyncThresholdUs)
+  {
+    // Whatever is pending belongs to the previous timeline, play it out now.
+    releaseAll();
+
+    hasTimeline_ = true;
+    hasReleased_ = false;
+    baseTransitUs_ = transitUs;
+    lastTransitUs_ = transitUs;
+  }
+  else
+  {
+    updateJitter(transitUs);
+  }
+
+  if (hasReleased_ && presentationTimeUs <= lastReleasedUs_)
+  {
+    counters_->jitterBuffer.lateDrops.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  if (pending_.size() == maxFrames_)
+  {
+    // Overflow, play the oldest frame early rather than losing the newest.
+    // That is the incoming one when it sorts before everything pending;
+    // releasing the front first would make it late and play out backwards.
+    if (presentationTimeUs < pending_.front().presentationTimeUs())
+    {
+      release(frame);
+      return;
+    }
+
+    release(pending_.front());
+    pending_.erase(pending_.begin());
+
+    // A duplicate of the frame just released.
+    if (presentationTimeUs == lastReleasedUs_)
+    {
+      counters_->jitterBuffer.lateDrops.fetch_add(1, std::memory_order_relaxed);
+      counters_->jitterBuffer.depthFrames = std::uint32_t(pending_.size());
+      return;
+    }
+  }
+
+  const auto position = std::upper_bound(pending_.begin(),
+                                         pending_.end(),
+                                         presentationTimeUs,
+                                         [](std::int64_t timeUs, const FrameBuffer& pending)
+                                         {
+                                           return timeUs < pending.presentationTimeUs();
+                                         });
+  pending_.insert(position, std::move(frame));
+  counters_->jitterBuffer.depthFrames = std::uint32_t(pending_.size());
+
+  schedulePlayout();
+}
+
+void JitterBuffer::updateJitter(std::int64_t transitUs)
+{
+  // RFC 3550, A.8: J += (|D| - J) / 16
+  const auto delta = std::abs(transitUs - lastTransitUs_);
+  jitterUs_ += (double(delta) - jitterUs_) / 16.;
+  lastTransitUs_ = transitUs;
+
+  // The fastest transit seen so far anchors the timeline. It is slowly pulled
+  // towards recent transits so that a drifting sender clock does not leave
+  // the anchor behind.
+  if (transitUs < baseTransitUs_)
+    baseTransitUs_ = transitUs;
+  else
+    baseTransitUs_ += (transitUs - baseTransitUs_) / 1024;
+
+  const auto desiredUs = std::clamp(std::int64_t(jitterUs_ * jitterMultiplier_), minDelayUs_, maxDelayUs_);
+  targetDelayUs_ += std::clamp(desiredUs - targetDelayUs_, -MaxTargetStepUs, MaxTargetStepUs);
+
+  counters_->jitterBuffer.jitterUs = std::uint32_t(jitterUs_);
+  counters_->jitterBuffer.targetDelayUs = std::uint32_t(targetDelayUs_);
+}
+
+std::int64_t JitterBuffer::deadlineOf(std::int64_t presentationTimeUs) const
+{
+  return presentationTimeUs + baseTransitUs_ + targetDelayUs_;
+}
+
+void JitterBuffer::release(const FrameBuffer& frame)
+{
+  if (auto handler = framesHandler_.lock())
+  {
+    handler->onFrameBuffer(frame);
+  }
+
+  if (hasReleased_)
+  {
+    // Consecutive frames give the frame duration; gaps give a multiple of it.
+    const auto deltaUs = frame.presentationTimeUs() - lastReleasedUs_;
+    if (deltaUs > 0 && (frameDurationUs_ == 0 || deltaUs < frameDurationUs_ * 2))
+      frameDurationUs_ = deltaUs;
+  }
+
+  hasReleased_ = true;
+  underrunReported_ = false;
+  lastReleasedUs_ = frame.presentationTimeUs();
+}
+
+void JitterBuffer::releaseAll()
+{
+  for (const auto& frame : pending_)
+  {
+    release(frame);
+  }
+
+  pending_.clear();
+  counters_->jitterBuffer.depthFrames = 0;
+}
+
+void JitterBuffer::playoutTask(void* clientData)
+{
+  auto* self = static_cast<JitterBuffer*>(clientData);
+  self->playoutTask_ = nullptr;
+  self->playout();
+}
+
+void JitterBuffer::playout()
+{
+  const auto now = nowUs();
+
+  auto due = pending_.begin();
+  while (due != pending_.end() && deadlineOf(due->presentationTimeUs()) <= now + PlayoutSlackUs)
+  {
+    release(*due++);
+  }
+  pending_.erase(pending_.begin(), due);
+  counters_->jitterBuffer.depthFrames = std::uint32_t(pending_.size());
+
+  if (hasReleased_ && frameDurationUs_ != 0 && !underrunReported_)
+  {
+    const auto expectedUs = lastReleasedUs_ + frameDurationUs_;
+    const bool expectedIsMissing =
+        pending_.empty() || pending_.front().presentationTimeUs() > expectedUs + frameDurationUs_ / 2;
+
+    if (expectedIsMissing && deadlineOf(expectedUs) + PlayoutSlackUs <= now)
+    {
+      counters_->jitterBuffer.underruns.fetch_add(1, std::memory_order_relaxed);
+      underrunReported_ = true;
+    }
+  }
+
+  schedulePlayout();
+}
+
+void JitterBuffer::schedulePlayout()
+{
+  scheduler_.unscheduleDelayedTask(playoutTask_);
+
+  std::int64_t wakeUpUs = INT64_MAX;
+  if (!pending_.empty())
+  {
+    wakeUpUs = deadlineOf(pending_.front().presentationTimeUs());
+  }
+
+  if (hasReleased_ && frameDurationUs_ != 0 && !underrunReported_)
+  {
+    wakeUpUs = std::min(wakeUpUs, deadlineOf(lastReleasedUs_ + frameDurationUs_) + PlayoutSlackUs);
+  }
+
+  if (wakeUpUs == INT64_MAX)
+    return;
+
+  const auto delayUs = std::max<std::int64_t>(wakeUpUs - nowUs(), 0);
+  playoutTask_ = scheduler_.scheduleDelayedTask(delayUs, playoutTask, this);
+}
+
+} // namespace Broadcast
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Broadcast/BC_AudioFramesHandler.h"
+#include "Broadcast/BC_ListenerOptions.h"
+
+#include "BC_ListenerCounters.h"
+
+#include <UsageEnvironment.hh>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Broadcast
+{
+// Holds references to incoming frames ordered by presentation time and
+// releases each of them at "presentation time + network transit + playout
+// delay", using the live555 scheduler as a playout clock. The playout delay
+// follows the RFC 3550 inter-arrival jitter estimate. Lives entirely on the
+// event loop.
+class JitterBuffer final
+{
+public:
+  JitterBuffer(TaskScheduler& scheduler,
+               std::weak_ptr<AudioFramesHandler> framesHandler,
+               const JitterBufferOptions& options,
+               ListenerCountersPtr counters);
+  ~JitterBuffer();
+
+  void push(FrameBuffer frame);
+
+private:
+  static void playoutTask(void* clientData);
+  void playout();
+
+  void updateJitter(std::int64_t transitUs);
+  void release(const FrameBuffer& frame);
+  void releaseAll();
+  void schedulePlayout();
+  std::int64_t deadlineOf(std::int64_t presentationTimeUs) const;
+
+private:
+  TaskScheduler& scheduler_;
+  TaskToken playoutTask_ = nullptr;
+
+  std::weak_ptr<AudioFramesHandler> framesHandler_;
+  ListenerCountersPtr counters_;
+
+  const std::int64_t minDelayUs_;
+  const std::int64_t maxDelayUs_;
+  const double jitterMultiplier_;
+
+  const std::size_t maxFrames_;
+  std::vector<FrameBuffer> pending_;
+
+  bool hasTimeline_ = false;
+  std::int64_t baseTransitUs_ = 0;
+  std::int64_t lastTransitUs_ = 0;
+  double jitterUs_ = 0.;
+  std::int64_t targetDelayUs_ = 0;
+
+  bool hasReleased_ = false;
+  bool underrunReported_ = false;
+  std::int64_t lastReleasedUs_ = 0;
+  std::int64_t frameDurationUs_ = 0;
+};
+} // namespace Broadcast
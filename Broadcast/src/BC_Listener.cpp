@@ -1,6 +1,7 @@
 #include "Broadcast/BC_Listener.h"
 
 #include "BC_ListenerImpl.h"
+#include "BC_Live555EventLoop.h"
 #include "BC_Live555Runtime.h"
 
 namespace Broadcast
@@ -12,7 +13,8 @@ Listener::Listener(const std::string& ip,
                    AudioFramesHandlerPtr framesHandler,
                    DispatchQueuePtr dispatchQueue,
                    SuccessHandlerPtr successHandler,
-                   ErrorHandlerPtr errorHandler)
+                   ErrorHandlerPtr errorHandler,
+                   const ListenerOptions& options)
 {
     impl_ = std::make_shared<ListenerImpl>(ip,
                                            port,
@@ -20,7 +22,8 @@ Listener::Listener(const std::string& ip,
                                            std::move(framesHandler),
                                            std::move(dispatchQueue),
                                            std::move(successHandler),
-                                           std::move(errorHandler));
+                                           std::move(errorHandler),
+                                           options);
 
     Live555Runtime::getInstance().initialize(impl_);
 }
@@ -28,6 +31,14 @@ Listener::Listener(const std::string& ip,
 Listener::~Listener()
 {
     impl_->setExpired(true);
+
+    // The session has to be torn down by the event loop that drives it.
+    impl_->eventLoop()->release(std::move(impl_));
+}
+
+ListenerStats Listener::getStats() const
+{
+    return impl_->getStats();
 }
 
 } // namespace Broadcast
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Broadcast/BC_ListenerStats.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Broadcast
+{
+// Counters are written by the live555 event loop and read from any thread
+// through snapshot(); every field is an independent relaxed atomic.
+struct ListenerCounters
+{
+  struct Receive
+  {
+    std::atomic<std::uint64_t> framesDroppedNoBuffer = 0;
+    std::atomic<std::uint64_t> framesTruncated = 0;
+    std::atomic<std::uint64_t> bufferResizes = 0;
+    std::atomic<std::uint32_t> frameBufferSize = 0;
+  } receive;
+
+  struct JitterBuffer
+  {
+    std::atomic<std::uint64_t> underruns = 0;
+    std::atomic<std::uint64_t> lateDrops = 0;
+    std::atomic<std::uint32_t> depthFrames = 0;
+    std::atomic<std::uint32_t> targetDelayUs = 0;
+    std::atomic<std::uint32_t> jitterUs = 0;
+  } jitterBuffer;
+
+  struct Rtp
+  {
+    std::atomic<std::uint64_t> packetsReceived = 0;
+    std::atomic<std::uint64_t> packetsLost = 0;
+    std::atomic<std::uint64_t> outOfOrderPackets = 0;
+    std::atomic<std::uint64_t> truncatedBytes = 0;
+    std::atomic<std::uint32_t> jitterUs = 0;
+    std::atomic<std::uint32_t> rttUs = 0;
+    std::atomic<std::uint32_t> bitrateKbps = 0;
+  } rtp;
+
+  struct Connection
+  {
+    std::atomic<std::uint64_t> reconnects = 0;
+    std::atomic<std::uint64_t> reconnectAttempts = 0;
+    std::atomic<std::uint32_t> lastReconnectLatencyUs = 0;
+    std::atomic<std::uint32_t> lastTeardownUs = 0;
+    std::atomic<std::uint32_t> describeUs = 0;
+    std::atomic<std::uint32_t> setupUs = 0;
+    std::atomic<std::uint32_t> playUs = 0;
+    std::atomic<std::uint32_t> firstFrameUs = 0;
+    std::atomic_bool streamingOverTcp = false;
+    std::atomic<std::uint64_t> udpFallbacks = 0;
+    std::atomic<std::uint32_t> transitUs = 0;
+  } connection;
+
+  ListenerStats snapshot() const
+  {
+    constexpr auto Relaxed = std::memory_order_relaxed;
+
+    ListenerStats stats;
+    stats.receive.framesDroppedNoBuffer = receive.framesDroppedNoBuffer.load(Relaxed);
+    stats.receive.framesTruncated = receive.framesTruncated.load(Relaxed);
+    stats.receive.bufferResizes = receive.bufferResizes.load(Relaxed);
+    stats.receive.frameBufferSize = receive.frameBufferSize.load(Relaxed);
+
+    stats.jitterBuffer.underruns = jitterBuffer.underruns.load(Relaxed);
+    stats.jitterBuffer.lateDrops = jitterBuffer.lateDrops.load(Relaxed);
+    stats.jitterBuffer.depthFrames = jitterBuffer.depthFrames.load(Relaxed);
+    stats.jitterBuffer.targetDelayUs = jitterBuffer.targetDelayUs.load(Relaxed);
+    stats.jitterBuffer.jitterUs = jitterBuffer.jitterUs.load(Relaxed);
+
+    stats.rtp.packetsReceived = rtp.packetsReceived.load(Relaxed);
+    stats.rtp.packetsLost = rtp.packetsLost.load(Relaxed);
+    stats.rtp.outOfOrderPackets = rtp.outOfOrderPackets.load(Relaxed);
+    stats.rtp.truncatedBytes = rtp.truncatedBytes.load(Relaxed);
+    stats.rtp.jitterUs = rtp.jitterUs.load(Relaxed);
+    stats.rtp.rttUs = rtp.rttUs.load(Relaxed);
+    stats.rtp.bitrateKbps = rtp.bitrateKbps.load(Relaxed);
+
+    stats.connection.reconnects = connection.reconnects.load(Relaxed);
+    stats.connection.reconnectAttempts = connection.reconnectAttempts.load(Relaxed);
+    stats.connection.lastReconnectLatencyUs = connection.lastReconnectLatencyUs.load(Relaxed);
+    stats.connection.lastTeardownUs = connection.lastTeardownUs.load(Relaxed);
+    stats.connection.describeUs = connection.describeUs.load(Relaxed);
+    stats.connection.setupUs = connection.setupUs.load(Relaxed);
+    stats.connection.playUs = connection.playUs.load(Relaxed);
+    stats.connection.firstFrameUs = connection.firstFrameUs.load(Relaxed);
+    stats.connection.streamingOverTcp = connection.streamingOverTcp.load(Relaxed);
+    stats.connection.udpFallbacks = connection.udpFallbacks.load(Relaxed);
+    stats.connection.transitUs = connection.transitUs.load(Relaxed);
+
+    return stats;
+  }
+};
+using ListenerCountersPtr = std::shared_ptr<ListenerCounters>;
+} // namespace Broadcast
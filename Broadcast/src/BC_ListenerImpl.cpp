@@ -1,9 +1,17 @@
 #include "BC_ListenerImpl.h"
 
 #include "BC_BufferedMediaSink.h"
+#include "BC_FramesQueue.h"
+#include "BC_Live555EventLoop.h"
+#include "BC_RtpStatsSampler.h"
 
 #include <BasicUsageEnvironment.hh>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <optional>
 #include <vector>
 #include <sstream>
 
@@ -30,6 +38,9 @@ class StreamClientState {
       , session(NULL)
       , subsession(NULL)
       , streamTimerTask(NULL)
+      , statsTask(NULL)
+      , livenessTask(NULL)
+      , transportTask(NULL)
       , duration(0.0)
   {
   }
@@ -44,6 +55,9 @@ class StreamClientState {
       UsageEnvironment& env = session->envir(); // alias
 
       env.taskScheduler().unscheduleDelayedTask(streamTimerTask);
+      env.taskScheduler().unscheduleDelayedTask(statsTask);
+      env.taskScheduler().unscheduleDelayedTask(livenessTask);
+      env.taskScheduler().unscheduleDelayedTask(transportTask);
       Medium::close(session);
     }
   }
@@ -53,19 +67,29 @@ public:
   MediaSession* session;
   MediaSubsession* subsession;
   TaskToken streamTimerTask;
+  TaskToken statsTask;
+  TaskToken livenessTask;
+  TaskToken transportTask;
   double duration;
-};
 
-Authenticator* getClientAuthentificator()
-{
-    static Authenticator authCreds = []()
-    {
-        Authenticator authTor("velvetSweatshop", "wxB2yecE");
-        return authTor;
-    }();
+  // RTP is interleaved into the RTSP connection rather than sent over UDP.
+  bool overTcp = false;
 
-    return &authCreds;
-}
+  // Set up from the cached description of a previous session, without
+  // DESCRIBE.
+  bool fromCachedDescription = false;
+  std::uint64_t lastPacketsDelivered = 0;
+  std::chrono::steady_clock::time_point lastActivity;
+
+  // Subsessions whose SETUP response is still to come, in request order.
+  std::deque<MediaSubsession*> pendingSetups;
+  bool hasSessionId = false;
+  bool playSent = false;
+
+  std::optional<RtpStatsSampler> statsSampler;
+  // Set while an OPTIONS request probing the round trip time is in flight.
+  std::optional<std::chrono::steady_clock::time_point> roundTripStarted;
+};
 
 namespace
 {
@@ -76,6 +100,99 @@ namespace
 
         return urlStream.str();
     }
+
+    StreamFormat makeStreamFormat(MediaSubsession& subsession, PcmConversion pcmConversion)
+    {
+        StreamFormat format;
+        format.codecName = subsession.codecName();
+        format.sampleRate = subsession.rtpTimestampFrequency();
+        format.channelsCount = subsession.numChannels();
+
+        // Only uncompressed samples are converted.
+        format.pcmConversion = format.codecName == "L16" ? pcmConversion : PcmConversion::None;
+
+        unsigned configSize = 0;
+        if (auto* config = parseGeneralConfigStr(subsession.fmtp_config(), configSize))
+        {
+            format.codecConfig.assign(config, config + configSize);
+            delete[] config;
+        }
+
+        return format;
+    }
+
+    // Value of an "a=<name>:<value>" line of the subsession's description,
+    // zero when absent.
+    unsigned sdpAttributeOf(MediaSubsession& subsession, const std::string& name)
+    {
+        const std::string lines = subsession.savedSDPLines() ? subsession.savedSDPLines() : "";
+        const auto prefix = "a=" + name + ":";
+
+        for (std::size_t start = 0; start < lines.size();)
+        {
+            const auto end = std::min(lines.find('\n', start), lines.size());
+            if (lines.compare(start, prefix.size(), prefix) == 0)
+                return unsigned(std::strtoul(lines.c_str() + start + prefix.size(), nullptr, 10));
+            start = end + 1;
+        }
+
+        return 0;
+    }
+
+    // Largest frame the session description allows for, once converted.
+    std::size_t frameBufferSizeOf(MediaSubsession& subsession,
+                                  const StreamFormat& format,
+                                  const ListenerOptions& options)
+    {
+        if (options.frameBufferSize != 0)
+            return options.frameBufferSize;
+
+        // IPv4, UDP and RTP headers.
+        constexpr std::size_t PacketHeadersSize = 20 + 8 + 12;
+        // An AAC access unit holds at most 6144 bits per channel.
+        constexpr std::size_t MaxAacFrameSizePerChannel = 6144 / 8;
+        constexpr std::size_t MinFrameBufferSize = 256;
+
+        const auto channelsCount = std::max<std::size_t>(format.channelsCount, 1);
+        auto size = options.mtu > PacketHeadersSize ? options.mtu - PacketHeadersSize : options.mtu;
+
+        if (format.codecName == "MPEG4-GENERIC")
+        {
+            size = MaxAacFrameSizePerChannel * channelsCount;
+        }
+        else if (format.codecName == "L16")
+        {
+            auto packetTimeMs = sdpAttributeOf(subsession, "maxptime");
+            if (packetTimeMs == 0)
+                packetTimeMs = sdpAttributeOf(subsession, "ptime");
+            if (packetTimeMs != 0)
+                size = std::size_t(format.sampleRate) * channelsCount * sizeof(std::int16_t) * packetTimeMs / 1000;
+
+            if (format.pcmConversion == PcmConversion::NetworkToHostFloat)
+                size *= 2;
+        }
+
+        return std::clamp(size, MinFrameBufferSize, std::max(options.maxFrameBufferSize, MinFrameBufferSize));
+    }
+
+    std::uint64_t packetsDeliveredOf(MediaSession& session)
+    {
+        std::uint64_t packetsDelivered = 0;
+
+        MediaSubsessionIterator iter(session);
+        while (auto* subsession = iter.next())
+        {
+            if (auto* sink = dynamic_cast<BufferedMediaSink*>(subsession->sink))
+                packetsDelivered += sink->packetsDelivered();
+        }
+
+        return packetsDelivered;
+    }
+
+    std::int64_t livenessCheckIntervalUs(const ReconnectOptions& options)
+    {
+        return std::max<std::int64_t>(std::int64_t(options.inactivityTimeoutMs) * 1000 / 4, 10000);
+    }
 } // namespace
 
 class ListenerImpl::StandaloneRTSPClient : public RTSPClient
@@ -111,6 +228,12 @@ protected:
   virtual ~StandaloneRTSPClient() = default;
 
 public:
+  // Carries the realm and nonce of the last challenge, so requests sent
+  // with a copy of it are authorized without another round trip.
+  const Authenticator& currentAuthenticator() const { return fCurrentAuthenticator; }
+
+  using RTSPClient::setBaseURL;
+
   StreamClientState scs;
 
   std::string destIp;
@@ -133,15 +256,22 @@ public:
    {
    }
 
+  void onStreamFormat(const StreamFormat& format) override
+  {
+    clientFramesHandler_->onStreamFormat(format);
+  }
+
   void onFrame(const std::uint8_t* data, std::size_t len) override
   {
-//    std::vector<std::uint8_t> bufferedData(len);
-//    std::memcpy(bufferedData.data(), data, len);
+    // Frames bypass the dispatch queue: depending on the delivery mode the
+    // client handler is either called in place or is a FramesQueue that
+    // moves the frame to its own consumer thread.
+    clientFramesHandler_->onFrame(data, len);
+  }
 
-//    dispatchQueue_->dispatchEvent([handler = clientFramesHandler_, bufferedData = std::move(bufferedData)]
-//                                  {
-                                    clientFramesHandler_->onFrame(data, len);
-//                                  });
+  void onFrameBuffer(const FrameBuffer& frame) override
+  {
+    clientFramesHandler_->onFrameBuffer(frame);
   }
 
   void onErrorOccured(int code, const std::string &errorMsg) override
@@ -173,11 +303,21 @@ ListenerImpl::ListenerImpl(const std::string& ip,
                            AudioFramesHandlerPtr framesHandler,
                            DispatchQueuePtr dispatchQueue,
                            SuccessHandlerPtr successHandler,
-                           ErrorHandlerPtr errorHandler)
+                           ErrorHandlerPtr errorHandler,
+                           const ListenerOptions& options)
     : ip_(ip)
     , port_(port)
+    , authenticator_("velvetSweatshop", authCode.c_str())
+    , options_(options)
+    , counters_(std::make_shared<ListenerCounters>())
+    , useTcp_(options.transport == RtpTransport::Tcp)
 {
-    getClientAuthentificator()->setUsernameAndPassword("velvetSweatshop", authCode.c_str());
+  if (options.framesDelivery == FramesDelivery::Queued)
+  {
+    framesHandler = std::make_shared<FramesQueue>(std::move(framesHandler),
+                                                  options.queueSlotsCount,
+                                                  options.queueSlotSize);
+  }
 
   auto toClientDispatcher = std::make_shared<DispatchToClientProxy>(std::move(dispatchQueue),
                                                                     std::move(errorHandler),
@@ -193,22 +333,49 @@ void ListenerImpl::finallizeSession()
 {
   //const std::lock_guard<std::mutex> lock(finallizeGuard_);
 
+    if (reconnectTask_)
+    {
+        env_->taskScheduler().unscheduleDelayedTask(reconnectTask_);
+    }
+
     if (client_)
     {
+        const auto teardownStarted = std::chrono::steady_clock::now();
         shutdownStream(client_);
         client_ = nullptr;
+
+        const auto teardown = std::chrono::steady_clock::now() - teardownStarted;
+        counters_->connection.lastTeardownUs.store(
+            std::uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(teardown).count()),
+            std::memory_order_relaxed);
     }
 }
 
 ListenerImpl::~ListenerImpl()
 {
   finallizeSession();
+
+  if (eventLoop_)
+  {
+    eventLoop_->onListenerReleased();
+  }
 }
 
 #define RTSP_CLIENT_VERBOSITY_LEVEL 1 // by default, print verbose output from each "RTSPClient"
 
 void ListenerImpl::openURL(UsageEnvironment* env)
 {
+  env_ = env;
+
+  connectStartedAt_ = std::chrono::steady_clock::now();
+  for (auto* phase : {&counters_->connection.describeUs,
+                      &counters_->connection.setupUs,
+                      &counters_->connection.playUs,
+                      &counters_->connection.firstFrameUs})
+  {
+    phase->store(0, std::memory_order_relaxed);
+  }
+
   // Begin by creating a "RTSPClient" object.  Note that there is a separate
   // "RTSPClient" object for each stream that we wish to receive (even if
   // more than stream uses the same "rtsp://" URL).
@@ -223,16 +390,46 @@ void ListenerImpl::openURL(UsageEnvironment* env)
 
   client_ = rtspClient;
 
+  rtspClient->scs.overTcp = useTcp_;
+  counters_->connection.streamingOverTcp.store(useTcp_, std::memory_order_relaxed);
+
+  // A reconnect skips DESCRIBE and sets the new session up from the cached
+  // description right away.
+  if (!cachedSdp_.empty())
+  {
+    StreamClientState& scs = rtspClient->scs; // alias
+
+    rtspClient->setBaseURL(cachedBaseURL_.c_str());
+    scs.session = MediaSession::createNew(*env, cachedSdp_.c_str());
+    if (scs.session != NULL && scs.session->hasSubsessions())
+    {
+      scs.fromCachedDescription = true;
+      scs.iter = new MediaSubsessionIterator(*scs.session);
+      setupNextSubsession(rtspClient);
+      return;
+    }
+
+    cachedSdp_.clear();
+  }
+
   // Next, send a RTSP "DESCRIBE" command, to get a SDP description for the
   // stream. Note that this command - like all RTSP commands - is sent
   // asynchronously; we do not block, waiting for a response. Instead, the
   // following function call returns immediately, and we handle the RTSP
   // response later, from within the event loop:
-  rtspClient->sendDescribeCommand(continueAfterDESCRIBE, getClientAuthentificator());
+  rtspClient->sendDescribeCommand(continueAfterDESCRIBE, &authenticator_);
 }
 
 void ListenerImpl::reportErrorWithMessage(const int code, const std::string& message)
 {
+  // A wrong auth code will not get any better by retrying.
+  constexpr int Unauthorized = 401;
+  if (code != Unauthorized && scheduleReconnect())
+  {
+    *env_ << message.c_str() << env_->getResultMsg() << ", reconnecting\n";
+    return;
+  }
+
   finallizeSession();
 
   if (client_)
@@ -287,10 +484,19 @@ void ListenerImpl::continueAfterDESCRIBE(RTSPClient* rtspClient, int resultCode,
         break;
     }
 
+    listener.recordConnectPhase(listener.counters_->connection.describeUs);
+
     char* const sdpDescription = resultString;
     env << *rtspClient << "Got a SDP description:\n"
         << sdpDescription << "\n";
 
+    if (listener.options_.reconnect.enabled)
+    {
+      listener.cachedSdp_ = sdpDescription;
+      listener.cachedBaseURL_ = rtspClient->url();
+      listener.authenticator_ = client->currentAuthenticator();
+    }
+
     // Create a media session object from this SDP description:
     scs.session = MediaSession::createNew(env, sdpDescription);
     delete[] sdpDescription; // because we don't need it anymore
@@ -317,11 +523,6 @@ void ListenerImpl::continueAfterDESCRIBE(RTSPClient* rtspClient, int resultCode,
   } while (0);
 }
 
-// By default, we request that the server stream its data using RTP/UDP.
-// If, instead, you want to request that the server stream via RTP-over-TCP,
-// change the following to True:
-#define REQUEST_STREAMING_OVER_TCP False
-
 void ListenerImpl::setupNextSubsession(RTSPClient* rtspClient)
 {
   auto* client = static_cast<StandaloneRTSPClient*>(rtspClient);
@@ -330,8 +531,17 @@ void ListenerImpl::setupNextSubsession(RTSPClient* rtspClient)
   StreamClientState& scs = client->scs; // alias
   ListenerImpl& listener = client->listenerInstance; // alias
 
-  scs.subsession = scs.iter->next();
-  if (scs.subsession != NULL)
+  // Pipelined PLAY went out with the last SETUP, responses to the other
+  // SETUPs have nothing left to send.
+  if (scs.playSent)
+    return;
+
+  // The first SETUP has to be answered before anything else is sent, it
+  // assigns the session every further request refers to. Pipelined, all
+  // the others and PLAY then go out back to back.
+  const bool pipelined = listener.options_.pipelinedSetup && scs.hasSessionId;
+
+  while ((scs.subsession = scs.iter->next()) != NULL)
   {
     if (!scs.subsession->initiate())
     {
@@ -342,73 +552,99 @@ void ListenerImpl::setupNextSubsession(RTSPClient* rtspClient)
                                       scs.subsession->codecName(),
                                       "\" subsession: ");
 
-      setupNextSubsession(rtspClient); // give up on this subsession;
-          // go to the next one
+      // The client is gone unless a reconnect takes over later.
+      if (listener.client_ != client)
+        return;
+
+      continue; // give up on this subsession; go to the next one
+    }
+
+    env << *rtspClient << "Initiated the \"" << *scs.subsession << "\" subsession (";
+    if (scs.subsession->rtcpIsMuxed())
+    {
+      env << "client port " << scs.subsession->clientPortNum();
     }
     else
     {
-      env << *rtspClient << "Initiated the \"" << *scs.subsession << "\" subsession (";
-      if (scs.subsession->rtcpIsMuxed())
-      {
-        env << "client port " << scs.subsession->clientPortNum();
-      }
-      else
-      {
-        env << "client ports " << scs.subsession->clientPortNum() << "-"
-            << scs.subsession->clientPortNum() + 1;
-      }
-      env << ")\n";
-
-      // Continue setting up this subsession, by sending a RTSP "SETUP"
-      // command:
-      rtspClient->sendSetupCommand(*scs.subsession, continueAfterSETUP, False, REQUEST_STREAMING_OVER_TCP);
+      env << "client ports " << scs.subsession->clientPortNum() << "-"
+          << scs.subsession->clientPortNum() + 1;
     }
-    return;
+    env << ")\n";
+
+    // Continue setting up this subsession, by sending a RTSP "SETUP"
+    // command. Responses come back in request order, continueAfterSETUP
+    // takes them from the front of the queue.
+    scs.pendingSetups.push_back(scs.subsession);
+    rtspClient->sendSetupCommand(*scs.subsession, continueAfterSETUP, False, scs.overTcp,
+                                 False, &listener.authenticator_);
+
+    if (!pipelined)
+      return;
   }
 
   // We've finished setting up all of the subsessions.  Now, send a RTSP
   // "PLAY" command to start the streaming:
+  scs.playSent = true;
   if (scs.session->absStartTime() != NULL)
   {
     // Special case: The stream is indexed by 'absolute' time, so send an
     // appropriate "PLAY" command:
     rtspClient->sendPlayCommand(*scs.session, continueAfterPLAY, scs.session->absStartTime(),
-                                scs.session->absEndTime(), 1.0f, getClientAuthentificator());
+                                scs.session->absEndTime(), 1.0f, &listener.authenticator_);
   } else
   {
     scs.duration = scs.session->playEndTime() - scs.session->playStartTime();
-    rtspClient->sendPlayCommand(*scs.session, continueAfterPLAY, 0.0f, -1.0f, 1.0f, getClientAuthentificator());
+    rtspClient->sendPlayCommand(*scs.session, continueAfterPLAY, 0.0f, -1.0f, 1.0f, &listener.authenticator_);
   }
 }
 
 void ListenerImpl::continueAfterSETUP(RTSPClient* rtspClient, int resultCode, char* resultString)
 {
-  do {
-    auto* client = static_cast<StandaloneRTSPClient*>(rtspClient);
+  auto* client = static_cast<StandaloneRTSPClient*>(rtspClient);
+  ListenerImpl& listener = client->listenerInstance; // alias
 
+  StreamClientState& scs = client->scs; // alias
+
+  // A response nobody is waiting for, e.g. after the queue was dropped with
+  // the session; there is no subsession to attach it to.
+  if (scs.pendingSetups.empty())
+  {
+    delete[] resultString;
+    return;
+  }
+
+  MediaSubsession* subsession = scs.pendingSetups.front();
+  scs.pendingSetups.pop_front();
+
+  do {
     UsageEnvironment& env = client->envir(); // alias
-    StreamClientState& scs = client->scs; // alias
-    ListenerImpl& listener = client->listenerInstance; // alias
 
     if (resultCode != 0)
     {
+      // The server may have restarted with a different description.
+      if (scs.fromCachedDescription)
+        listener.cachedSdp_.clear();
+
       listener.reportErrorWithMessage(resultCode,
                                       "Failed to set up the \"",
-                                      scs.subsession->mediumName(),
+                                      subsession->mediumName(),
                                       "/",
-                                      scs.subsession->codecName(),
+                                      subsession->codecName(),
                                       "\" subsession: ");
       break;
     }
 
-    env << *rtspClient << "Set up the \"" << *scs.subsession << "\" subsession (";
-    if (scs.subsession->rtcpIsMuxed())
+    scs.hasSessionId = true;
+    listener.recordConnectPhase(listener.counters_->connection.setupUs);
+
+    env << *rtspClient << "Set up the \"" << *subsession << "\" subsession (";
+    if (subsession->rtcpIsMuxed())
     {
-      env << "client port " << scs.subsession->clientPortNum();
+      env << "client port " << subsession->clientPortNum();
     }
     else
     {
-      env << "client ports " << scs.subsession->clientPortNum() << "-" << scs.subsession->clientPortNum() + 1;
+      env << "client ports " << subsession->clientPortNum() << "-" << subsession->clientPortNum() + 1;
     }
     env << ")\n";
 
@@ -418,45 +654,63 @@ void ListenerImpl::continueAfterSETUP(RTSPClient* rtspClient, int resultCode, ch
     // start happening until later, after we've sent a RTSP "PLAY"
     // command.)
 
-    auto* sink = BufferedMediaSink::createNew(env, *scs.subsession, rtspClient->url());
+    const auto streamFormat = makeStreamFormat(*subsession, listener.options_.pcmConversion);
+    auto framesPool = FrameBufferPool::create(listener.options_.frameBuffersCount,
+                                              frameBufferSizeOf(*subsession, streamFormat, listener.options_));
+    auto* sink = BufferedMediaSink::createNew(env,
+                                              *subsession,
+                                              std::move(framesPool),
+                                              listener.counters_,
+                                              streamFormat.pcmConversion,
+                                              listener.options_.maxFrameBufferSize,
+                                              rtspClient->url());
     if (!sink)
     {
       listener.reportErrorWithMessage(resultCode,
                                       "Failed to create a data sink for the \"",
-                                      scs.subsession->mediumName(),
+                                      subsession->mediumName(),
                                       "/",
-                                      scs.subsession->codecName(),
+                                      subsession->codecName(),
                                       "\" subsession: ");
       break;
     }
 
+    listener.framesHandler_->onStreamFormat(streamFormat);
+
     sink->setFramesHandler(listener.framesHandler_);
-    scs.subsession->sink = sink;
+    sink->setFirstFrameHandler([&listener]() { listener.onFirstFrame(); });
+    if (listener.options_.jitterBuffer.enabled)
+    {
+      sink->setJitterBuffer(std::make_unique<JitterBuffer>(env.taskScheduler(),
+                                                           listener.framesHandler_,
+                                                           listener.options_.jitterBuffer,
+                                                           listener.counters_));
+    }
+    subsession->sink = sink;
 
-    env << *rtspClient << "Created a data sink for the \"" << *scs.subsession << "\" subsession\n";
-    scs.subsession->miscPtr = rtspClient; // a hack to let subsession handler functions get the
+    env << *rtspClient << "Created a data sink for the \"" << *subsession << "\" subsession\n";
+    subsession->miscPtr = rtspClient; // a hack to let subsession handler functions get the
         // "RTSPClient" from the subsession
-    scs.subsession->sink->startPlaying(*(scs.subsession->readSource()), subsessionAfterPlaying, scs.subsession);
+    subsession->sink->startPlaying(*(subsession->readSource()), subsessionAfterPlaying, subsession);
     listener.successHandler_->onConnectSuccess(client->destIp);
     // Also set a handler to be called if a RTCP "BYE" arrives for this
     // subsession:
-    if (scs.subsession->rtcpInstance() != NULL)
+    if (subsession->rtcpInstance() != NULL)
     {
-      scs.subsession->rtcpInstance()->setByeHandler(subsessionByeHandler, scs.subsession);
-      scs.subsession->rtcpInstance()->setRRHandler(subsessionByeHandler, scs.subsession);
-      // scs.subsession->rtcpInstance()->setSRHandler(subsessionByeHandler, scs.subsession);
+      subsession->rtcpInstance()->setByeHandler(subsessionByeHandler, subsession);
     }
   } while (0);
   delete[] resultString;
 
+  if (listener.client_ != client)
+    return;
+
   // Set up the next subsession, if any:
   setupNextSubsession(rtspClient);
 }
 
 void ListenerImpl::continueAfterPLAY(RTSPClient* rtspClient, int resultCode, char* resultString)
 {
-  Boolean success = False;
-
   do {
     auto* client = static_cast<StandaloneRTSPClient*>(rtspClient);
 
@@ -466,10 +720,15 @@ void ListenerImpl::continueAfterPLAY(RTSPClient* rtspClient, int resultCode, cha
 
     if (resultCode != 0)
     {
+      if (scs.fromCachedDescription)
+        listener.cachedSdp_.clear();
+
       listener.reportErrorWithMessage(resultCode, "Failed to start playing session: ", resultString);
       break;
     }
 
+    listener.recordConnectPhase(listener.counters_->connection.playUs);
+
     // Set a timer to be handled at the end of the stream's expected
     // duration (if the stream does not already signal its end using a
     // RTCP "BYE").  This is optional.  If, instead, you want to keep the
@@ -485,20 +744,35 @@ void ListenerImpl::continueAfterPLAY(RTSPClient* rtspClient, int resultCode, cha
       scs.streamTimerTask = env.taskScheduler().scheduleDelayedTask(uSecsToDelay, (TaskFunc*)streamTimerHandler, rtspClient);
     }
 
+    if (listener.options_.statsIntervalMs != 0)
+    {
+      scs.statsSampler.emplace(listener.counters_);
+      scs.statsTask = env.taskScheduler().scheduleDelayedTask(
+          std::int64_t(listener.options_.statsIntervalMs) * 1000, sampleStats, rtspClient);
+    }
+
+    if (listener.options_.transport == RtpTransport::Auto && !scs.overTcp)
+    {
+      scs.transportTask = env.taskScheduler().scheduleDelayedTask(
+          std::int64_t(listener.options_.udpFallbackTimeoutMs) * 1000, checkTransport, rtspClient);
+    }
+
+    if (listener.options_.reconnect.enabled)
+    {
+      listener.hasStreamed_ = true;
+
+      scs.lastActivity = std::chrono::steady_clock::now();
+      scs.livenessTask = env.taskScheduler().scheduleDelayedTask(
+          livenessCheckIntervalUs(listener.options_.reconnect), checkLiveness, rtspClient);
+    }
+
     env << *rtspClient << "Started playing session";
     if (scs.duration > 0) {
       env << " (for up to " << scs.duration << " seconds)";
     }
     env << "...\n";
-
-    success = True;
   } while (0);
   delete[] resultString;
-
-  if (!success) {
-    // An unrecoverable error occurred with this stream.
-    shutdownStream(rtspClient);
-  }
 }
 
 // Implementation of the other event handlers:
@@ -520,8 +794,13 @@ void ListenerImpl::subsessionAfterPlaying(void* clientData)
       return; // this subsession is still active
   }
 
-  // All subsessions' streams have now been closed, so shutdown the client:
-  shutdownStream(rtspClient);
+  // All subsessions' streams have now been closed: the client is replaced
+  // by a reconnected one, or shut down and the stream reported ended.
+  auto& listener = static_cast<StandaloneRTSPClient*>(rtspClient)->listenerInstance;
+  if (listener.isExpired())
+    shutdownStream(rtspClient);
+  else
+    listener.reportErrorWithMessage(500, "The stream ended");
 }
 
 void ListenerImpl::subsessionByeHandler(void* clientData)
@@ -541,6 +820,182 @@ void ListenerImpl::subsessionByeHandler(void* clientData)
   subsessionAfterPlaying(subsession);
 }
 
+void ListenerImpl::sampleStats(void* clientData)
+{
+  auto* client = static_cast<StandaloneRTSPClient*>(clientData);
+  StreamClientState& scs = client->scs; // alias
+  ListenerImpl& listener = client->listenerInstance; // alias
+
+  scs.statsTask = client->envir().taskScheduler().scheduleDelayedTask(
+      std::int64_t(listener.options_.statsIntervalMs) * 1000, sampleStats, client);
+
+  if (scs.session && scs.statsSampler)
+    scs.statsSampler->sample(*scs.session);
+
+  // One probe at a time, a lost response must not skew the next one.
+  if (!scs.roundTripStarted)
+  {
+    scs.roundTripStarted = std::chrono::steady_clock::now();
+    client->sendOptionsCommand(continueAfterOPTIONS, &listener.authenticator_);
+  }
+}
+
+void ListenerImpl::continueAfterOPTIONS(RTSPClient* rtspClient, int resultCode, char* resultString)
+{
+  delete[] resultString;
+
+  auto* client = static_cast<StandaloneRTSPClient*>(rtspClient);
+  StreamClientState& scs = client->scs; // alias
+  ListenerImpl& listener = client->listenerInstance; // alias
+
+  // Negative codes are transport errors, an RTSP error status still made
+  // the round trip.
+  if (scs.roundTripStarted && resultCode >= 0)
+  {
+    const auto rtt = std::chrono::steady_clock::now() - *scs.roundTripStarted;
+    listener.counters_->rtp.rttUs.store(
+        std::uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(rtt).count()),
+        std::memory_order_relaxed);
+  }
+  scs.roundTripStarted.reset();
+}
+
+bool ListenerImpl::scheduleReconnect()
+{
+  const auto& options = options_.reconnect;
+  if (!options.enabled || !hasStreamed_ || isExpired() || !env_)
+    return false;
+
+  if (reconnectTask_)
+    return true;
+
+  if (options.maxAttempts != 0 && reconnectAttempt_ >= options.maxAttempts)
+    return false;
+
+  if (!streamLostAt_)
+    streamLostAt_ = std::chrono::steady_clock::now();
+
+  auto delayMs = double(options.initialDelayMs);
+  for (std::uint32_t attempt = 0; attempt < reconnectAttempt_ && delayMs < options.maxDelayMs; ++attempt)
+    delayMs *= options.backoffMultiplier;
+  delayMs = std::min(delayMs, double(options.maxDelayMs));
+
+  // Spreads retries of listeners that lost their phones at the same moment.
+  std::uniform_real_distribution<double> jitter(-options.jitter, options.jitter);
+  delayMs = std::max(delayMs * (1. + jitter(backoffRandom_)), 0.);
+
+  ++reconnectAttempt_;
+  counters_->connection.reconnectAttempts.fetch_add(1, std::memory_order_relaxed);
+
+  *env_ << "Reconnecting in " << unsigned(delayMs) << " ms (attempt " << reconnectAttempt_ << ")\n";
+  reconnectTask_ = env_->taskScheduler().scheduleDelayedTask(std::int64_t(delayMs * 1000), reconnect, this);
+  return true;
+}
+
+void ListenerImpl::reconnect(void* listener)
+{
+  auto* self = static_cast<ListenerImpl*>(listener);
+  self->reconnectTask_ = nullptr;
+
+  self->finallizeSession();
+  if (!self->isExpired())
+    self->openURL(self->env_);
+}
+
+void ListenerImpl::checkLiveness(void* clientData)
+{
+  auto* client = static_cast<StandaloneRTSPClient*>(clientData);
+  StreamClientState& scs = client->scs; // alias
+  ListenerImpl& listener = client->listenerInstance; // alias
+
+  scs.livenessTask = NULL;
+
+  // The transport check decides about a session that never got going.
+  if (scs.transportTask)
+  {
+    scs.livenessTask = client->envir().taskScheduler().scheduleDelayedTask(
+        livenessCheckIntervalUs(listener.options_.reconnect), checkLiveness, client);
+    return;
+  }
+
+  const auto packetsDelivered = packetsDeliveredOf(*scs.session);
+  const auto now = std::chrono::steady_clock::now();
+  if (packetsDelivered != scs.lastPacketsDelivered)
+  {
+    scs.lastPacketsDelivered = packetsDelivered;
+    scs.lastActivity = now;
+  }
+  else if (now - scs.lastActivity >= std::chrono::milliseconds(listener.options_.reconnect.inactivityTimeoutMs))
+  {
+    client->envir() << *client << "No RTP received for " << listener.options_.reconnect.inactivityTimeoutMs
+                    << " ms\n";
+    if (listener.scheduleReconnect())
+      return;
+
+    // Out of reconnect attempts; the session is closed, which also ends
+    // these checks, and the stream reported lost.
+    if (!listener.isExpired())
+    {
+      listener.reportErrorWithMessage(500, "No RTP received, reconnect attempts exhausted");
+      return;
+    }
+  }
+
+  scs.livenessTask = client->envir().taskScheduler().scheduleDelayedTask(
+      livenessCheckIntervalUs(listener.options_.reconnect), checkLiveness, client);
+}
+
+void ListenerImpl::recordConnectPhase(std::atomic<std::uint32_t>& phaseUs)
+{
+  const auto elapsed = std::chrono::steady_clock::now() - connectStartedAt_;
+  phaseUs.store(std::uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()),
+                std::memory_order_relaxed);
+}
+
+void ListenerImpl::checkTransport(void* clientData)
+{
+  auto* client = static_cast<StandaloneRTSPClient*>(clientData);
+  StreamClientState& scs = client->scs; // alias
+  ListenerImpl& listener = client->listenerInstance; // alias
+
+  scs.transportTask = NULL;
+
+  if (packetsDeliveredOf(*scs.session) != 0)
+    return;
+
+  // Nothing made it through UDP, the network likely drops it. The session
+  // is set up again with RTP interleaved into the RTSP connection, and
+  // stays on TCP for every later reconnect.
+  client->envir() << *client << "No RTP received over UDP for " << listener.options_.udpFallbackTimeoutMs
+                  << " ms, falling back to RTP over TCP\n";
+
+  listener.useTcp_ = true;
+  listener.counters_->connection.udpFallbacks.fetch_add(1, std::memory_order_relaxed);
+
+  if (!listener.reconnectTask_)
+    listener.reconnectTask_ = client->envir().taskScheduler().scheduleDelayedTask(0, reconnect, &listener);
+}
+
+void ListenerImpl::onFirstFrame()
+{
+  // Every subsession reports its first frame, the stream's is the earliest.
+  if (counters_->connection.firstFrameUs.load(std::memory_order_relaxed) == 0)
+    recordConnectPhase(counters_->connection.firstFrameUs);
+
+  reconnectAttempt_ = 0;
+
+  if (streamLostAt_)
+  {
+    const auto latency = std::chrono::steady_clock::now() - *streamLostAt_;
+    streamLostAt_.reset();
+
+    counters_->connection.reconnects.fetch_add(1, std::memory_order_relaxed);
+    counters_->connection.lastReconnectLatencyUs.store(
+        std::uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(latency).count()),
+        std::memory_order_relaxed);
+  }
+}
+
 void ListenerImpl::streamTimerHandler(void* clientData)
 {
   auto* client = static_cast<StandaloneRTSPClient*>(clientData);
@@ -584,11 +1039,15 @@ void ListenerImpl::shutdownStream(RTSPClient* rtspClient, int)
       // Send a RTSP "TEARDOWN" command, to tell the server to shutdown
       // the stream. Don't bother handling the response to the
       // "TEARDOWN".
-      rtspClient->sendTeardownCommand(*scs.session, NULL, getClientAuthentificator());
+      rtspClient->sendTeardownCommand(*scs.session, NULL, &client->listenerInstance.authenticator_);
     }
   }
 
   env << *rtspClient << "Closing the stream.\n";
+
+  if (client->listenerInstance.client_ == client)
+    client->listenerInstance.client_ = nullptr;
+
   Medium::close(rtspClient);
 }
 
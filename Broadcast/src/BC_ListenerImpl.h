@@ -3,18 +3,28 @@
 #include "Broadcast/BC_AudioFramesHandler.h"
 #include "Broadcast/BC_DispatchQueue.h"
 #include "Broadcast/BC_ErrorHandler.h"
+#include "Broadcast/BC_ListenerOptions.h"
+#include "Broadcast/BC_ListenerStats.h"
 #include "Broadcast/BC_SuccessHandler.h"
 
+#include "BC_ListenerCounters.h"
+
 #include <RTSPClient.hh>
 #include <UsageEnvironment.hh>
 
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <optional>
+#include <random>
 #include <thread>
 #include <mutex>
 
 namespace Broadcast
 {
 
+class Live555EventLoop;
+
 class ListenerImpl
 {
 public:
@@ -24,7 +34,8 @@ public:
                AudioFramesHandlerPtr handler,
                DispatchQueuePtr dispatchQueue,
                SuccessHandlerPtr successHandler,
-               ErrorHandlerPtr errorHandler);
+               ErrorHandlerPtr errorHandler,
+               const ListenerOptions& options);
 
   ~ListenerImpl();
 
@@ -35,6 +46,11 @@ public:
   bool isExpired() const { return expired_; }
   void setExpired(bool expired) { expired_ = expired; }
 
+  void attachToEventLoop(Live555EventLoop* eventLoop) { eventLoop_ = eventLoop; }
+  Live555EventLoop* eventLoop() const { return eventLoop_; }
+
+  ListenerStats getStats() const { return counters_->snapshot(); }
+
 private:
  void reportErrorWithMessage(int code, const std::string& message);
  void reportErrorWithMessage(int code,
@@ -48,6 +64,7 @@ private:
  static void continueAfterDESCRIBE(RTSPClient* rtspClient, int resultCode, char* resultString);
  static void continueAfterSETUP(RTSPClient* rtspClient, int resultCode, char* resultString);
  static void continueAfterPLAY(RTSPClient* rtspClient, int resultCode, char* resultString);
+ static void continueAfterOPTIONS(RTSPClient* rtspClient, int resultCode, char* resultString);
 
  // Other event handler functions:
 
@@ -61,16 +78,39 @@ private:
  // already signaled its end using a RTCP "BYE")
  static void streamTimerHandler(void* clientData);
 
+ // periodically samples the RTP statistics and probes the round trip time
+ static void sampleStats(void* clientData);
+
  // Used to iterate through each stream's 'subsessions', setting up each one:
  static void setupNextSubsession(RTSPClient* rtspClient);
 
  // Used to shut down and close a stream (including its "RTSPClient" object):
  static void shutdownStream(RTSPClient* rtspClient, int exitCode = 1);
 
+ // Reconnection, see ReconnectOptions. Returns false when the session is
+ // not to be re-established and the failure has to be handled as before.
+ bool scheduleReconnect();
+ static void reconnect(void* listener);
+ static void checkLiveness(void* clientData);
+
+ // falls back to RTP over TCP when nothing arrived over UDP
+ static void checkTransport(void* clientData);
+ void onFirstFrame();
+
+ // Stores the time since the connection was opened into a phase counter.
+ void recordConnectPhase(std::atomic<std::uint32_t>& phaseUs);
+
 private:
-    bool expired_ = false;
+    std::atomic_bool expired_ = false;
     std::string ip_;
     std::uint16_t port_ = 0;
+    Authenticator authenticator_;
+    Live555EventLoop* eventLoop_ = nullptr;
+    ListenerOptions options_;
+    ListenerCountersPtr counters_;
+    bool useTcp_ = false;
+    UsageEnvironment* env_ = nullptr;
+    std::chrono::steady_clock::time_point connectStartedAt_;
     AudioFramesHandlerPtr framesHandler_;
     ErrorHandlerPtr errorHandler_;
     SuccessHandlerPtr successHandler_;
@@ -78,6 +118,15 @@ private:
 private:
     class StandaloneRTSPClient;
     StandaloneRTSPClient* client_ = nullptr;
+
+    // Reconnection state, touched on the event loop only.
+    bool hasStreamed_ = false;
+    std::string cachedSdp_;
+    std::string cachedBaseURL_;
+    std::uint32_t reconnectAttempt_ = 0;
+    TaskToken reconnectTask_ = nullptr;
+    std::optional<std::chrono::steady_clock::time_point> streamLostAt_;
+    std::minstd_rand backoffRandom_{std::random_device{}()};
 };
 
 } // namespace Broadcast
@@ -0,0 +1,107 @@
+#include "BC_Live555EventLoop.h"
+
+#include "BC_ListenerImpl.h"
+
+#include <BasicUsageEnvironment.hh>
+
+namespace Broadcast
+{
+
+Live555EventLoop::Live555EventLoop()
+{
+    scheduler_ = BasicTaskScheduler::createNew(SchedulerGranularityUs);
+    envir_ = BasicUsageEnvironment::createNew(*scheduler_);
+
+    openStreamURLEventID_ = scheduler_->createEventTrigger(Live555EventLoop::initListeners);
+    releaseListenersEventID_ = scheduler_->createEventTrigger(Live555EventLoop::releaseListeners);
+    stopEventID_ = scheduler_->createEventTrigger(Live555EventLoop::stop);
+
+    runnerThread_ = std::thread(
+        [this]()
+        {
+            scheduler_->doEventLoop(&stopFlag_);
+        });
+}
+
+Live555EventLoop::~Live555EventLoop()
+{
+    scheduler_->triggerEvent(stopEventID_, this);
+    runnerThread_.join();
+
+    // The loop thread is gone, whatever is still queued can be handled here.
+    for (const auto& listener : takeListeners(releasedListeners_))
+    {
+        listener->finallizeSession();
+    }
+    takeListeners(pendingListeners_);
+
+    scheduler_->deleteEventTrigger(stopEventID_);
+    scheduler_->deleteEventTrigger(releaseListenersEventID_);
+    scheduler_->deleteEventTrigger(openStreamURLEventID_);
+
+    envir_->reclaim();
+    delete scheduler_;
+}
+
+void Live555EventLoop::initialize(std::shared_ptr<ListenerImpl> listener)
+{
+    listenersCount_.fetch_add(1, std::memory_order_relaxed);
+    listener->attachToEventLoop(this);
+
+    {
+        const std::lock_guard<std::mutex> lock(listenersGuard_);
+        pendingListeners_.push_back(std::move(listener));
+    }
+
+    scheduler_->triggerEvent(openStreamURLEventID_, this);
+}
+
+void Live555EventLoop::release(std::shared_ptr<ListenerImpl> listener)
+{
+    {
+        const std::lock_guard<std::mutex> lock(listenersGuard_);
+        releasedListeners_.push_back(std::move(listener));
+    }
+
+    scheduler_->triggerEvent(releaseListenersEventID_, this);
+}
+
+Live555EventLoop::Listeners Live555EventLoop::takeListeners(Listeners& listeners)
+{
+    Listeners taken;
+
+    const std::lock_guard<std::mutex> lock(listenersGuard_);
+    taken.swap(listeners);
+
+    return taken;
+}
+
+void Live555EventLoop::initListeners(void* data)
+{
+    auto* self = static_cast<Live555EventLoop*>(data);
+
+    for (const auto& listener : self->takeListeners(self->pendingListeners_))
+    {
+        if (!listener->isExpired())
+        {
+            listener->openURL(self->envir_);
+        }
+    }
+}
+
+void Live555EventLoop::releaseListeners(void* data)
+{
+    auto* self = static_cast<Live555EventLoop*>(data);
+
+    for (const auto& listener : self->takeListeners(self->releasedListeners_))
+    {
+        listener->finallizeSession();
+    }
+}
+
+void Live555EventLoop::stop(void* data)
+{
+    static_cast<Live555EventLoop*>(data)->stopFlag_ = 1;
+}
+
+} // namespace Broadcast
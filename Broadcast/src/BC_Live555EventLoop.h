@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskScheduler;
+class UsageEnvironment;
+
+namespace Broadcast
+{
+
+class ListenerImpl;
+
+// One live555 scheduler with the thread running it. Every listener assigned
+// to the loop has its RTSP client, sessions and sinks driven by this thread
+// only, including their teardown.
+class Live555EventLoop final
+{
+public:
+    // Upper bound for how long a trigger may wait for the scheduler to wake
+    // up, and so for how long stopping the loop may take.
+    static constexpr unsigned SchedulerGranularityUs = 10000;
+
+    Live555EventLoop();
+    ~Live555EventLoop();
+
+    void initialize(std::shared_ptr<ListenerImpl> listener);
+
+    // Hands the last reference of an expired listener to the loop, so its
+    // session is closed and the listener is destroyed on the loop thread.
+    void release(std::shared_ptr<ListenerImpl> listener);
+
+    void onListenerReleased() { listenersCount_.fetch_sub(1, std::memory_order_relaxed); }
+
+    std::size_t listenersCount() const { return listenersCount_.load(std::memory_order_relaxed); }
+
+private:
+    using Listeners = std::vector<std::shared_ptr<ListenerImpl>>;
+
+    static void initListeners(void* eventLoop);
+    static void releaseListeners(void* eventLoop);
+    static void stop(void* eventLoop);
+
+    Listeners takeListeners(Listeners& listeners);
+
+private:
+    std::thread runnerThread_;
+
+    // Only touched by the loop thread.
+    char stopFlag_ = 0;
+
+    TaskScheduler* scheduler_ = nullptr;
+    UsageEnvironment* envir_ = nullptr;
+
+    std::uint32_t openStreamURLEventID_ = 0;
+    std::uint32_t releaseListenersEventID_ = 0;
+    std::uint32_t stopEventID_ = 0;
+
+    // A trigger only remembers the latest client data, so listeners waiting
+    // for the loop are queued here and all of them are taken on each trigger.
+    std::mutex listenersGuard_;
+    Listeners pendingListeners_;
+    Listeners releasedListeners_;
+
+    std::atomic<std::size_t> listenersCount_ = 0;
+};
+
+} // namespace Broadcast
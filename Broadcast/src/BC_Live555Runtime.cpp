@@ -1,49 +1,57 @@
 #include "BC_Live555Runtime.h"
 
-#include "BC_ListenerImpl.h"
+#include "BC_Live555EventLoop.h"
 
-#include <BasicUsageEnvironment.hh>
+#include <algorithm>
 
 namespace Broadcast
 {
 
-Live555Runtime::Live555Runtime()
+bool configureRuntime(const RuntimeOptions& options)
 {
-    scheduler_ = BasicTaskScheduler::createNew();
-    envir_ = BasicUsageEnvironment::createNew(*scheduler_);
-
-    openStreamURLEventID_ = scheduler_->createEventTrigger(Live555Runtime::initListener);
-
-    runnerThread_ = std::thread(
-        [this]()
-        {
-            scheduler_->doEventLoop(&runFlag);
-            runFlag = 1;
-        });
+    return Live555Runtime::configure(options);
 }
 
-Live555Runtime::~Live555Runtime()
+bool Live555Runtime::configure(const RuntimeOptions& options)
 {
-    runFlag = 2;
-    while(runFlag != 1)  { }
-    delete scheduler_;
-    runnerThread_.join();
-}
+    std::lock_guard lock(optionsMutex_);
+    if (isStarted_)
+    {
+        return false;
+    }
 
-void Live555Runtime::initialize(std::shared_ptr<ListenerImpl> listener)
-{
-    auto iter = pendingListeners_.insert({listener.get(), std::move(listener)});
-    scheduler_->triggerEvent(openStreamURLEventID_, iter.first->first);
+    options_ = options;
+    return true;
 }
 
-void Live555Runtime::initListener(void* data)
+Live555Runtime::Live555Runtime()
 {
-    auto* listener = reinterpret_cast<ListenerImpl*>(data);
-    if (!listener->isExpired())
+    RuntimeOptions options;
     {
-        listener->openURL(getInstance().envir_);
+        std::lock_guard lock(optionsMutex_);
+        options = options_;
+        isStarted_ = true;
     }
-    getInstance().pendingListeners_.erase(listener);
+
+    const auto eventLoopsCount = std::max<std::size_t>(options.eventLoopsCount, 1);
+    for (std::size_t index = 0; index < eventLoopsCount; ++index)
+    {
+        eventLoops_.push_back(std::make_unique<Live555EventLoop>());
+    }
+}
+
+Live555Runtime::~Live555Runtime() = default;
+
+void Live555Runtime::initialize(std::shared_ptr<ListenerImpl> listener)
+{
+    auto leastLoaded = std::min_element(eventLoops_.begin(),
+                                        eventLoops_.end(),
+                                        [](const auto& left, const auto& right)
+                                        {
+                                            return left->listenersCount() < right->listenersCount();
+                                        });
+
+    (*leastLoaded)->initialize(std::move(listener));
 }
 
 } // namespace Broadcast
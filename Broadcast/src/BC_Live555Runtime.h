@@ -1,16 +1,16 @@
 #pragma once
 
-#include <memory>
-#include <thread>
-#include <unordered_map>
+#include "Broadcast/BC_Runtime.h"
 
-class TaskScheduler;
-class UsageEnvironment;
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace Broadcast
 {
 
 class ListenerImpl;
+class Live555EventLoop;
 
 class Live555Runtime final
 {
@@ -21,23 +21,22 @@ public:
         return runtime;
     }
 
+    // Returns false once the event loops have been started.
+    static bool configure(const RuntimeOptions& options);
+
+    // Hands the listener to the least loaded event loop.
     void initialize(std::shared_ptr<ListenerImpl> listener);
 
 private:
     Live555Runtime();
     ~Live555Runtime();
 
-    static void initListener(void* listener);
-
 private:
-    std::thread runnerThread_;
-
-    char runFlag = 0;
-    TaskScheduler* scheduler_ = nullptr;
-    UsageEnvironment* envir_ = nullptr;
+    static inline std::mutex optionsMutex_;
+    static inline RuntimeOptions options_;
+    static inline bool isStarted_ = false;
 
-    std::uint32_t openStreamURLEventID_ = 0;
-    std::unordered_map<ListenerImpl*, std::shared_ptr<ListenerImpl>> pendingListeners_;
+    std::vector<std::unique_ptr<Live555EventLoop>> eventLoops_;
 };
 
 } // namespace Broadcast
@@ -0,0 +1,49 @@
+#include "BC_PcmConversion.h"
+
+#include "AP_CpuFeatures.h"
+
+#include <bit>
+#include <cstring>
+
+namespace Broadcast
+{
+
+namespace
+{
+// Network order already is host order on big endian hosts.
+void copyS16(const std::uint8_t* input, std::size_t samplesCount, std::int16_t* output)
+{
+  std::memmove(output, input, samplesCount * sizeof(std::int16_t));
+}
+
+PcmConversionKernels selectKernels()
+{
+  PcmConversionKernels kernels;
+  kernels.toS16 = std::endian::native == std::endian::big ? &copyS16 : &scalarNetworkToS16;
+  kernels.toFloat = &scalarNetworkToFloat;
+
+#ifdef BC_HAVE_X86_KERNELS
+  const auto& features = AudioPipeline::cpuFeatures();
+  if (features.avx2)
+  {
+    kernels.toS16 = &avx2NetworkToS16;
+    kernels.toFloat = &avx2NetworkToFloat;
+  }
+  else if (features.ssse3)
+  {
+    kernels.toS16 = &ssse3NetworkToS16;
+    kernels.toFloat = &ssse3NetworkToFloat;
+  }
+#endif
+
+  return kernels;
+}
+} // namespace
+
+const PcmConversionKernels& pcmConversionKernels()
+{
+  static const PcmConversionKernels kernels = selectKernels();
+  return kernels;
+}
+
+} // namespace Broadcast
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Broadcast
+{
+// Kernels turning network order (big endian) 16-bit samples into host
+// order int16 or float32 in a single pass. The int16 conversion may work in
+// place; the input needs no particular alignment.
+using NetworkToS16Kernel = void (*)(const std::uint8_t* input, std::size_t samplesCount, std::int16_t* output);
+using NetworkToFloatKernel = void (*)(const std::uint8_t* input, std::size_t samplesCount, float* output);
+
+struct PcmConversionKernels
+{
+  NetworkToS16Kernel toS16 = nullptr;
+  NetworkToFloatKernel toFloat = nullptr;
+};
+
+// The widest kernels the CPU runs, picked once.
+const PcmConversionKernels& pcmConversionKernels();
+
+constexpr float FloatSampleScale = 1.f / 32768.f;
+
+inline std::int16_t loadNetworkSample(const std::uint8_t* sample)
+{
+  return std::int16_t(std::uint16_t(sample[0]) << 8 | sample[1]);
+}
+
+inline void scalarNetworkToS16(const std::uint8_t* input, std::size_t samplesCount, std::int16_t* output)
+{
+  for (std::size_t index = 0; index < samplesCount; ++index)
+    output[index] = loadNetworkSample(input + index * 2);
+}
+
+inline void scalarNetworkToFloat(const std::uint8_t* input, std::size_t samplesCount, float* output)
+{
+  for (std::size_t index = 0; index < samplesCount; ++index)
+    output[index] = float(loadNetworkSample(input + index * 2)) * FloatSampleScale;
+}
+
+#ifdef BC_HAVE_X86_KERNELS
+void ssse3NetworkToS16(const std::uint8_t* input, std::size_t samplesCount, std::int16_t* output);
+void ssse3NetworkToFloat(const std::uint8_t* input, std::size_t samplesCount, float* output);
+void avx2NetworkToS16(const std::uint8_t* input, std::size_t samplesCount, std::int16_t* output);
+void avx2NetworkToFloat(const std::uint8_t* input, std::size_t samplesCount, float* output);
+#endif
+} // namespace Broadcast
@@ -0,0 +1,51 @@
+#include "BC_PcmConversion.h"
+
+#include <immintrin.h>
+
+namespace Broadcast
+{
+
+namespace
+{
+__m256i swapBytes(__m256i samples)
+{
+  // Shuffles stay within each 128-bit lane, which is all a byte swap needs.
+  const __m256i shuffle = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                           1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  return _mm256_shuffle_epi8(samples, shuffle);
+}
+} // namespace
+
+void avx2NetworkToS16(const std::uint8_t* input, std::size_t samplesCount, std::int16_t* output)
+{
+  constexpr std::size_t SamplesPerVector = sizeof(__m256i) / 2;
+  const std::size_t vectorizedCount = samplesCount / SamplesPerVector * SamplesPerVector;
+
+  for (std::size_t index = 0; index < vectorizedCount; index += SamplesPerVector)
+  {
+    const __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + index * 2));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + index), swapBytes(raw));
+  }
+
+  scalarNetworkToS16(input + vectorizedCount * 2, samplesCount - vectorizedCount, output + vectorizedCount);
+}
+
+void avx2NetworkToFloat(const std::uint8_t* input, std::size_t samplesCount, float* output)
+{
+  constexpr std::size_t SamplesPerVector = sizeof(__m128i) / 2;
+  const std::size_t vectorizedCount = samplesCount / SamplesPerVector * SamplesPerVector;
+  const __m256 scale = _mm256_set1_ps(FloatSampleScale);
+  const __m128i shuffle = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+
+  // Eight samples at a time, widened straight into a full register.
+  for (std::size_t index = 0; index < vectorizedCount; index += SamplesPerVector)
+  {
+    const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + index * 2));
+    const __m256i samples = _mm256_cvtepi16_epi32(_mm_shuffle_epi8(raw, shuffle));
+    _mm256_storeu_ps(output + index, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), scale));
+  }
+
+  scalarNetworkToFloat(input + vectorizedCount * 2, samplesCount - vectorizedCount, output + vectorizedCount);
+}
+
+} // namespace Broadcast
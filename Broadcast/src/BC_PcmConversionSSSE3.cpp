@@ -0,0 +1,52 @@
+#include "BC_PcmConversion.h"
+
+#include <tmmintrin.h>
+
+namespace Broadcast
+{
+
+namespace
+{
+__m128i swapBytes(__m128i samples)
+{
+  const __m128i shuffle = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  return _mm_shuffle_epi8(samples, shuffle);
+}
+} // namespace
+
+void ssse3NetworkToS16(const std::uint8_t* input, std::size_t samplesCount, std::int16_t* output)
+{
+  constexpr std::size_t SamplesPerVector = sizeof(__m128i) / 2;
+  const std::size_t vectorizedCount = samplesCount / SamplesPerVector * SamplesPerVector;
+
+  for (std::size_t index = 0; index < vectorizedCount; index += SamplesPerVector)
+  {
+    const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + index * 2));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + index), swapBytes(raw));
+  }
+
+  scalarNetworkToS16(input + vectorizedCount * 2, samplesCount - vectorizedCount, output + vectorizedCount);
+}
+
+void ssse3NetworkToFloat(const std::uint8_t* input, std::size_t samplesCount, float* output)
+{
+  constexpr std::size_t SamplesPerVector = sizeof(__m128i) / 2;
+  const std::size_t vectorizedCount = samplesCount / SamplesPerVector * SamplesPerVector;
+  const __m128 scale = _mm_set1_ps(FloatSampleScale);
+
+  for (std::size_t index = 0; index < vectorizedCount; index += SamplesPerVector)
+  {
+    const __m128i samples = swapBytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + index * 2)));
+
+    // Sign extends by placing every sample in the high half of a 32-bit lane.
+    const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+    const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+
+    _mm_storeu_ps(output + index, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+    _mm_storeu_ps(output + index + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+  }
+
+  scalarNetworkToFloat(input + vectorizedCount * 2, samplesCount - vectorizedCount, output + vectorizedCount);
+}
+
+} // namespace Broadcast
@@ -0,0 +1,78 @@
+#include "BC_RtpStatsSampler.h"
+
+#include "BC_BufferedMediaSink.h"
+
+#include <MediaSession.hh>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace Broadcast
+{
+
+RtpStatsSampler::RtpStatsSampler(ListenerCountersPtr counters)
+    : counters_(std::move(counters))
+{
+}
+
+void RtpStatsSampler::sample(MediaSession& session)
+{
+  std::uint64_t received = 0;
+  std::uint64_t expected = 0;
+  std::uint64_t delivered = 0;
+  std::uint64_t jitterUs = 0;
+  double kBytes = 0.;
+
+  MediaSubsessionIterator iter(session);
+  while (auto* subsession = iter.next())
+  {
+    auto* source = subsession->rtpSource();
+    if (!source)
+      continue;
+
+    const auto frequency = source->timestampFrequency();
+
+    RTPReceptionStatsDB::Iterator statsIter(source->receptionStatsDB());
+    while (auto* stats = statsIter.next(True))
+    {
+      received += stats->totNumPacketsReceived();
+      expected += stats->totNumPacketsExpected();
+      kBytes += stats->totNumKBytesReceived();
+
+      // live555 keeps the jitter in RTP timestamp units.
+      if (frequency != 0)
+        jitterUs = std::max<std::uint64_t>(jitterUs, std::uint64_t(stats->jitter()) * 1000000 / frequency);
+    }
+
+    if (auto* sink = dynamic_cast<BufferedMediaSink*>(subsession->sink))
+      delivered += sink->packetsDelivered();
+  }
+
+  // Received packets the source never handed over were either duplicates or
+  // came after their successors. Packets still waiting in the reordering
+  // buffer show up here only briefly, hence the counter never goes down.
+  if (received > delivered)
+    outOfOrderPackets_ = std::max(outOfOrderPackets_, received - delivered);
+
+  const auto now = std::chrono::steady_clock::now();
+  if (hasPrevious_)
+  {
+    const auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(now - previousTime_).count();
+    if (elapsedUs > 0)
+    {
+      const auto kbps = (kBytes - previousKBytes_) * 8. * 1000000. / double(elapsedUs);
+      counters_->rtp.bitrateKbps.store(std::uint32_t(std::max(kbps, 0.)), std::memory_order_relaxed);
+    }
+  }
+  hasPrevious_ = true;
+  previousKBytes_ = kBytes;
+  previousTime_ = now;
+
+  constexpr auto Relaxed = std::memory_order_relaxed;
+  counters_->rtp.packetsReceived.store(received, Relaxed);
+  counters_->rtp.packetsLost.store(expected > received ? expected - received : 0, Relaxed);
+  counters_->rtp.outOfOrderPackets.store(outOfOrderPackets_, Relaxed);
+  counters_->rtp.jitterUs.store(std::uint32_t(std::min<std::uint64_t>(jitterUs, UINT32_MAX)), Relaxed);
+}
+
+} // namespace Broadcast
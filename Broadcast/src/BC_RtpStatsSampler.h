@@ -0,0 +1,31 @@
+#pragma once
+
+#include "BC_ListenerCounters.h"
+
+#include <chrono>
+#include <cstdint>
+
+class MediaSession;
+
+namespace Broadcast
+{
+// Folds live555's per-source RTP reception statistics of a session into the
+// listener counters. Called periodically on the event loop, readers only
+// ever see the counters.
+class RtpStatsSampler final
+{
+public:
+  explicit RtpStatsSampler(ListenerCountersPtr counters);
+
+  void sample(MediaSession& session);
+
+private:
+  ListenerCountersPtr counters_;
+
+  bool hasPrevious_ = false;
+  double previousKBytes_ = 0.;
+  std::chrono::steady_clock::time_point previousTime_;
+
+  std::uint64_t outOfOrderPackets_ = 0;
+};
+} // namespace Broadcast
@@ -0,0 +1,25 @@
+#include "HL_SinkFramesHandler.h"
+
+#include "AudioPipeline/AP_ProcessingStages.h"
+
+namespace Headless
+{
+
+std::shared_ptr<AudioPipeline::StreamFrontEnd> createSinkFramesHandler(AudioPipeline::AudioSinkPtr sink,
+                                                                       std::vector<AudioPipeline::AudioSinkPtr> extraOutputs)
+{
+  // The sink stages are kept across streams, they are restarted only when
+  // the format of the audio changes.
+  std::vector<std::shared_ptr<AudioPipeline::SinkStage>> sinkStages;
+  sinkStages.push_back(std::make_shared<AudioPipeline::SinkStage>(std::move(sink)));
+  for (auto& output : extraOutputs)
+    sinkStages.push_back(std::make_shared<AudioPipeline::SinkStage>(std::move(output)));
+
+  return std::make_shared<AudioPipeline::StreamFrontEnd>(
+      [sinkStages = std::move(sinkStages)](AudioPipeline::ProcessingGraph::Wiring& wiring, std::size_t after) {
+        for (const auto& stage : sinkStages)
+          wiring.add(stage, after);
+      });
+}
+
+} // namespace Headless
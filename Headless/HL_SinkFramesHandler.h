@@ -0,0 +1,18 @@
+#pragma once
+
+#include "AudioPipeline/AP_AudioSink.h"
+#include "AudioPipeline/AP_StreamFrontEnd.h"
+
+#include <memory>
+#include <vector>
+
+namespace Headless
+{
+// Handles received frames with the stream front end and writes the PCM to
+// an audio sink, which is (re)started with the format of the audio, and to
+// any extra outputs such as a recorder. Audio of lost packets is concealed
+// before it reaches them, and silence is flagged so they can take their
+// cheaper paths for it.
+std::shared_ptr<AudioPipeline::StreamFrontEnd> createSinkFramesHandler(AudioPipeline::AudioSinkPtr sink,
+                                                                       std::vector<AudioPipeline::AudioSinkPtr> extraOutputs = {});
+} // namespace Headless
@@ -0,0 +1,331 @@
+#include "HL_SinkFramesHandler.h"
+
+#include "AudioPipeline/AP_DriftCompensator.h"
+#include "AudioPipeline/AP_Mixer.h"
+#include "AudioPipeline/AP_Recorder.h"
+#include "AudioPipeline/AP_ReplayCapture.h"
+#include "AudioPipeline/AP_SubmissionEngine.h"
+#include "Broadcast/BC_Listener.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+std::atomic_bool stopRequested = false;
+std::atomic_bool replayRequested = false;
+
+class ImmediateDispatchQueue : public Broadcast::DispatchQueue
+{
+public:
+  void dispatchEvent(VoidEvent event) override { event(); }
+};
+
+class ConsoleEventsHandler : public Broadcast::ErrorHandler
+                           , public Broadcast::SuccessHandler
+{
+public:
+  void onErrorOccured(int code, const std::string& errorMsg) override
+  {
+    std::cerr << "Error " << code << ": " << errorMsg << std::endl;
+    stopRequested = true;
+  }
+
+  void onConnectSuccess(const std::string& ip) override
+  {
+    std::cout << "Connected to " << ip << std::endl;
+  }
+};
+
+struct Phone
+{
+  std::string ip;
+  std::uint16_t port = 0;
+  std::string authCode;
+
+  std::shared_ptr<AudioPipeline::StreamFrontEnd> framesHandler;
+  AudioPipeline::MixerInputPtr mixerInput;
+  std::unique_ptr<Broadcast::Listener> listener;
+};
+
+// Parses "ip[:port[:auth code]],..." with the given port and auth code as
+// defaults.
+std::vector<Phone> parsePhones(const std::string& list, std::uint16_t port, const std::string& authCode)
+{
+  std::vector<Phone> phones;
+
+  std::istringstream entries(list);
+  for (std::string entry; std::getline(entries, entry, ',');)
+  {
+    std::istringstream fields(entry);
+    std::string portField;
+
+    Phone phone;
+    std::getline(fields, phone.ip, ':');
+    phone.port = std::getline(fields, portField, ':') && !portField.empty() ? static_cast<std::uint16_t>(std::stoul(portField)) : port;
+    if (!std::getline(fields, phone.authCode) || phone.authCode.empty())
+      phone.authCode = authCode;
+
+    if (!phone.ip.empty())
+      phones.push_back(std::move(phone));
+  }
+
+  return phones;
+}
+
+void printPhoneStats(const Phone& phone)
+{
+  const auto listenerStats = phone.listener->getStats();
+  std::cout << "  " << phone.ip
+            << " jitter " << listenerStats.jitterBuffer.jitterUs << " us"
+            << ", target delay " << listenerStats.jitterBuffer.targetDelayUs << " us"
+            << ", underruns " << listenerStats.jitterBuffer.underruns
+            << ", no buffer drops " << listenerStats.receive.framesDroppedNoBuffer
+            << ", truncated " << listenerStats.receive.framesTruncated
+            << " (buffers " << listenerStats.receive.frameBufferSize << " bytes"
+            << ", regrown " << listenerStats.receive.bufferResizes << " times)" << std::endl;
+  std::cout << "  rtp received " << listenerStats.rtp.packetsReceived
+            << ", lost " << listenerStats.rtp.packetsLost
+            << ", out of order " << listenerStats.rtp.outOfOrderPackets
+            << ", jitter " << listenerStats.rtp.jitterUs << " us"
+            << ", rtt " << listenerStats.rtp.rttUs << " us"
+            << ", " << listenerStats.rtp.bitrateKbps << " kbps"
+            << ", reconnects " << listenerStats.connection.reconnects
+            << " (last took " << listenerStats.connection.lastReconnectLatencyUs << " us)" << std::endl;
+
+  const auto concealmentStats = phone.framesHandler->concealmentStats();
+  std::cout << "  concealed " << concealmentStats.concealedFrames << " frames"
+            << " in " << concealmentStats.concealmentEvents << " gaps"
+            << " of " << concealmentStats.lostPackets << " lost packets"
+            << ", late discarded " << concealmentStats.discardedPackets << std::endl;
+
+  // What silent blocks cost less than the others, over all stages.
+  std::int64_t savedNs = 0;
+  std::cout << "  stages";
+  for (const auto& timing : phone.framesHandler->stageTimings())
+  {
+    std::cout << " " << timing.name << " " << timing.averageNs << "/" << timing.maxNs << " ns";
+    savedNs += timing.silenceSavedNs();
+  }
+  std::cout << std::endl;
+
+  const auto voiceActivityStats = phone.framesHandler->voiceActivityStats();
+  std::cout << "  silence " << std::lround(voiceActivityStats.silenceRatio() * 100.) << "%"
+            << ", speech onsets " << voiceActivityStats.speechOnsets
+            << ", detection took " << voiceActivityStats.detectionNs / 1000 << " us"
+            << ", silence saved " << savedNs / 1000 << " us" << std::endl;
+
+  if (phone.mixerInput)
+  {
+    const auto inputStats = phone.mixerInput->inputStats();
+    std::cout << "  mixer input " << (!inputStats.isStarted ? "stopped" : inputStats.isMixed ? "mixed" : "waiting")
+              << ", buffered " << inputStats.bufferedFrames << " frames"
+              << ", dropped " << inputStats.framesDropped
+              << ", underruns " << inputStats.underruns;
+    const auto driftStats = phone.mixerInput->driftStats();
+    if (driftStats.isCompensating)
+      std::cout << ", drift " << driftStats.driftPpm << " ppm"
+                << ", correction " << driftStats.correctionPpm << " ppm";
+    if (inputStats.formatsRejected != 0)
+      std::cout << ", rejected " << inputStats.formatsRejected << " formats";
+    std::cout << std::endl;
+  }
+}
+
+void printUsage(const char* executable)
+{
+  std::cerr << "Usage: " << executable
+            << " <ip[:port[:auth code]],...> <port> <auth code> <output fifo or file | fake> [period ms]"
+            << " [recording.wav | recording.flac]\n"
+            << "Receives a MicBridge stream and writes it as raw PCM to the output. The \"fake\" output\n"
+            << "submits to an in-process device consuming audio in real time, like the driver does.\n"
+            << "The session is also recorded when a recording is given, leaving silence out, in files\n"
+            << "named after it that are rotated every hour. SIGUSR1 saves the last 30 seconds of audio to replay-<n>.wav.\n"
+            << "Several phones, each with its own port and auth code or the given ones, are mixed into\n"
+            << "a single 48 kHz stereo stream." << std::endl;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc < 5)
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  auto phones = parsePhones(argv[1], static_cast<std::uint16_t>(std::stoul(argv[2])), argv[3]);
+  if (phones.empty())
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  const std::string outputPath = argv[4];
+  const auto periodMs = argc > 5 ? std::stoul(argv[5]) : 10ul;
+  const std::string recordingPath = argc > 6 ? argv[6] : std::string();
+
+  std::signal(SIGINT, [](int) { stopRequested = true; });
+  std::signal(SIGTERM, [](int) { stopRequested = true; });
+  std::signal(SIGUSR1, [](int) { replayRequested = true; });
+  // A FIFO reader going away must not kill the receiver.
+  std::signal(SIGPIPE, SIG_IGN);
+
+  constexpr std::uint32_t SubmissionRequestsCount = 4;
+
+  AudioPipeline::AudioSinkPtr sink;
+  std::shared_ptr<AudioPipeline::SubmissionEngine> submission;
+  std::shared_ptr<AudioPipeline::DriftCompensator> driftCompensator;
+  if (outputPath == "fake")
+  {
+    submission = std::make_shared<AudioPipeline::SubmissionEngine>(AudioPipeline::createFakeSubmissionDevice(),
+                                                                   std::chrono::milliseconds(periodMs),
+                                                                   SubmissionRequestsCount);
+
+    AudioPipeline::DriftCompensationOptions driftOptions;
+    driftOptions.targetDelay = std::chrono::milliseconds(periodMs) * SubmissionRequestsCount / 2;
+    driftCompensator = std::make_shared<AudioPipeline::DriftCompensator>(submission, driftOptions);
+    sink = driftCompensator;
+  }
+  else
+  {
+    sink = AudioPipeline::createFileAudioSink(outputPath, std::chrono::milliseconds(periodMs));
+  }
+
+  std::shared_ptr<AudioPipeline::Recorder> recorder;
+  if (!recordingPath.empty())
+  {
+    const auto extension = recordingPath.rfind('.');
+    const auto isFlac = extension != std::string::npos && recordingPath.substr(extension) == ".flac";
+
+    AudioPipeline::RecorderOptions recorderOptions;
+    recorderOptions.pathPrefix = recordingPath.substr(0, extension);
+    recorderOptions.container = isFlac ? AudioPipeline::RecordingContainer::Flac : AudioPipeline::RecordingContainer::Wav;
+    recorderOptions.maxFileDuration = std::chrono::hours(1);
+    recorderOptions.skipSilence = true;
+    recorder = std::make_shared<AudioPipeline::Recorder>(recorderOptions);
+  }
+
+  auto replay = std::make_shared<AudioPipeline::ReplayCapture>(std::chrono::seconds(30));
+  std::vector<AudioPipeline::AudioSinkPtr> extraOutputs = {replay};
+  if (recorder)
+    extraOutputs.push_back(recorder);
+
+  auto eventsHandler = std::make_shared<ConsoleEventsHandler>();
+
+  Broadcast::ListenerOptions options;
+  options.framesDelivery = Broadcast::FramesDelivery::Queued;
+  options.jitterBuffer.enabled = true;
+  options.reconnect.enabled = true;
+
+  // A single phone goes straight to the outputs; several are mixed on the
+  // mixer thread, which then feeds the outputs instead.
+  std::unique_ptr<AudioPipeline::Mixer> mixer;
+  if (phones.size() > 1)
+  {
+    AudioPipeline::MixerOptions mixerOptions;
+    mixerOptions.blockDuration = std::chrono::milliseconds(periodMs);
+
+    extraOutputs.insert(extraOutputs.begin(), sink);
+    mixer = std::make_unique<AudioPipeline::Mixer>(std::move(extraOutputs), mixerOptions);
+    for (auto& phone : phones)
+    {
+      phone.mixerInput = mixer->addInput();
+      phone.framesHandler = Headless::createSinkFramesHandler(phone.mixerInput);
+    }
+  }
+  else
+  {
+    phones.front().framesHandler = Headless::createSinkFramesHandler(sink, std::move(extraOutputs));
+  }
+
+  {
+    for (auto& phone : phones)
+    {
+      phone.listener = std::make_unique<Broadcast::Listener>(phone.ip,
+                                                             phone.port,
+                                                             phone.authCode,
+                                                             phone.framesHandler,
+                                                             std::make_shared<ImmediateDispatchQueue>(),
+                                                             eventsHandler,
+                                                             eventsHandler,
+                                                             options);
+    }
+
+    std::uint32_t replaysCount = 0;
+    while (!stopRequested)
+    {
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+
+      if (replayRequested.exchange(false))
+      {
+        const auto replayPath = "replay-" + std::to_string(++replaysCount) + ".wav";
+        if (replay->dump(replayPath, AudioPipeline::RecordingContainer::Wav))
+          std::cout << "Saved the last seconds of audio to " << replayPath << std::endl;
+        else
+          std::cerr << "Failed to save the last seconds of audio to " << replayPath << std::endl;
+      }
+
+      const auto sinkStats = sink->stats();
+      std::cout << "periods written " << sinkStats.periodsWritten
+                << ", dropped " << sinkStats.periodsDropped << std::endl;
+
+      for (const auto& phone : phones)
+        printPhoneStats(phone);
+
+      if (mixer)
+      {
+        const auto mixerStats = mixer->stats();
+        std::cout << "  mixed " << mixerStats.mixedInputs << " of " << mixerStats.inputsCount << " inputs"
+                  << ", blocks " << mixerStats.blocksMixed
+                  << ", late " << mixerStats.blocksLate
+                  << ", silent " << mixerStats.silentBlocks
+                  << ", mix avg " << mixerStats.averageMixNs << " ns"
+                  << ", max " << mixerStats.maxMixNs << " ns" << std::endl;
+      }
+
+      if (recorder)
+      {
+        const auto recorderStats = recorder->recorderStats();
+        std::cout << "  recorded " << recorderStats.blocksRecorded << " blocks"
+                  << " (" << recorderStats.bytesWritten << " bytes)"
+                  << ", silence skipped " << recorderStats.silentBytesSkipped << " bytes"
+                  << ", dropped " << recorderStats.blocksDropped
+                  << ", queued " << recorderStats.queuedBlocks << " (max " << recorderStats.maxQueuedBlocks << ")"
+                  << ", files " << recorderStats.filesCompleted
+                  << ", write errors " << recorderStats.writeErrors << std::endl;
+      }
+
+      if (submission)
+      {
+        const auto submissionStats = submission->submissionStats();
+        std::cout << "  chunks completed " << submissionStats.chunksCompleted
+                  << ", in flight " << submissionStats.inFlight
+                  << ", dropped " << submissionStats.chunksDropped
+                  << ", silent " << submissionStats.silentChunks
+                  << ", latency avg " << submissionStats.averageLatencyUs << " us"
+                  << ", max " << submissionStats.maxLatencyUs << " us" << std::endl;
+
+        const auto driftStats = driftCompensator->driftStats();
+        std::cout << "  clock drift " << driftStats.driftPpm << " ppm"
+                  << ", correction " << driftStats.correctionPpm << " ppm"
+                  << ", buffered " << driftStats.bufferedUs << " us"
+                  << " (target " << driftStats.targetUs << " us)" << std::endl;
+      }
+    }
+
+    // Receiving stops before the mixer and outputs go away.
+    for (auto& phone : phones)
+      phone.listener.reset();
+  }
+
+  return 0;
+}
@@ -1,38 +1,25 @@
 #include "UI_AudioLevelsIODevice.h"
 
-#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+bool isS16LE(const AudioInfo::AudioFormat& format)
+{
+  return format.sampleLength == 16 && format.isSigned && format.isLittleEndian && format.channelsCount != 0;
+}
+} // namespace
 
 AudioInfo::AudioInfo(const AudioFormat &format, QObject *parent)
     : QIODevice(parent)
     , m_format(format)
-    , m_maxAmplitude(0)
-    , m_level(0.0)
-
 {
-  switch (m_format.sampleLength) {
-    case 8:
-      switch (m_format.isSigned) {
-        case false:
-          m_maxAmplitude = 255;
-          break;
-        case true:
-          m_maxAmplitude = 127;
-          break;
-        default: ;
-      }
-      break;
-    case 16:
-      switch (m_format.isSigned) {
-        case false:
-          m_maxAmplitude = 65535;
-          break;
-        case true:
-          m_maxAmplitude = 32767;
-          break;
-        default: ;
-      }
-      break;
-  }
+  const auto sampleFormat = AudioPipeline::makeSampleFormat(m_format.sampleLength,
+                                                            m_format.isSigned,
+                                                            m_format.isLittleEndian);
+  if (sampleFormat)
+    m_levels.emplace(*sampleFormat, m_format.sampleRate, m_format.channelsCount, DefaultLevelsRefreshRate);
 }
 
 AudioInfo::~AudioInfo()
@@ -49,61 +36,139 @@ void AudioInfo::stop()
   close();
 }
 
-qint64 AudioInfo::readData(char *data, qint64 maxlen)
+bool AudioInfo::startPlayback(const AudioFormat& outputFormat)
 {
-    Q_UNUSED(data);
-    Q_UNUSED(maxlen);
-    return 0;
-//    return buffer_.readBuff(data, maxlen);
+  stopPlayback();
+
+  if (!isS16LE(m_format) || !isS16LE(outputFormat))
+    return false;
+  if (outputFormat.channelsCount != m_format.channelsCount && m_format.channelsCount != 1)
+    return false;
+
+  playbackFormat_ = outputFormat;
+
+  resampler_.reset();
+  std::size_t outputFrames = AudioPipeline::Resampler::MaxBlockFrames;
+  if (outputFormat.sampleRate != m_format.sampleRate)
+  {
+    resampler_.emplace(m_format.sampleRate, outputFormat.sampleRate, m_format.channelsCount);
+    outputFrames = resampler_->maxOutputFrames(AudioPipeline::Resampler::MaxBlockFrames);
+  }
+
+  playbackInput_.resize(AudioPipeline::Resampler::MaxBlockFrames * m_format.channelsCount);
+  playbackOutput_.resize(outputFrames * m_format.channelsCount);
+  playbackOutputFrames_ = 0;
+  playbackOutputOffset_ = 0;
+
+  buffer_.consumerClear();
+  isPlaying_.store(true, std::memory_order_release);
+
+  return true;
 }
 
-qint64 AudioInfo::writeData(const char *data, qint64 len)
+void AudioInfo::stopPlayback()
+{
+  isPlaying_.store(false, std::memory_order_release);
+}
+
+bool AudioInfo::convertPlaybackBlock()
 {
-//    const auto written = buffer_.writeBuff(data, len);
-//    emit bytesWritten(written);
+  const std::size_t frameBytes = m_format.channelsCount * sizeof(std::int16_t);
+  const auto framesCount = std::min<std::size_t>(buffer_.readAvailable() / frameBytes,
+                                                 AudioPipeline::Resampler::MaxBlockFrames);
+  if (framesCount == 0)
+    return false;
 
-  if (m_maxAmplitude) {
-    Q_ASSERT(m_format.sampleLength % 8 == 0);
-    const int channelBytes = m_format.sampleLength / 8;
-    const int sampleBytes = m_format.channelsCount * channelBytes;
-    Q_ASSERT(len % sampleBytes == 0);
-    const int numSamples = len / sampleBytes;
+  buffer_.readBuff(reinterpret_cast<char*>(playbackInput_.data()), framesCount * frameBytes);
 
-    quint16 maxValue = 0;
-    const unsigned char *ptr = reinterpret_cast<const unsigned char *>(data);
+  if (resampler_)
+  {
+    playbackOutputFrames_ = resampler_->process(playbackInput_.data(), framesCount, playbackOutput_.data());
+  }
+  else
+  {
+    std::copy_n(playbackInput_.data(), framesCount * m_format.channelsCount, playbackOutput_.data());
+    playbackOutputFrames_ = framesCount;
+  }
+  playbackOutputOffset_ = 0;
 
-    for (int i = 0; i < numSamples; ++i)
+  return true;
+}
+
+qint64 AudioInfo::readData(char *data, qint64 maxlen)
+{
+  if (!isPlaying_.load(std::memory_order_acquire))
+    return 0;
+
+  const std::size_t inputChannels = m_format.channelsCount;
+  const std::size_t outputChannels = playbackFormat_.channelsCount;
+  const auto outputFrameBytes = outputChannels * sizeof(std::int16_t);
+
+  qint64 written = 0;
+  while (written + qint64(outputFrameBytes) <= maxlen)
+  {
+    // The resampler may hold a block back until it has enough history.
+    if (playbackOutputOffset_ == playbackOutputFrames_ && !convertPlaybackBlock())
+      break;
+
+    const auto framesCount = std::min(playbackOutputFrames_ - playbackOutputOffset_,
+                                      std::size_t(maxlen - written) / outputFrameBytes);
+    const auto* frames = playbackOutput_.data() + playbackOutputOffset_ * inputChannels;
+
+    if (inputChannels == outputChannels)
     {
-      for(int j = 0; j < m_format.channelsCount; ++j)
-        {
-        quint16 value = 0;
-
-        if (m_format.sampleLength == 8 && !m_format.isSigned) {
-          value = *reinterpret_cast<const quint8*>(ptr);
-        } else if (m_format.sampleLength == 8 && m_format.isSigned) {
-          value = qAbs(*reinterpret_cast<const qint8*>(ptr));
-        } else if (m_format.sampleLength == 16 && !m_format.isSigned) {
-          if (m_format.isLittleEndian)
-            value = qFromLittleEndian<quint16>(ptr);
-          else
-            value = qFromBigEndian<quint16>(ptr);
-        } else if (m_format.sampleLength == 16 && m_format.isSigned) {
-          if (m_format.isLittleEndian)
-            value = qAbs(qFromLittleEndian<qint16>(ptr));
-          else
-            value = qAbs(qFromBigEndian<qint16>(ptr));
-        }
-
-        maxValue = qMax(value, maxValue);
-        ptr += channelBytes;
+      std::memcpy(data + written, frames, framesCount * outputFrameBytes);
+    }
+    else
+    {
+      // Mono spread over every output channel.
+      auto* output = data + written;
+      for (std::size_t frame = 0; frame < framesCount; ++frame)
+      {
+        for (std::size_t channel = 0; channel < outputChannels; ++channel, output += sizeof(std::int16_t))
+          std::memcpy(output, &frames[frame], sizeof(std::int16_t));
       }
     }
 
-    maxValue = qMin(maxValue, m_maxAmplitude);
-    m_level = qreal(maxValue) / m_maxAmplitude;
+    playbackOutputOffset_ += framesCount;
+    written += qint64(framesCount * outputFrameBytes);
   }
 
-  emit update(m_level);
+  return written;
+}
+
+qint64 AudioInfo::writeData(const char *data, qint64 len)
+{
+  bufferForPlayback(data, len);
+
+  if (m_levels)
+    m_levels->accumulate(data, len);
 
   return len;
 }
+
+void AudioInfo::writeSilence(const char *data, qint64 len)
+{
+  bufferForPlayback(data, len);
+
+  if (m_levels)
+    m_levels->accumulateSilence(std::size_t(len));
+}
+
+void AudioInfo::bufferForPlayback(const char *data, qint64 len)
+{
+  // Whole writes only, so the reader never sees a split frame.
+  if (isPlaying_.load(std::memory_order_acquire) && buffer_.writeAvailable() >= std::size_t(len))
+    buffer_.writeBuff(data, std::size_t(len));
+}
+
+void AudioInfo::setLevelsRefreshRate(std::uint32_t refreshRateHz)
+{
+  if (m_levels)
+    m_levels->setPublishRate(refreshRateHz);
+}
+
+AudioPipeline::LevelSnapshot AudioInfo::levels() const
+{
+  return m_levels ? m_levels->snapshot() : AudioPipeline::LevelSnapshot();
+}
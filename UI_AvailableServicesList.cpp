@@ -2,7 +2,10 @@
 
 #include "UI_AvailableServicesListModel.h"
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <vector>
 
 #include <QHeaderView>
 #include <QPushButton>
@@ -53,7 +56,7 @@ AvailableServicesList::AvailableServicesList(QWidget* parent)
 
     auto onRowsChange = [this]()
     {
-        bool hasConnectedDevice = false;
+        std::set<std::pair<std::string, std::uint16_t>> listedServices;
 
         for (int i = 0; i < model_->rowCount(); ++i)
         {
@@ -80,22 +83,28 @@ AvailableServicesList::AvailableServicesList(QWidget* parent)
 
             auto item = model_->index(i, 0);
             const auto itemIP = item.data(AvailableServicesListModel::DataCode::IPv4).toString().toStdString();
-            const auto itemPort = item.data(AvailableServicesListModel::DataCode::Port).toUInt();
-            disconnectButton->setEnabled(itemIP == connectedServiceIp_ && itemPort == connectedServicePort_);
+            const auto itemPort = std::uint16_t(item.data(AvailableServicesListModel::DataCode::Port).toUInt());
+            const bool isConnected = connectedServices_.count({itemIP, itemPort}) != 0;
+            disconnectButton->setEnabled(isConnected);
 
-            if (!hasConnectedDevice)
+            if (isConnected)
             {
-                hasConnectedDevice = itemIP == connectedServiceIp_ && itemPort == connectedServicePort_;
+                listedServices.emplace(itemIP, itemPort);
             }
 
             setIndexWidget(model_->index(i, 1), connectButton);
             setIndexWidget(model_->index(i, 2), disconnectButton);
         }
 
-        if (!hasConnectedDevice && !connectedServiceIp_.empty() && connectedServicePort_ != 0)
+        std::vector<std::pair<std::string, std::uint16_t>> lostServices;
+        std::set_difference(connectedServices_.begin(), connectedServices_.end(),
+                            listedServices.begin(), listedServices.end(),
+                            std::back_inserter(lostServices));
+
+        for (auto& [ip, port] : lostServices)
         {
-            setCurrentDeviceDisconnected();
-            emit connectedDeviceLost();
+            connectedServices_.erase({ip, port});
+            emit connectedDeviceLost(ip, port);
         }
     };
 
@@ -106,26 +115,24 @@ AvailableServicesList::AvailableServicesList(QWidget* parent)
 
 void AvailableServicesList::setDeviceIsConnected(std::string, std::string ip, std::uint16_t port)
 {
-    connectedServiceIp_ = std::move(ip);
-    connectedServicePort_ = port;
-
-   for (int i = 0; i < model_->rowCount(); ++i)
-   {
-       auto item = model_->index(i, 0);
-       const auto itemIP = item.data(AvailableServicesListModel::DataCode::IPv4).toString().toStdString();
-       const auto itemPort = item.data(AvailableServicesListModel::DataCode::Port).toUInt();
-       indexWidget(model_->index(i, 2))->setEnabled(itemIP == connectedServiceIp_ && itemPort == connectedServicePort_);
-   }
+    connectedServices_.emplace(std::move(ip), port);
+    updateDisconnectButtons();
 }
 
-void AvailableServicesList::setCurrentDeviceDisconnected()
+void AvailableServicesList::setDeviceDisconnected(const std::string& ip, std::uint16_t port)
 {
-    connectedServiceIp_.clear();
-    connectedServicePort_ = 0;
+    connectedServices_.erase({ip, port});
+    updateDisconnectButtons();
+}
 
+void AvailableServicesList::updateDisconnectButtons()
+{
     for (int i = 0; i < model_->rowCount(); ++i)
     {
-        indexWidget(model_->index(i, 2))->setEnabled(false);
+        auto item = model_->index(i, 0);
+        const auto itemIP = item.data(AvailableServicesListModel::DataCode::IPv4).toString().toStdString();
+        const auto itemPort = std::uint16_t(item.data(AvailableServicesListModel::DataCode::Port).toUInt());
+        indexWidget(model_->index(i, 2))->setEnabled(connectedServices_.count({itemIP, itemPort}) != 0);
     }
 }
 
@@ -2,6 +2,9 @@
 
 #include <QTableView>
 
+#include <set>
+#include <utility>
+
 class QPushButton;
 
 namespace UI
@@ -15,10 +18,10 @@ public:
     AvailableServicesList(QWidget* parent);
 
     void setDeviceIsConnected(std::string name, std::string ip, std::uint16_t port);
-    void setCurrentDeviceDisconnected();
+    void setDeviceDisconnected(const std::string& ip, std::uint16_t port);
 
 signals:
-    void connectedDeviceLost();
+    void connectedDeviceLost(std::string ip, std::uint16_t port);
     void connectClicked(std::string name, std::string ip, std::uint16_t port);
     void disconnectClicked(std::string name, std::string ip, std::uint16_t port);
 
@@ -27,11 +30,12 @@ protected:
 
 private:
     void buttonHandler(QPushButton* button, bool connect);
+    void updateDisconnectButtons();
 
 private:
     AvailableServicesListModel* model_;
 
-    std::string connectedServiceIp_;
-    std::uint16_t connectedServicePort_ = 0;
+    // Several devices may be connected at once, identified by IP and port.
+    std::set<std::pair<std::string, std::uint16_t>> connectedServices_;
 };
 } // namespace UI
@@ -1,6 +1,6 @@
 #include "UI_DriverControl.h"
 
-#include "WMFAACDecoder.h"
+#include "AudioPipeline/AP_ProcessingStages.h"
 
 #include <initguid.h>
 #include <Devpkey.h>
@@ -13,12 +13,14 @@
 
 #include <QFile>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <optional>
+#include <vector>
 #include <cassert>
 #include <iostream>
 
-#include <iomanip>
-#include <sstream>
 
 #define RtlOffsetToPointer(Base, Offset) ((PCHAR)(((PCHAR)(Base)) + ((ULONG_PTR)(Offset))))
 #define RtlPointerToOffset(Base, Pointer) ((ULONG)(((PCHAR)(Pointer)) - ((PCHAR)(Base))))
@@ -107,25 +109,18 @@ HANDLE getDrvHandle()
 
                 if (wcscmp((PWSTR)buf, MicBridgeInterfaceName) == 0)
                 {
+                  // Opened for overlapped IO, stream requests are completed
+                  // through a completion port.
                   HANDLE hFile = CreateFileW(pszDeviceInterface,
-                                                           GENERIC_READ | GENERIC_WRITE,
-                                                           FILE_SHARE_READ | FILE_SHARE_WRITE,
-                                                           0,
-                                             OPEN_EXISTING, 0, 0);
+                                             GENERIC_READ | GENERIC_WRITE,
+                                             FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                             0,
+                                             OPEN_EXISTING, FILE_FLAG_OVERLAPPED, 0);
 
-                  if (err == CR_SUCCESS)
+                  if (hFile == INVALID_HANDLE_VALUE)
                   {
-                    HANDLE hFile = CreateFileW(pszDeviceInterface,
-                                               GENERIC_READ | GENERIC_WRITE,
-                                               FILE_SHARE_READ | FILE_SHARE_WRITE,
-                                               0,
-                                               OPEN_EXISTING, 0, 0);
-
-                    if (hFile == INVALID_HANDLE_VALUE)
-                    {
-                      _tprintf(TEXT("NOT  -   OK"));
-                      _tprintf(TEXT("\n"));
-                    }
+                    _tprintf(TEXT("NOT  -   OK"));
+                    _tprintf(TEXT("\n"));
                   }
 
                   return hFile;
@@ -145,133 +140,499 @@ AudioInfo::AudioFormat getDefaultAudioFormat()
 {
     return {44100, 1, 16, true, true};
 }
+
+constexpr std::chrono::milliseconds SubmissionPeriod(10);
+constexpr std::uint32_t SubmissionRequestsCount = 4;
+
+// The jitter buffer of the listeners already absorbs the network, the mixer
+// only has to cover a compressed frame, about 23 ms, and scheduling.
+constexpr std::chrono::milliseconds MixerInputDelay(40);
+
+// Audio kept for saving after a glitch, about 2.5 MB of the mix.
+constexpr std::chrono::seconds ReplayDuration(30);
+
+// The mix is made in the driver format, so phones are converted to it
+// before they are queued and the mixer has nothing left to convert.
+using DriverFormatChain = AudioPipeline::StaticChain<AudioPipeline::RemixStage, AudioPipeline::ResampleStage>;
+
+// Stops audio the driver format cannot be converted from, e.g. a decoder
+// producing 8-bit samples, and reports it once per format.
+class DriverFormatGuard final : public AudioPipeline::ProcessingStage
+{
+public:
+    explicit DriverFormatGuard(AudioPipeline::StreamFrontEnd::ErrorCallback onError)
+        : onError_(std::move(onError))
+    {
+    }
+
+    const char* name() const override { return "driver format"; }
+
+    bool configure(const AudioPipeline::PcmFormat& format) override
+    {
+        if (format.sampleFormat == AudioPipeline::SampleFormat::S16LE && format.sampleRate != 0
+            && format.channelsCount != 0)
+            return true;
+
+        onError_("The stream decodes to a format the driver cannot take, its audio will be dropped");
+        return false;
+    }
+
+    AudioPipeline::AudioBlock process(const AudioPipeline::AudioBlock& input) override
+    {
+        return input;
+    }
+
+private:
+    const AudioPipeline::StreamFrontEnd::ErrorCallback onError_;
+};
+
+// Feeds the virtual microphone pin with IOCTL_KS_READ_STREAM requests kept
+// in flight through a completion port. Stream headers are allocated once
+// per request slot and reused.
+class KsStreamDevice final : public AudioPipeline::SubmissionDevice
+{
+public:
+    explicit KsStreamDevice(HANDLE driverHandle)
+        : driverHandle_(driverHandle)
+        , completionPort_(CreateIoCompletionPort(driverHandle, NULL, 0, 1))
+    {
+    }
+
+    ~KsStreamDevice() override
+    {
+        if (completionPort_ != NULL)
+            CloseHandle(completionPort_);
+    }
+
+    bool open(const AudioPipeline::PcmFormat&, std::uint32_t requestsCount) override
+    {
+        requests_ = std::vector<Request>(requestsCount);
+        for (auto& request : requests_)
+        {
+            ZeroMemory(&request.header, sizeof(KSSTREAM_HEADER));
+            request.header.Size = sizeof(KSSTREAM_HEADER);
+            request.header.PresentationTime.Numerator = 1;
+            request.header.PresentationTime.Denominator = 1;
+        }
+
+        return completionPort_ != NULL;
+    }
+
+    bool submit(const std::uint8_t* data, std::size_t size, std::uint32_t token) override
+    {
+        auto& request = requests_[token];
+        ZeroMemory(&request.overlapped, sizeof(OVERLAPPED));
+        request.header.Data = const_cast<std::uint8_t*>(data);
+        request.header.FrameExtent = static_cast<ULONG>(size);
+
+        const BOOL completed = DeviceIoControl(driverHandle_,
+                                               IOCTL_KS_READ_STREAM,
+                                               &request.header,
+                                               sizeof(KSSTREAM_HEADER),
+                                               NULL,
+                                               0,
+                                               NULL,
+                                               &request.overlapped);
+
+        // Completed or not, the completion port gets a packet for it.
+        return completed || GetLastError() == ERROR_IO_PENDING;
+    }
+
+    bool waitCompletion(std::chrono::milliseconds timeout, AudioPipeline::SubmissionCompletion& completion) override
+    {
+        DWORD transferred = 0;
+        ULONG_PTR key = 0;
+        LPOVERLAPPED overlapped = NULL;
+
+        const BOOL succeeded = GetQueuedCompletionStatus(completionPort_,
+                                                         &transferred,
+                                                         &key,
+                                                         &overlapped,
+                                                         static_cast<DWORD>(timeout.count()));
+        if (overlapped == NULL)
+            return false;
+
+        auto* request = CONTAINING_RECORD(overlapped, Request, overlapped);
+        completion.token = static_cast<std::uint32_t>(request - requests_.data());
+        completion.succeeded = succeeded != FALSE;
+
+        return true;
+    }
+
+    void cancel() override
+    {
+        CancelIoEx(driverHandle_, NULL);
+    }
+
+    void close() override
+    {
+    }
+
+private:
+    struct Request
+    {
+        KSSTREAM_HEADER header;
+        OVERLAPPED overlapped;
+    };
+
+    HANDLE driverHandle_;
+    HANDLE completionPort_;
+    std::vector<Request> requests_;
+};
+
+// Meters the mix, and plays it back when listening.
+class AudioInfoSink final : public AudioPipeline::AudioSink
+{
+public:
+    explicit AudioInfoSink(AudioInfo& audioInfo)
+        : audioInfo_(audioInfo)
+    {
+    }
+
+    bool start(const AudioPipeline::PcmFormat& format) override
+    {
+        const auto& infoFormat = audioInfo_.getFormat();
+        return format.sampleFormat == AudioPipeline::SampleFormat::S16LE
+               && format.sampleRate == infoFormat.sampleRate
+               && format.channelsCount == infoFormat.channelsCount;
+    }
+
+    void write(const std::uint8_t* data, std::size_t size) override
+    {
+        audioInfo_.writeData(reinterpret_cast<const char*>(data), static_cast<qint64>(size));
+        count(size);
+    }
+
+    void writeSilence(const std::uint8_t* data, std::size_t size) override
+    {
+        audioInfo_.writeSilence(reinterpret_cast<const char*>(data), static_cast<qint64>(size));
+        count(size);
+    }
+
+    void stop() override
+    {
+    }
+
+    AudioPipeline::AudioSinkStats stats() const override
+    {
+        AudioPipeline::AudioSinkStats stats;
+        stats.periodsWritten = periodsWritten_.load(std::memory_order_relaxed);
+        stats.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    void count(std::size_t size)
+    {
+        periodsWritten_.fetch_add(1, std::memory_order_relaxed);
+        bytesWritten_.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    AudioInfo& audioInfo_;
+    std::atomic<std::uint64_t> periodsWritten_ = 0;
+    std::atomic<std::uint64_t> bytesWritten_ = 0;
+};
+
+// Writes to every output that takes the format, as the mixer does.
+class OutputsSink final : public AudioPipeline::AudioSink
+{
+public:
+    explicit OutputsSink(std::vector<AudioPipeline::AudioSinkPtr> outputs)
+        : outputs_(std::move(outputs))
+    {
+    }
+
+    bool start(const AudioPipeline::PcmFormat& format) override
+    {
+        startedOutputs_.clear();
+        for (const auto& output : outputs_)
+        {
+            if (output->start(format))
+                startedOutputs_.push_back(output);
+        }
+
+        return !startedOutputs_.empty();
+    }
+
+    void write(const std::uint8_t* data, std::size_t size) override
+    {
+        for (const auto& output : startedOutputs_)
+            output->write(data, size);
+        count(size);
+    }
+
+    void writeSilence(const std::uint8_t* data, std::size_t size) override
+    {
+        for (const auto& output : startedOutputs_)
+            output->writeSilence(data, size);
+        count(size);
+    }
+
+    void stop() override
+    {
+        for (const auto& output : startedOutputs_)
+            output->stop();
+        startedOutputs_.clear();
+    }
+
+    AudioPipeline::AudioSinkStats stats() const override
+    {
+        AudioPipeline::AudioSinkStats stats;
+        stats.periodsWritten = periodsWritten_.load(std::memory_order_relaxed);
+        stats.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    void count(std::size_t size)
+    {
+        periodsWritten_.fetch_add(1, std::memory_order_relaxed);
+        bytesWritten_.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    const std::vector<AudioPipeline::AudioSinkPtr> outputs_;
+    std::vector<AudioPipeline::AudioSinkPtr> startedOutputs_;
+    std::atomic<std::uint64_t> periodsWritten_ = 0;
+    std::atomic<std::uint64_t> bytesWritten_ = 0;
+};
 } // namespace
 
-wmf::WMFAACDecoder decoder;
+// The audio of one phone, passed on to whatever the driver output routes it
+// to: the outputs, a mixer input, or nowhere. Rerouting happens on another
+// thread than the writes, the lock keeps the phone from writing to a sink
+// that is being taken away; it is only contended then.
+class DriverOutput::Input final : public AudioPipeline::AudioSink
+{
+public:
+    bool start(const AudioPipeline::PcmFormat& format) override
+    {
+        std::lock_guard lock(mutex_);
+        stopSink();
+        format_ = format;
+        startSink();
+        return true;
+    }
 
-DriverControlFramesSender::DriverControlFramesSender()
+    void write(const std::uint8_t* data, std::size_t size) override
+    {
+        std::lock_guard lock(mutex_);
+        if (isSinkStarted_)
+            sink_->write(data, size);
+        count(size);
+    }
+
+    void writeSilence(const std::uint8_t* data, std::size_t size) override
+    {
+        std::lock_guard lock(mutex_);
+        if (isSinkStarted_)
+            sink_->writeSilence(data, size);
+        count(size);
+    }
+
+    void stop() override
+    {
+        std::lock_guard lock(mutex_);
+        stopSink();
+        format_.reset();
+    }
+
+    AudioPipeline::AudioSinkStats stats() const override
+    {
+        AudioPipeline::AudioSinkStats stats;
+        stats.periodsWritten = periodsWritten_.load(std::memory_order_relaxed);
+        stats.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // The new sink is started with the format the phone is streaming, if
+    // any, once the previous one is stopped.
+    void route(AudioPipeline::AudioSinkPtr sink)
+    {
+        std::lock_guard lock(mutex_);
+        stopSink();
+        sink_ = std::move(sink);
+        startSink();
+    }
+
+    // Driver output side, under its lock.
+    AudioPipeline::MixerInputPtr mixerInput;
+
+private:
+    void startSink()
+    {
+        isSinkStarted_ = format_ && sink_ && sink_->start(*format_);
+    }
+
+    void stopSink()
+    {
+        if (isSinkStarted_)
+            sink_->stop();
+        isSinkStarted_ = false;
+    }
+
+    void count(std::size_t size)
+    {
+        periodsWritten_.fetch_add(1, std::memory_order_relaxed);
+        bytesWritten_.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    std::mutex mutex_;
+    AudioPipeline::AudioSinkPtr sink_;
+    std::optional<AudioPipeline::PcmFormat> format_;
+    bool isSinkStarted_ = false;
+
+    std::atomic<std::uint64_t> periodsWritten_ = 0;
+    std::atomic<std::uint64_t> bytesWritten_ = 0;
+};
+
+DriverOutput::DriverOutput()
     : driverHandle_(getDrvHandle())
     , audioInfo_(getDefaultAudioFormat(), nullptr)
+    , replay_(std::make_shared<AudioPipeline::ReplayCapture>(ReplayDuration))
 {
-    HMODULE mod = LoadLibrary(wmf::WMFDecoderDllNameFor(wmf::CodecType::AAC));
-    int err = GetLastError();
-    LoadLibrary("mfplat.dll");
+    if (driverHandle_ != INVALID_HANDLE_VALUE)
+    {
+        submission_ = std::make_shared<AudioPipeline::SubmissionEngine>(std::make_shared<KsStreamDevice>(driverHandle_),
+                                                                        SubmissionPeriod,
+                                                                        SubmissionRequestsCount);
+
+        // Half of the requests in flight leaves room both ways.
+        AudioPipeline::DriftCompensationOptions driftOptions;
+        driftOptions.targetDelay = SubmissionPeriod * SubmissionRequestsCount / 2;
+        driftCompensator_ = std::make_shared<AudioPipeline::DriftCompensator>(submission_, driftOptions);
+        outputs_.push_back(driftCompensator_);
+    }
 
-    unsigned char audioSpecificConfig[2];
-    std::uint8_t const audioObjectType = 2;
-    audioSpecificConfig[0] = (audioObjectType << 3) | (4 >> 1);
-    audioSpecificConfig[1] = (4 << 7) | (1 << 3);
+    outputs_.push_back(replay_);
+    outputs_.push_back(std::make_shared<AudioInfoSink>(audioInfo_));
+    directOutput_ = std::make_shared<OutputsSink>(outputs_);
 
-    decoder.Init(1, 44100, audioSpecificConfig, 2);
+    // One mixer cycle per driver request.
+    const auto driverFormat = getDefaultAudioFormat();
+    mixerOptions_.sampleRate = driverFormat.sampleRate;
+    mixerOptions_.channelsCount = driverFormat.channelsCount;
+    mixerOptions_.blockDuration = SubmissionPeriod;
+    mixerOptions_.inputDelay = MixerInputDelay;
 }
 
-AudioInfo* DriverControlFramesSender::getAudioInfoIODevice()
+DriverOutput::~DriverOutput()
 {
-    return &audioInfo_;
+    // Phones still streaming must not reach the outputs once they are gone.
+    std::lock_guard lock(mutex_);
+    for (const auto& input : inputs_)
+        input->route(nullptr);
+    mixer_.reset();
 }
 
-void DriverControlFramesSender::onFrame(const std::uint8_t *frameData, std::size_t length)
+AudioPipeline::AudioSinkPtr DriverOutput::addInput()
 {
-//    static QFile* f = []()
-//    {
-//        QFile* file = new QFile("out.aac");
-//        file->open(QIODevice::WriteOnly | QIODevice::Append);
-
-//        return file;
-//    }();
-
-//    f->write(reinterpret_cast<const char*>(frameData), length);
-
-    onDecodedData(frameData, length);
-//    if (SUCCEEDED(decoder.Input(frameData, length, 0)))
-//    {
-//        wmf::CComPtr<IMFSample> input = nullptr;
-//        if (SUCCEEDED(decoder.Output(&input)))
-//        {
-//            wmf::CComPtr<IMFMediaBuffer> buffer = nullptr;
-//            HRESULT hr = input->ConvertToContiguousBuffer(&buffer);
-//            if (!SUCCEEDED(hr))
-//                std::cout << "Couldn't convert " << hr << std::endl << std::flush;
-//            DWORD maxLength = 0;
-//            DWORD currentLength = 0;
-//            BYTE* bufferBytes = nullptr;
-//            hr = buffer->Lock(&bufferBytes, &maxLength, &currentLength);
-//            if (!SUCCEEDED(hr))
-//            {
-//                std::cout << "Lock buffer not succeeded: " << hr << std::endl << std::flush;
-//            }
-//            else
-//            {
-//                onDecodedData(bufferBytes, currentLength);
-//            }
-
-//            buffer->Unlock();
-//        }
-//        else
-//        {
-//            // std::cout << "Decoder output failed \n" << std::endl << std::flush;
-//        }
-//    }
-//    else
-//    {
-//        std::cout << "Decoder input failed \n" << std::endl << std::flush;
-//    }
+    std::lock_guard lock(mutex_);
+    inputs_.push_back(std::make_shared<Input>());
+    const auto input = inputs_.back();
+    routeInputs();
+    return input;
 }
 
-namespace
+void DriverOutput::removeInput(const AudioPipeline::AudioSinkPtr& input)
 {
+    std::lock_guard lock(mutex_);
+    const auto removed = std::find(inputs_.begin(), inputs_.end(), input);
+    if (removed == inputs_.end())
+        return;
+
+    (*removed)->route(nullptr);
+    if (mixer_ && (*removed)->mixerInput)
+        mixer_->removeInput((*removed)->mixerInput);
+    inputs_.erase(removed);
+    routeInputs();
+}
+
+void DriverOutput::routeInputs()
+{
+    // Whichever way the outputs are fed, it stops writing to them before
+    // the other starts: the direct input when it is routed away, the mixer
+    // thread when the mixer is destroyed.
+    if (inputs_.size() > 1)
+    {
+        if (!mixer_)
+        {
+            for (const auto& input : inputs_)
+                input->route(nullptr);
+            mixer_ = std::make_unique<AudioPipeline::Mixer>(outputs_, mixerOptions_);
+        }
+
+        for (const auto& input : inputs_)
+        {
+            if (input->mixerInput)
+                continue;
+
+            input->mixerInput = mixer_->addInput();
+            input->route(input->mixerInput);
+        }
+        return;
+    }
+
+    // A single phone needs no alignment, it skips the mixer and its delay.
+    if (mixer_)
+    {
+        for (const auto& input : inputs_)
+        {
+            input->route(nullptr);
+            input->mixerInput.reset();
+        }
+        mixer_.reset();
+    }
 
-std::string getTimestamp()
+    if (!inputs_.empty())
+        inputs_.front()->route(directOutput_);
+}
+
+AudioInfo* DriverOutput::getAudioInfoIODevice()
 {
-    using namespace std::chrono;
-    const auto now = system_clock::now();
-    const auto nowAsTimeT = system_clock::to_time_t(now);
-    const auto nowMs = duration_cast<milliseconds>(now.time_since_epoch()) % 1000;
-    std::stringstream nowSs;
-    nowSs << std::put_time(std::localtime(&nowAsTimeT), "%a %b %d %Y %T")
-          << '.' << std::setfill('0') << std::setw(3) << nowMs.count();
-    return nowSs.str();
+    return &audioInfo_;
 }
 
-}  // namespace
+AudioPipeline::SubmissionStats DriverOutput::getSubmissionStats() const
+{
+    return submission_ ? submission_->submissionStats() : AudioPipeline::SubmissionStats();
+}
 
-void DriverControlFramesSender::onDecodedData(const std::uint8_t* frameData, std::size_t length)
+AudioPipeline::DriftStats DriverOutput::getDriftStats() const
 {
-//    static std::size_t rawPacketsCount = 0;
-//    static std::size_t rawTotalBytes = 0;
+    return driftCompensator_ ? driftCompensator_->driftStats() : AudioPipeline::DriftStats();
+}
 
-//    rawPacketsCount++;
-//    rawTotalBytes += length;
+AudioPipeline::MixerStats DriverOutput::getMixerStats() const
+{
+    std::lock_guard lock(mutex_);
+    return mixer_ ? mixer_->stats() : AudioPipeline::MixerStats();
+}
 
-//    if ((rawPacketsCount % 100) == 0)
-//    {
-//        std::cout << "Raw packets [" << rawPacketsCount << " pckts," << rawTotalBytes << " bytes] - "
-//                  << "decoded. Timestamp: " << getTimestamp() << std::endl;
-//    }
+std::shared_ptr<AudioPipeline::ReplayCapture> DriverOutput::getReplayCapture() const
+{
+    return replay_;
+}
 
-    if (driverHandle_ != INVALID_HANDLE_VALUE)
-    {
-        KSSTREAM_HEADER streamHeader;
-        ZeroMemory(&streamHeader, sizeof(KSSTREAM_HEADER));
-        streamHeader.Size = sizeof(KSSTREAM_HEADER);
-        streamHeader.Data = const_cast<std::uint8_t*>(frameData);
-        streamHeader.FrameExtent = length;
-        streamHeader.DataUsed = 0;
-        streamHeader.PresentationTime.Time = 0;
-        streamHeader.PresentationTime.Numerator = 1;
-        streamHeader.PresentationTime.Denominator = 1;
-        streamHeader.OptionsFlags = false ? KSSTREAM_HEADER_OPTIONSF_LOOPEDDATA : 0;
-
-        DWORD cbReturned = 0;
-        DeviceIoControl(driverHandle_,
-                        IOCTL_KS_READ_STREAM,
-                        &streamHeader,
-                        sizeof(KSSTREAM_HEADER),
-                        NULL,
-                        NULL,
-                        &cbReturned,
-                        NULL);
-    }
-
-    audioInfo_.writeData(reinterpret_cast<const char*>(frameData), length);
+std::shared_ptr<AudioPipeline::StreamFrontEnd> createDriverFramesSender(AudioPipeline::AudioSinkPtr driverInput,
+                                                                        AudioPipeline::StreamFrontEnd::ErrorCallback onError)
+{
+    // Kept across streams, the input is restarted only when the format of
+    // the audio changes. Silence is written as such, the outputs and the
+    // mixer take cheaper paths for it.
+    auto driverStage = std::make_shared<AudioPipeline::SinkStage>(std::move(driverInput));
+
+    return std::make_shared<AudioPipeline::StreamFrontEnd>(
+        [driverStage = std::move(driverStage), onError](AudioPipeline::ProcessingGraph::Wiring& wiring, std::size_t after) {
+            // Each phone runs on its own clock; when mixed, its mixer input
+            // holds it at a fixed delay, and drift compensation matches
+            // whatever reaches the driver to the driver clock.
+            const auto driverFormat = getDefaultAudioFormat();
+            const auto guard = wiring.add(std::make_shared<DriverFormatGuard>(onError), after);
+            const auto convert = wiring.add(std::make_shared<DriverFormatChain>("convert",
+                                                                                std::uint32_t(driverFormat.channelsCount),
+                                                                                driverFormat.sampleRate),
+                                            guard);
+            wiring.add(driverStage, convert);
+        },
+        onError);
 }
@@ -2,24 +2,73 @@
 
 #include "UI_AudioLevelsIODevice.h"
 
-#include "Broadcast/BC_AudioFramesHandler.h"
+#include "AudioPipeline/AP_DriftCompensator.h"
+#include "AudioPipeline/AP_Mixer.h"
+#include "AudioPipeline/AP_ReplayCapture.h"
+#include "AudioPipeline/AP_StreamFrontEnd.h"
+#include "AudioPipeline/AP_SubmissionEngine.h"
 
 #include <Windows.h>
 
-class DriverControlFramesSender : public Broadcast::AudioFramesHandler
+#include <mutex>
+#include <vector>
+
+// The virtual microphone. Its output is submitted to the driver, through
+// drift compensation, and also metered, kept for replays and available for
+// listening. A single connected phone goes straight to it; once there are
+// several, each one is an input of a mixer that feeds it instead.
+class DriverOutput
 {
 public:
-   DriverControlFramesSender();
+   DriverOutput();
+   ~DriverOutput();
+
+   // The audio of one phone, in the driver format. Safe to call from any
+   // thread.
+   AudioPipeline::AudioSinkPtr addInput();
+   void removeInput(const AudioPipeline::AudioSinkPtr& input);
 
    AudioInfo* getAudioInfoIODevice();
+   AudioPipeline::SubmissionStats getSubmissionStats() const;
+   AudioPipeline::DriftStats getDriftStats() const;
+   // Empty while a single phone is connected.
+   AudioPipeline::MixerStats getMixerStats() const;
 
-   void onFrame(const std::uint8_t *, std::size_t len) override;
+   // The last seconds of the output, which can be saved without pausing
+   // it from any thread.
+   std::shared_ptr<AudioPipeline::ReplayCapture> getReplayCapture() const;
 
 private:
-   void onDecodedData(const std::uint8_t* buffer, std::size_t len);
+   class Input;
+
+   // Sends the inputs straight to the outputs or through the mixer,
+   // whichever their count calls for.
+   void routeInputs();
 
-private:
    HANDLE driverHandle_;
    AudioInfo audioInfo_;
+   std::shared_ptr<AudioPipeline::ReplayCapture> replay_;
+
+   // Submission to the driver, fed through the drift compensation; absent
+   // when the driver is not installed.
+   std::shared_ptr<AudioPipeline::SubmissionEngine> submission_;
+   std::shared_ptr<AudioPipeline::DriftCompensator> driftCompensator_;
+
+   std::vector<AudioPipeline::AudioSinkPtr> outputs_;
+   // All outputs as one sink, what a single phone writes to.
+   AudioPipeline::AudioSinkPtr directOutput_;
+   AudioPipeline::MixerOptions mixerOptions_;
+
+   mutable std::mutex mutex_;
+   std::vector<std::shared_ptr<Input>> inputs_;
+   // Only while several phones are connected; its thread then writes to
+   // the outputs.
+   std::unique_ptr<AudioPipeline::Mixer> mixer_;
 };
 
+// Handles the frames of one phone with the stream front end. The audio is
+// then converted to the driver format and written to the phone's input of
+// the driver output. Streams that cannot be played, e.g. without a decoder
+// or in a format the driver cannot be fed, are reported to onError.
+std::shared_ptr<AudioPipeline::StreamFrontEnd> createDriverFramesSender(AudioPipeline::AudioSinkPtr driverInput,
+                                                                        AudioPipeline::StreamFrontEnd::ErrorCallback onError);
@@ -7,8 +7,11 @@
 
 #include "Broadcast/BC_Listener.h"
 
+#include <QApplication>
 #include <QAudioFormat>
 #include <QButtonGroup>
+#include <QDateTime>
+#include <QDir>
 #include <QDialogButtonBox>
 #include <QFrame>
 #include <QFile>
@@ -18,14 +21,19 @@
 #include <QMovie>
 #include <QPainter>
 #include <QStackedLayout>
+#include <QStandardPaths>
+#include <QStringList>
 #include <QTableView>
 #include <QTimer>
 #include <QThread>
 #include <QRegExpValidator>
 #include <QVBoxLayout>
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <iostream>
+#include <thread>
 
 using VoidEvent = Broadcast::DispatchQueue::VoidEvent;
 Q_DECLARE_METATYPE(VoidEvent);
@@ -36,20 +44,33 @@ namespace UI
 namespace
 {
 constexpr QSize DefaultSize(360, 240);
+
+constexpr std::uint32_t LevelsRefreshRate = AudioInfo::DefaultLevelsRefreshRate;
+// Per refresh tick, so a peak fades out in about half a second.
+constexpr qreal LevelsDecay = 0.85;
+
+constexpr std::chrono::milliseconds StatsRefreshInterval(1000);
+
+// Errors of the listener are RTSP status codes; a stream the driver cannot
+// be fed from fails the connection as an unsupported media type.
+constexpr int UnauthorizedError = 401;
+constexpr int UnsupportedStreamError = 415;
 } // namespace
 
 class MainWindow::EventsHandlerImpl : public Broadcast::ErrorHandler
                                     , public Broadcast::SuccessHandler
 {
 public:
-    EventsHandlerImpl(MainWindow* parent)
+    EventsHandlerImpl(MainWindow* parent, Device device)
      : parent_(parent)
+     , device_(std::move(device))
     {
     }
 
     void onErrorOccured(int code, const std::string& errorMsg) override
     {
-        constexpr int UnauthorizedError = 401;
+        if (!parent_)
+            return;
 
         auto* errorDialog = new QMessageBox;
         errorDialog->setWindowFlags(errorDialog->windowFlags() & ~Qt::WindowContextHelpButtonHint);
@@ -61,31 +82,44 @@ public:
         errorDialog->addButton(QMessageBox::Close);
         errorDialog->addButton(QMessageBox::Retry);
 
-        if (code == UnauthorizedError)
+        // Retrying is about this device, whichever was connected meanwhile.
+        const bool askAuthCode = code == UnauthorizedError;
+        connect(errorDialog, &QMessageBox::accepted, parent_, [parent = parent_, device = device_, askAuthCode]()
+            {
+                if (parent)
+                    parent->retryConnect(device, askAuthCode);
+            });
+
+        if (askAuthCode)
         {
-            connect(errorDialog, &QMessageBox::accepted, parent_, &MainWindow::showAuthCodeDialog);
             errorDialog->setWindowTitle("Authentification error");
             errorDialog->setText("Wrong authentification code, try again.");
         }
+        else if (code == UnsupportedStreamError)
+        {
+            errorDialog->setWindowTitle("Unsupported stream");
+            errorDialog->setText("The device sends audio that cannot be played here.");
+        }
         else
         {
-            connect(errorDialog, &QMessageBox::accepted, parent_, &MainWindow::doConnect);
             errorDialog->setWindowTitle("Connection error");
             errorDialog->setText("An error occured during connecting to the destination host.");
         }
 
         errorDialog->open();
 
-        parent_->onConnectionRequestProcessed(false, "");
+        parent_->onConnectionRequestProcessed(false, device_);
     }
 
-    void onConnectSuccess(const std::string& ip) override
+    void onConnectSuccess(const std::string&) override
     {
-        parent_->onConnectionRequestProcessed(true, ip);
+        if (parent_)
+            parent_->onConnectionRequestProcessed(true, device_);
     }
 
    private:
     QPointer<MainWindow> parent_;
+    const Device device_;
 };
 
 class AudioFrameHandlerImpl : public Broadcast::AudioFramesHandler
@@ -202,14 +236,33 @@ protected:
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
-    , levels_(10)
 {
     setWindowTitle("MicBridge Desktop");
+
+    // Phones are mixed into the virtual microphone as they connect.
+    driverOutput_ = std::make_shared<DriverOutput>();
+    driverOutput_->getAudioInfoIODevice()->setLevelsRefreshRate(LevelsRefreshRate);
+
     doLayout();
     resize(DefaultSize);
+
+    // The audio thread publishes levels at the same rate the bar polls them.
+    levelsTimer_ = new QTimer(this);
+    levelsTimer_->setInterval(1000 / LevelsRefreshRate);
+    connect(levelsTimer_, &QTimer::timeout, this, &MainWindow::refreshDisplay);
+    levelsTimer_->start();
+
+    statsTimer_ = new QTimer(this);
+    statsTimer_->setInterval(static_cast<int>(StatsRefreshInterval.count()));
+    connect(statsTimer_, &QTimer::timeout, this, &MainWindow::refreshStats);
+    statsTimer_->start();
 }
 
-MainWindow::~MainWindow() = default;
+MainWindow::~MainWindow()
+{
+    if (replaySaver_.joinable())
+        replaySaver_.join();
+}
 
 void MainWindow::doLayout()
 {
@@ -238,31 +291,23 @@ void MainWindow::doLayout()
         connect(servicesList_, &AvailableServicesList::connectClicked, this,
             [this](std::string name, std::string ip, std::uint16_t port)
                 {
-                    activeDeviceName_ = name;
-                    destinationIp_ = std::move(ip);
-                    port_ = port;
+                    pendingDevice_ = Device();
+                    pendingDevice_.name = std::move(name);
+                    pendingDevice_.ip = std::move(ip);
+                    pendingDevice_.port = port;
                     showAuthCodeDialog();
                 });
 
         connect(servicesList_, &AvailableServicesList::disconnectClicked, this,
-            [this]()
+            [this](std::string, std::string ip, std::uint16_t port)
             {
-                listener_ = nullptr;
-                activeDeviceName_.clear();
-                destinationIp_.clear();
-                port_ = 0;
-                servicesList_->setCurrentDeviceDisconnected();
-                updateStatusWidgets();
+                removeConnection(ip, port);
             });
 
         connect(servicesList_, &AvailableServicesList::connectedDeviceLost, this,
-            [this]()
+            [this](std::string ip, std::uint16_t port)
             {
-                listener_ = nullptr;
-                activeDeviceName_.clear();
-                destinationIp_.clear();
-                port_ = 0;
-                updateStatusWidgets();
+                removeConnection(ip, port);
             });
 
         audioLevelBar_ = new AudioLevelBar(mainWidget);
@@ -286,6 +331,10 @@ void MainWindow::doLayout()
 
         mainWidgetLayout->addWidget(statusWidget);
 
+        statsLabel_ = new QLabel(mainWidget);
+        statsLabel_->setStyleSheet(" font-size: 11px; color: rgba(39, 64, 75, 160); font-weight: 400;");
+        mainWidgetLayout->addWidget(statsLabel_);
+
         updateStatusWidgets();
     }
 
@@ -310,6 +359,11 @@ void MainWindow::doLayout()
         connect(manualConnectButton, &QPushButton::clicked, this, &MainWindow::showConnectDialog);
         buttonsLayout->addWidget(manualConnectButton);
 
+        auto* saveReplayButton = new QPushButton("Save last 30 seconds", bottomButtonsFrame);
+        saveReplayButton->setStyleSheet(manualConnectButton->styleSheet());
+        connect(saveReplayButton, &QPushButton::clicked, this, &MainWindow::saveReplay);
+        buttonsLayout->addWidget(saveReplayButton);
+
         buttonsLayout->addStretch();
 
         auto* closeButton = new QPushButton("Close", bottomButtonsFrame);
@@ -333,16 +387,29 @@ QStackedLayout* MainWindow::getStackLayout()
 
 void MainWindow::updateStatusWidgets()
 {
-    if (listener_)
+    // Devices found on the network are shown by name, the others by IP.
+    QStringList devices;
+    QString lastDevice;
+    for (const auto& connection : connections_)
     {
-        if (!activeDeviceName_.empty())
+        if (!connection.isConnected)
+            continue;
+
+        if (!connection.device.name.empty())
         {
-            statusLabel_->setText("Connected to the device: " + QString::fromStdString(activeDeviceName_));
+            devices << QString::fromStdString(connection.device.name);
+            lastDevice = "Connected to the device: " + devices.back();
         }
         else
         {
-            statusLabel_->setText("Connected to the device with IP: " + QString::fromStdString(destinationIp_));
+            devices << QString::fromStdString(connection.device.ip);
+            lastDevice = "Connected to the device with IP: " + devices.back();
         }
+    }
+
+    if (!devices.isEmpty())
+    {
+        statusLabel_->setText(devices.size() == 1 ? lastDevice : "Connected to the devices: " + devices.join(", "));
 
         if (listenCheckbox_)
         {
@@ -394,7 +461,7 @@ void MainWindow::showAuthCodeDialog()
         {
             auto code = codeEditor->text();
             code.remove("-");
-            authCode_ = code.toStdString();
+            pendingDevice_.authCode = code.toStdString();
             doConnect();
         });
 
@@ -474,8 +541,9 @@ void MainWindow::showConnectDialog()
 
     connect(dialog, &QDialog::accepted, ipEditor, [this, ipEditor, portEditor]()
         {
-            destinationIp_ = ipEditor->text().toStdString();
-            port_ = portEditor->text().toUInt();
+            pendingDevice_ = Device();
+            pendingDevice_.ip = ipEditor->text().toStdString();
+            pendingDevice_.port = portEditor->text().toUInt();
             showAuthCodeDialog();
         });
 
@@ -501,23 +569,55 @@ void MainWindow::doConnect()
     loader_->play();
     setEnabled(false);
 
-    auto driverControl = std::make_shared<DriverControlFramesSender>();
-    framesSender_ = driverControl;
+    // Connecting again to a device replaces its connection.
+    removeConnection(pendingDevice_.ip, pendingDevice_.port);
 
-    connect(driverControl->getAudioInfoIODevice(), &AudioInfo::update, this, &MainWindow::refreshDisplay);
+    Connection connection;
+    connection.device = pendingDevice_;
+    connection.driverInput = driverOutput_->addInput();
 
-    auto eventsHandler = std::make_shared<EventsHandlerImpl>(this);
+    auto dispatchQueue = std::make_shared<DispatchQueueImpl>();
+    auto eventsHandler = std::make_shared<EventsHandlerImpl>(this, pendingDevice_);
 
-    listener_ = std::make_unique<Broadcast::Listener>(destinationIp_,
-                                                      port_,
-                                                      authCode_,
-                                                      std::move(driverControl),
-                                                      std::make_shared<DispatchQueueImpl>(),
-                                                      eventsHandler,
-                                                      eventsHandler);
+    // A stream that cannot be played fails the connection like the errors
+    // of the listener, on the UI thread.
+    auto onStreamError = [dispatchQueue, eventsHandler](const std::string& message) {
+        dispatchQueue->dispatchEvent([eventsHandler, message]() {
+            eventsHandler->onErrorOccured(UnsupportedStreamError, message);
+        });
+    };
+
+    auto driverControl = createDriverFramesSender(connection.driverInput, std::move(onStreamError));
+    connection.framesSender = driverControl;
+
+    // Driver submission may block, keep it off the network thread.
+    Broadcast::ListenerOptions options;
+    options.framesDelivery = Broadcast::FramesDelivery::Queued;
+    options.jitterBuffer.enabled = true;
+    options.reconnect.enabled = true;
+
+    connection.listener = std::make_unique<Broadcast::Listener>(pendingDevice_.ip,
+                                                                pendingDevice_.port,
+                                                                pendingDevice_.authCode,
+                                                                std::move(driverControl),
+                                                                std::move(dispatchQueue),
+                                                                eventsHandler,
+                                                                eventsHandler,
+                                                                options);
+    connections_.push_back(std::move(connection));
 }
 
-void MainWindow::onConnectionRequestProcessed(bool success, const std::string& ip)
+void MainWindow::retryConnect(const Device& device, bool askAuthCode)
+{
+    pendingDevice_ = device;
+
+    if (askAuthCode)
+        showAuthCodeDialog();
+    else
+        doConnect();
+}
+
+void MainWindow::onConnectionRequestProcessed(bool success, const Device& device)
 {
     getStackLayout()->setCurrentIndex(1);
     loader_->stop();
@@ -525,30 +625,49 @@ void MainWindow::onConnectionRequestProcessed(bool success, const std::string& i
 
     if (!success)
     {
-        listener_ = nullptr;
+        removeConnection(device.ip, device.port);
+        return;
     }
-    else
+
+    const auto connection = std::find_if(connections_.begin(), connections_.end(), [&device](const Connection& connection)
+        { return connection.device.ip == device.ip && connection.device.port == device.port; });
+    if (connection != connections_.end())
     {
-        servicesList_->setDeviceIsConnected(activeDeviceName_, destinationIp_, port_);
+        connection->isConnected = true;
+        servicesList_->setDeviceIsConnected(device.name, device.ip, device.port);
     }
 
     updateStatusWidgets();
 }
 
+void MainWindow::removeConnection(const std::string& ip, std::uint16_t port)
+{
+    const auto connection = std::find_if(connections_.begin(), connections_.end(), [&ip, port](const Connection& connection)
+        { return connection.device.ip == ip && connection.device.port == port; });
+    if (connection == connections_.end())
+        return;
+
+    driverOutput_->removeInput(connection->driverInput);
+    connections_.erase(connection);
+
+    servicesList_->setDeviceDisconnected(ip, port);
+    updateStatusWidgets();
+}
+
 void MainWindow::onListenDeviceChecked(bool isChecked)
 {
+    // The mix of every connected phone is played back.
+    auto* input = driverOutput_.get();
+
     if (!isChecked)
     {
         listenOutput_->stop();
         listenOutput_->reset();
         listenOutput_ = nullptr;
+        input->getAudioInfoIODevice()->stopPlayback();
         return;
     }
 
-    auto input = framesSender_.lock();
-    if (!input)
-        return;
-
     input->getAudioInfoIODevice()->open(QIODevice::ReadOnly);
     const auto srcFormat = input->getAudioInfoIODevice()->getFormat();
     QAudioFormat format;
@@ -559,8 +678,25 @@ void MainWindow::onListenDeviceChecked(bool isChecked)
     format.setByteOrder(srcFormat.isLittleEndian ? QAudioFormat::LittleEndian : QAudioFormat::BigEndian);
     format.setSampleType(srcFormat.isSigned ? QAudioFormat::SignedInt : QAudioFormat::UnSignedInt);
 
+    // Devices that do not take the stream format get it resampled to the
+    // rate and channels they prefer.
     QAudioDeviceInfo info(QAudioDeviceInfo::defaultOutputDevice());
-    if (!info.isFormatSupported(format)) {
+    if (!info.isFormatSupported(format))
+    {
+        const auto preferred = info.preferredFormat();
+        format.setSampleRate(preferred.sampleRate());
+        format.setChannelCount(preferred.channelCount());
+        format.setSampleSize(16);
+        format.setByteOrder(QAudioFormat::LittleEndian);
+        format.setSampleType(QAudioFormat::SignedInt);
+    }
+
+    const AudioInfo::AudioFormat outputFormat = {std::uint32_t(format.sampleRate()),
+                                                 std::uint8_t(format.channelCount()),
+                                                 std::uint8_t(format.sampleSize()),
+                                                 format.sampleType() == QAudioFormat::SignedInt,
+                                                 format.byteOrder() == QAudioFormat::LittleEndian};
+    if (!info.isFormatSupported(format) || !input->getAudioInfoIODevice()->startPlayback(outputFormat)) {
         std::cerr << "Raw audio format not supported by backend, cannot play audio.";
         return;
     }
@@ -569,23 +705,119 @@ void MainWindow::onListenDeviceChecked(bool isChecked)
     listenOutput_->start(input->getAudioInfoIODevice());
 }
 
-void MainWindow::refreshDisplay(qreal level)
+void MainWindow::saveReplay()
+{
+    // A save still in progress is waited for, saves are made one at a time.
+    if (replaySaver_.joinable())
+        replaySaver_.join();
+
+    // Milliseconds keep saves made in quick succession apart.
+    const auto directory = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+    const auto fileName = QString("MicBridge replay %1.wav").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd hh-mm-ss-zzz"));
+    const auto path = QDir(directory).filePath(fileName);
+
+    // The disk may be slow, keep it off the UI thread. The window joins the
+    // thread before it goes away, so the outcome can be queued to it.
+    replaySaver_ = std::thread([replay = driverOutput_->getReplayCapture(), path, this]() {
+        const bool isSaved = replay->dump(path.toStdString(), AudioPipeline::RecordingContainer::Wav);
+        QMetaObject::invokeMethod(this, [this, isSaved, path]() {
+            onReplaySaved(isSaved, path);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::onReplaySaved(bool isSaved, const QString& path)
+{
+    auto* dialog = new QMessageBox(this);
+    dialog->setWindowFlags(dialog->windowFlags() & ~Qt::WindowContextHelpButtonHint);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->addButton(QMessageBox::Close);
+
+    if (isSaved)
+    {
+        dialog->setIcon(QMessageBox::Icon::Information);
+        dialog->setWindowTitle("Replay saved");
+        dialog->setText("The last seconds of audio were saved to:\n" + QDir::toNativeSeparators(path));
+    }
+    else
+    {
+        dialog->setIcon(QMessageBox::Icon::Warning);
+        dialog->setWindowTitle("Replay not saved");
+        dialog->setText("The last seconds of audio could not be saved to:\n" + QDir::toNativeSeparators(path)
+                        + "\n\nNothing may have been received yet, or the folder is not writable.");
+    }
+
+    dialog->open();
+}
+
+void MainWindow::refreshDisplay()
 {
-  levels_[lastLevel_++] = level;
-  if (lastLevel_ == levels_.size())
+  // A window that has not been republished since the last tick means no
+  // audio is flowing, let the bar fall back to silence.
+  qreal level = 0.;
+  const auto levels = driverOutput_->getAudioInfoIODevice()->levels();
+  if (levels.sequence != lastLevelsSequence_)
   {
-    lastLevel_ = 0;
+    lastLevelsSequence_ = levels.sequence;
+    level = levels.peak;
   }
 
-  qreal sum = 0.0;
-  for (auto i = 0u; i < levels_.size(); i++){
-    sum += levels_[i];
-  }
+  displayedLevel_ = std::max(level, displayedLevel_ * LevelsDecay);
+  audioLevelBar_->setValue(static_cast<int>(displayedLevel_ * 100));
+}
+
+void MainWindow::refreshStats()
+{
+    // Silence is detected per phone, its savings are summed over all of them.
+    AudioPipeline::VoiceActivityStats voiceActivity;
+    std::uint64_t concealmentEvents = 0;
+    std::int64_t savedNs = 0;
+    for (const auto& connection : connections_)
+    {
+        const auto framesSender = connection.framesSender.lock();
+        if (!framesSender)
+            continue;
+
+        const auto stats = framesSender->voiceActivityStats();
+        voiceActivity.framesAnalyzed += stats.framesAnalyzed;
+        voiceActivity.silentFrames += stats.silentFrames;
+        concealmentEvents += framesSender->concealmentStats().concealmentEvents;
+
+        for (const auto& timing : framesSender->stageTimings())
+            savedNs += timing.silenceSavedNs();
+    }
+
+    auto text = QString("Silence %1%, %2 ms of processing saved, %3 gaps concealed")
+                    .arg(qRound(voiceActivity.silenceRatio() * 100.))
+                    .arg(double(std::max<std::int64_t>(savedNs, 0)) / 1e6, 0, 'f', 1)
+                    .arg(qulonglong(concealmentEvents));
+
+    // The mixer only runs while several phones are connected.
+    QStringList outputStats;
+    const auto mixerStats = driverOutput_->getMixerStats();
+    if (mixerStats.blocksMixed != 0)
+        outputStats << QString("mix %1% silent").arg(qRound(100. * double(mixerStats.silentBlocks) / double(mixerStats.blocksMixed)));
 
-  sum = sum / levels_.size();
+    const auto driftStats = driverOutput_->getDriftStats();
+    if (driftStats.isCompensating)
+        outputStats << QString("drift %1 ppm").arg(driftStats.driftPpm);
+
+    const auto submissionStats = driverOutput_->getSubmissionStats();
+    if (submissionStats.chunksSubmitted != 0)
+    {
+        outputStats << QString("driver latency %1 ms, %2 dropped")
+                           .arg(double(submissionStats.averageLatencyUs) / 1e3, 0, 'f', 1)
+                           .arg(qulonglong(submissionStats.chunksDropped));
+    }
+
+    if (!outputStats.isEmpty())
+    {
+        auto line = outputStats.join(", ");
+        line[0] = line[0].toUpper();
+        text += "\n" + line;
+    }
 
-  auto newValue = sum * 100;
-  audioLevelBar_->setValue(newValue);
+    statsLabel_->setText(text);
 }
 
 } // namespace UI
@@ -8,7 +8,19 @@
 #include <QProgressBar>
 #include <QPushButton>
 
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
 class QStackedLayout;
+class QTimer;
+
+namespace AudioPipeline
+{
+class AudioSink;
+class StreamFrontEnd;
+} // namespace AudioPipeline
 
 namespace Broadcast
 {
@@ -16,7 +28,7 @@ class Listener;
 } // namespace Broadcast
 
 class AudioInfo;
-class DriverControlFramesSender;
+class DriverOutput;
 
 namespace UI
 {
@@ -33,6 +45,25 @@ public:
 signals:
 
 private:
+    struct Device
+    {
+        std::string name;
+        std::string ip;
+        std::uint16_t port = 0;
+        std::string authCode;
+    };
+
+    // A phone being connected or connected, feeding one input of the driver
+    // output.
+    struct Connection
+    {
+        Device device;
+        bool isConnected = false;
+        std::shared_ptr<AudioPipeline::AudioSink> driverInput;
+        std::weak_ptr<AudioPipeline::StreamFrontEnd> framesSender;
+        std::unique_ptr<Broadcast::Listener> listener;
+    };
+
     void doLayout();
     void updateStatusWidgets();
 
@@ -42,10 +73,15 @@ private:
 
     void readMore();
     void initializeAudio();
-    void refreshDisplay(qreal level);
+    void refreshDisplay();
+    void refreshStats();
 
-    void onConnectionRequestProcessed(bool success, const std::string& ip);
+    void retryConnect(const Device& device, bool askAuthCode);
+    void onConnectionRequestProcessed(bool success, const Device& device);
+    void removeConnection(const std::string& ip, std::uint16_t port);
     void onListenDeviceChecked(bool isChecked);
+    void saveReplay();
+    void onReplaySaved(bool isSaved, const QString& path);
 
     QStackedLayout* getStackLayout();
 
@@ -53,6 +89,7 @@ private:
     QPointer<AvailableServicesList> servicesList_;
     QPointer<QProgressBar> audioLevelBar_;
     QPointer<QLabel> statusLabel_;
+    QPointer<QLabel> statsLabel_;
 
     QPointer<QCheckBox> listenCheckbox_;
     QPointer<QAudioOutput> listenOutput_;
@@ -60,15 +97,21 @@ private:
     class Loader;
     Loader* loader_;
 
-    std::string destinationIp_;
-    std::string activeDeviceName_;
-    std::string authCode_;
-    std::uint16_t port_ = 0;
-    std::unique_ptr<Broadcast::Listener> listener_;
-    std::weak_ptr<DriverControlFramesSender> framesSender_;
+    // The device the connect dialogs are about.
+    Device pendingDevice_;
+
+    // Declared before the connections, which feed it.
+    std::shared_ptr<DriverOutput> driverOutput_;
+    std::vector<Connection> connections_;
+
+    QPointer<QTimer> levelsTimer_;
+    std::uint32_t lastLevelsSequence_ = 0;
+    qreal displayedLevel_ = 0.;
+
+    QPointer<QTimer> statsTimer_;
 
-    std::vector<double> levels_;
-    std::size_t lastLevel_ = 0;
+    // Saves the replay off the UI thread; joined before the window goes.
+    std::thread replaySaver_;
 
     class EventsHandlerImpl;
 };